@@ -1,25 +1,22 @@
 #include "include/analyze.hpp"
 #include "include/error.hpp"
+#include "include/eval.hpp"
 #include "include/jane_llvm.hpp"
 #include "include/os.hpp"
 #include "include/parser.hpp"
 #include "include/semantic_info.hpp"
 #include "include/util.hpp"
 
-struct BlockContext {
-  AstNode *node;
-  BlockContext *root;
-  BlockContext *parent;
-};
+#include <errno.h>
+
+void add_node_error_code(CodeGen *g, AstNode *node, ErrorCode code,
+                         Buf *msg) {
+  err_list_add(&g->errors, code, node->owner->path, node->line, node->column,
+               node->line_end, node->column_end, msg);
+}
 
-static void add_node_error(CodeGen *g, AstNode *node, Buf *msg) {
-  g->errors.add_one();
-  ErrorMsg *last_msg = &g->errors.last();
-  last_msg->line_start = node->line;
-  last_msg->column_start = node->column;
-  last_msg->line_end = -1;
-  last_msg->column_end = -1;
-  last_msg->msg = msg;
+void add_node_error(CodeGen *g, AstNode *node, Buf *msg) {
+  add_node_error_code(g, node, ErrorCodeSemantic, msg);
 }
 
 static int parse_version_string(Buf *buf, int *major, int *minor, int *patch) {
@@ -46,15 +43,218 @@ static void set_root_export_version(CodeGen *g, Buf *version_buf,
   }
 }
 
-static void resolve_type(CodeGen *g, AstNode *node) {
+// structs, and arrays of them, keep the alignment their layout was given,
+// which `#align` can raise above the llvm abi alignment of the type
+unsigned get_type_alignment(CodeGen *g, TypeTableEntry *type) {
+  if (type->align_in_bits) {
+    return (unsigned)(type->align_in_bits / 8);
+  }
+  return LLVMABIAlignmentOfType(g->target_data_ref, type->type_ref);
+}
+
+static TypeTableEntry *get_vector_type(CodeGen *g, TypeTableEntry *child_type,
+                                       int len) {
+  Buf *name = buf_sprintf("vector(%d, %s)", len, buf_ptr(&child_type->name));
+  auto existing_entry = g->type_table.maybe_get(name);
+  if (existing_entry) {
+    return existing_entry->value;
+  }
+  TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+  entry->id = TypeTableEntryIdVector;
+  entry->type_ref = LLVMVectorType(child_type->type_ref, len);
+  entry->size_in_bits = child_type->size_in_bits * len;
+  entry->vector_child = child_type;
+  entry->vector_len = len;
+  buf_init_from_buf(&entry->name, name);
+  entry->di_type = LLVMJaneCreateDebugVectorType(
+      g->dbuilder, LLVMSizeOfTypeInBits(g->target_data_ref, entry->type_ref),
+      LLVMABIAlignmentOfType(g->target_data_ref, entry->type_ref) * 8,
+      child_type->di_type, len);
+  g->type_table.put(&entry->name, entry);
+  return entry;
+}
+
+static TypeTableEntry *get_pointer_to_type(CodeGen *g,
+                                           TypeTableEntry *child_type,
+                                           bool is_const) {
+  TypeTableEntry **parent_pointer = is_const ? &child_type->pointer_const_parent
+                                             : &child_type->pointer_mut_parent;
+  if (*parent_pointer) {
+    return *parent_pointer;
+  }
+  const char *const_or_mut_str = is_const ? "const" : "mut";
+  TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+  entry->id = TypeTableEntryIdPointer;
+  entry->type_ref = LLVMPointerType(child_type->type_ref, 0);
+  entry->size_in_bits = g->pointer_size_bytes * 8;
+  entry->pointer_child = child_type;
+  entry->pointer_is_const = is_const;
+  buf_resize(&entry->name, 0);
+  buf_appendf(&entry->name, "*%s %s", const_or_mut_str,
+              buf_ptr(&child_type->name));
+  entry->di_type = LLVMJaneCreateDebugPointerType(
+      g->dbuilder, child_type->di_type, g->pointer_size_bytes * 8,
+      g->pointer_size_bytes * 8, buf_ptr(&entry->name));
+  g->type_table.put(&entry->name, entry);
+  *parent_pointer = entry;
+  return entry;
+}
+
+static TypeTableEntry *get_array_type(CodeGen *g, TypeTableEntry *child_type,
+                                      uint64_t array_len) {
+  Buf *name = buf_sprintf("[%llu]%s", (unsigned long long)array_len,
+                          buf_ptr(&child_type->name));
+  auto existing_entry = g->type_table.maybe_get(name);
+  if (existing_entry) {
+    return existing_entry->value;
+  }
+  TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+  entry->id = TypeTableEntryIdArray;
+  entry->type_ref = LLVMArrayType(child_type->type_ref, (unsigned)array_len);
+  entry->size_in_bits =
+      LLVMABISizeOfType(g->target_data_ref, entry->type_ref) * 8;
+  entry->array_child = child_type;
+  entry->array_len = array_len;
+  // an over-aligned struct keeps its alignment as an element
+  entry->align_in_bits = child_type->align_in_bits;
+  buf_init_from_buf(&entry->name, name);
+  uint64_t align_in_bits =
+      entry->align_in_bits
+          ? entry->align_in_bits
+          : LLVMABIAlignmentOfType(g->target_data_ref, entry->type_ref) * 8;
+  entry->di_type =
+      LLVMJaneCreateDebugArrayType(g->dbuilder, entry->size_in_bits,
+                                   align_in_bits, child_type->di_type,
+                                   (int)array_len);
+  g->type_table.put(&entry->name, entry);
+  return entry;
+}
+
+static TypeTableEntry *get_slice_type(CodeGen *g, TypeTableEntry *child_type,
+                                      bool is_const) {
+  Buf *name = buf_sprintf("[]%s %s", is_const ? "const" : "mut",
+                          buf_ptr(&child_type->name));
+  auto existing_entry = g->type_table.maybe_get(name);
+  if (existing_entry) {
+    return existing_entry->value;
+  }
+  TypeTableEntry *ptr_type = get_pointer_to_type(g, child_type, is_const);
+  TypeTableEntry *len_type = g->builtin_types.entry_usize;
+  TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+  entry->id = TypeTableEntryIdSlice;
+  LLVMTypeRef element_types[] = {ptr_type->type_ref, len_type->type_ref};
+  entry->type_ref = LLVMStructType(element_types, 2, false);
+  entry->size_in_bits =
+      LLVMABISizeOfType(g->target_data_ref, entry->type_ref) * 8;
+  buf_init_from_buf(&entry->name, name);
+  entry->struct_field_count = 2;
+  entry->struct_fields = allocate<TypeStructField>(2);
+  entry->struct_fields[0].name = buf_create_from_str("ptr");
+  entry->struct_fields[0].type_entry = ptr_type;
+  entry->struct_fields[0].gen_index = 0;
+  entry->struct_fields[1].name = buf_create_from_str("len");
+  entry->struct_fields[1].type_entry = len_type;
+  entry->struct_fields[1].gen_index = 1;
+  entry->struct_complete = true;
+
+  LLVMJaneDIType *fwd_di_type = LLVMJaneCreateReplaceableCompositeType(
+      g->dbuilder, LLVMJaneTag_DW_structure_type(), buf_ptr(name), nullptr,
+      nullptr, 0);
+  LLVMJaneDIType *di_members[2];
+  for (int i = 0; i < 2; i += 1) {
+    TypeStructField *field = &entry->struct_fields[i];
+    di_members[i] = LLVMJaneCreateDebugMemberType(
+        g->dbuilder, LLVMJaneTypeToScope(fwd_di_type), buf_ptr(field->name),
+        nullptr, 0, field->type_entry->size_in_bits, 0,
+        LLVMOffsetOfElement(g->target_data_ref, entry->type_ref, i) * 8, 0,
+        field->type_entry->di_type);
+  }
+  entry->di_type = LLVMJaneCreateDebugStructType(
+      g->dbuilder, nullptr, buf_ptr(name), nullptr, 0, entry->size_in_bits,
+      LLVMABIAlignmentOfType(g->target_data_ref, entry->type_ref) * 8, 0,
+      di_members, 2);
+  LLVMJaneReplaceTemporary(g->dbuilder, fwd_di_type, entry->di_type);
+  g->type_table.put(&entry->name, entry);
+  return entry;
+}
+
+static void resolve_struct_type(CodeGen *g, TypeTableEntry *struct_type);
+
+// a number literal, or the name of a global integer constant
+static bool resolve_array_len(CodeGen *g, AstNode *len_node, uint64_t *len) {
+  if (len_node->type == NodeTypeNumberLiteral) {
+    Buf *len_str = &len_node->data.number;
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long value = strtoull(buf_ptr(len_str), &end, 10);
+    if (*end != 0 || errno == ERANGE || value > 0xffffffffULL) {
+      add_node_error(g, len_node, buf_sprintf("invalid array length `%s`",
+                                              buf_ptr(len_str)));
+      return false;
+    }
+    *len = value;
+    return true;
+  }
+  assert(len_node->type == NodeTypeSymbol);
+  Buf *name = &len_node->data.symbol;
+  auto entry = g->global_const_table.maybe_get(name);
+  if (!entry) {
+    add_node_error(g, len_node, buf_sprintf("use of undeclared constant `%s`",
+                                            buf_ptr(name)));
+    return false;
+  }
+  GlobalConstEntry *global_const = entry->value;
+  resolve_global_const(g, global_const);
+  if (global_const->type->id == TypeTableEntryIdInvalid) {
+    return false;
+  } else if (global_const->type->id != TypeTableEntryIdInt) {
+    add_node_error(g, len_node,
+                   buf_sprintf("array length must be an integer, got `%s`",
+                               buf_ptr(&global_const->type->name)));
+    return false;
+  }
+  ConstExprValue *value = eval_global_const(g, global_const);
+  if (!value) {
+    return false;
+  }
+  if ((global_const->type->is_signed && (int64_t)value->x_int < 0) ||
+      value->x_int > 0xffffffffULL) {
+    add_node_error(g, len_node,
+                   buf_sprintf("invalid array length %lld",
+                               (long long)value->x_int));
+    return false;
+  }
+  *len = value->x_int;
+  return true;
+}
+
+// index of the type parameter of a generic function named `name`, or -1
+static int find_generic_param(AstNodeFnProto *fn_proto, Buf *name) {
+  for (int i = 0; i < fn_proto->generic_params.length; i += 1) {
+    if (buf_eql_buf(&fn_proto->generic_params.at(i)->data.symbol, name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// when `fn_entry` is an instance of a generic function, its type parameters
+// are in scope
+static void resolve_type(CodeGen *g, AstNode *node, FnTableEntry *fn_entry) {
   assert(!node->codegen_node);
   node->codegen_node = allocate<CodeGenNode>(1);
   TypeNode *type_node = &node->codegen_node->data.type_node;
   switch (node->data.type.type) {
   case AstNodeTypeTypePrimitive: {
     Buf *name = &node->data.type.primitive_name;
+    int generic_index =
+        fn_entry && fn_entry->generic_args
+            ? find_generic_param(&fn_entry->proto_node->data.fn_proto, name)
+            : -1;
     auto table_entry = g->type_table.maybe_get(name);
-    if (table_entry) {
+    if (generic_index >= 0) {
+      type_node->entry = fn_entry->generic_args[generic_index];
+    } else if (table_entry) {
       type_node->entry = table_entry->value;
     } else {
       add_node_error(g, node,
@@ -64,52 +264,542 @@ static void resolve_type(CodeGen *g, AstNode *node) {
     break;
   }
   case AstNodeTypeTypePointer: {
-    resolve_type(g, node->data.type.child_type);
+    resolve_type(g, node->data.type.child_type, fn_entry);
     TypeNode *child_type_node =
         &node->data.type.child_type->codegen_node->data.type_node;
     if (child_type_node->entry == g->builtin_types.entry_unreachable) {
       add_node_error(g, node,
                      buf_create_from_str("pointer to unreachable not allowed"));
     }
-    TypeTableEntry **parent_pointer =
-        node->data.type.is_const ? &child_type_node->entry->pointer_const_parent
-                                 : &child_type_node->entry->pointer_mut_parent;
-    const char *const_or_mut_str = node->data.type.is_const ? "const" : "mut";
-    if (*parent_pointer) {
-      type_node->entry = *parent_pointer;
+    type_node->entry = get_pointer_to_type(g, child_type_node->entry,
+                                           node->data.type.is_const);
+    break;
+  }
+  case AstNodeTypeTypeArray:
+  case AstNodeTypeTypeSlice: {
+    resolve_type(g, node->data.type.child_type, fn_entry);
+    TypeTableEntry *child_type =
+        node->data.type.child_type->codegen_node->data.type_node.entry;
+    type_node->entry = g->builtin_types.entry_invalid;
+    if (child_type->id == TypeTableEntryIdStruct) {
+      // the element size must be known
+      resolve_struct_type(g, child_type);
+    }
+    if (child_type->id == TypeTableEntryIdInvalid ||
+        (child_type->id == TypeTableEntryIdStruct &&
+         (child_type->struct_is_invalid || !child_type->struct_complete))) {
+      break;
+    } else if (child_type->id == TypeTableEntryIdVoid ||
+               child_type->id == TypeTableEntryIdUnreachable) {
+      add_node_error(g, node,
+                     buf_sprintf("%s of `%s` not allowed",
+                                 node->data.type.type == AstNodeTypeTypeArray
+                                     ? "array"
+                                     : "slice",
+                                 buf_ptr(&child_type->name)));
+      break;
+    }
+    if (node->data.type.type == AstNodeTypeTypeSlice) {
+      type_node->entry =
+          get_slice_type(g, child_type, node->data.type.is_const);
+      break;
+    }
+    uint64_t len;
+    if (resolve_array_len(g, node->data.type.len, &len)) {
+      type_node->entry = get_array_type(g, child_type, len);
+    }
+    break;
+  }
+  case AstNodeTypeTypeVector: {
+    resolve_type(g, node->data.type.child_type, fn_entry);
+    TypeTableEntry *child_type =
+        node->data.type.child_type->codegen_node->data.type_node.entry;
+    Buf *len_str = &node->data.type.len->data.number;
+    char *end = nullptr;
+    long len = strtol(buf_ptr(len_str), &end, 10);
+    type_node->entry = g->builtin_types.entry_invalid;
+    if (child_type->id == TypeTableEntryIdInvalid) {
+      break;
+    } else if (child_type->id != TypeTableEntryIdInt &&
+               child_type->id != TypeTableEntryIdFloat &&
+               child_type->id != TypeTableEntryIdBool) {
+      add_node_error(g, node,
+                     buf_sprintf("vector element type must be an integer, "
+                                 "float or bool, got `%s`",
+                                 buf_ptr(&child_type->name)));
+    } else if (*end != 0 || len <= 0 || len > 65536) {
+      add_node_error(g, node->data.type.len,
+                     buf_sprintf("invalid vector length `%s`",
+                                 buf_ptr(len_str)));
     } else {
-      TypeTableEntry *entry = allocate<TypeTableEntry>(1);
-      entry->type_ref = LLVMPointerType(child_type_node->entry->type_ref, 0);
-      buf_resize(&entry->name, 0);
-      buf_appendf(&entry->name, "*%s %s", const_or_mut_str,
-                  buf_ptr(&child_type_node->entry->name));
-      entry->di_type = LLVMJaneCreateDebugPointerType(
-          g->dbuilder, child_type_node->entry->di_type,
-          g->pointer_size_bytes * 8, g->pointer_size_bytes * 8,
-          buf_ptr(&entry->name));
-      g->type_table.put(&entry->name, entry);
-      type_node->entry = entry;
-      *parent_pointer = entry;
+      type_node->entry = get_vector_type(g, child_type, (int)len);
     }
     break;
   }
   }
 }
 
-static void resolve_function_proto(CodeGen *g, AstNode *node) {
+static bool directive_has_param(CodeGen *g, AstNode *directive_node,
+                                bool param_expected) {
+  Buf *name = &directive_node->data.directive.name;
+  bool has_param = buf_len(&directive_node->data.directive.param) > 0;
+  if (has_param && !param_expected) {
+    add_node_error(g, directive_node,
+                   buf_sprintf("directive `%s` takes no parameter",
+                               buf_ptr(name)));
+    return false;
+  } else if (!has_param && param_expected) {
+    add_node_error(g, directive_node,
+                   buf_sprintf("directive `%s` requires a parameter",
+                               buf_ptr(name)));
+    return false;
+  }
+  return true;
+}
+
+static bool parse_alignment(CodeGen *g, AstNode *directive_node,
+                            uint64_t *alignment) {
+  Buf *param = &directive_node->data.directive.param;
+  char *end = nullptr;
+  long value = strtol(buf_ptr(param), &end, 10);
+  if (*end != 0 || value <= 0 || (value & (value - 1)) != 0) {
+    add_node_error(g, directive_node,
+                   buf_sprintf("alignment must be a power of two, got `%s`",
+                               buf_ptr(param)));
+    return false;
+  }
+  *alignment = (uint64_t)value;
+  return true;
+}
+
+static void resolve_fn_directive(CodeGen *g, AstNode *directive_node,
+                                 FnTableEntry *fn_table_entry) {
+  static const char *fn_directive_names[] = {
+      "inline", "noinline", "hot", "cold", "optsize", "align", "callconv",
+  };
+  Buf *name = &directive_node->data.directive.name;
+  bool known = false;
+  for (int i = 0; i < array_length(fn_directive_names); i += 1) {
+    known = known || buf_eql_str(name, fn_directive_names[i]);
+  }
+  if (!known) {
+    add_node_error(g, directive_node,
+                   buf_sprintf("invalid directive: `%s`", buf_ptr(name)));
+    return;
+  }
+  bool param_expected =
+      buf_eql_str(name, "align") || buf_eql_str(name, "callconv");
+  if (!directive_has_param(g, directive_node, param_expected)) {
+    return;
+  }
+  bool extern_allowed = false;
+  if (buf_eql_str(name, "inline") || buf_eql_str(name, "noinline")) {
+    FnInline fn_inline =
+        buf_eql_str(name, "inline") ? FnInlineAlways : FnInlineNever;
+    if (fn_table_entry->fn_inline != FnInlineAuto &&
+        fn_table_entry->fn_inline != fn_inline) {
+      add_node_error(g, directive_node,
+                     buf_sprintf("function cannot be both inline and noinline"));
+    }
+    fn_table_entry->fn_inline = fn_inline;
+  } else if (buf_eql_str(name, "hot") || buf_eql_str(name, "cold")) {
+    bool is_hot = buf_eql_str(name, "hot");
+    if ((is_hot && fn_table_entry->is_cold) ||
+        (!is_hot && fn_table_entry->is_hot)) {
+      add_node_error(g, directive_node,
+                     buf_sprintf("function cannot be both hot and cold"));
+    }
+    fn_table_entry->is_hot = is_hot;
+    fn_table_entry->is_cold = !is_hot;
+    extern_allowed = true;
+  } else if (buf_eql_str(name, "optsize")) {
+    fn_table_entry->is_optsize = true;
+  } else if (buf_eql_str(name, "callconv")) {
+    static const struct {
+      const char *name;
+      LLVMCallConv calling_convention;
+    } calling_conventions[] = {
+        {"c", LLVMCCallConv},
+        {"fast", LLVMFastCallConv},
+        {"cold", LLVMColdCallConv},
+        {"preserve_most", LLVMPreserveMostCallConv},
+    };
+    Buf *param = &directive_node->data.directive.param;
+    bool found = false;
+    for (int i = 0; i < array_length(calling_conventions); i += 1) {
+      if (buf_eql_str(param, calling_conventions[i].name)) {
+        fn_table_entry->calling_convention =
+            calling_conventions[i].calling_convention;
+        found = true;
+      }
+    }
+    if (!found) {
+      add_node_error(g, directive_node,
+                     buf_sprintf("unknown calling convention `%s`",
+                                 buf_ptr(param)));
+    } else if (!fn_table_entry->internal_linkage &&
+               !fn_table_entry->is_extern &&
+               fn_table_entry->calling_convention != LLVMCCallConv) {
+      // the generated header declares exported functions with the C
+      // calling convention
+      add_node_error(g, directive_node,
+                     buf_sprintf("calling convention `%s` not allowed on a "
+                                 "function with C linkage",
+                                 buf_ptr(param)));
+    }
+    extern_allowed = true;
+  } else {
+    assert(buf_eql_str(name, "align"));
+    uint64_t alignment;
+    if (!parse_alignment(g, directive_node, &alignment)) {
+      return;
+    }
+    fn_table_entry->alignment = (unsigned)alignment;
+  }
+  if (fn_table_entry->is_extern && !extern_allowed) {
+    add_node_error(g, directive_node,
+                   buf_sprintf("directive `%s` not allowed on extern function",
+                               buf_ptr(name)));
+  }
+}
+
+// llvm passes aggregates differently from the C abi, so functions visible to
+// C take structs, arrays and slices by pointer only. C has no vector or slice
+// types, so those are not allowed at all, even behind pointers or arrays.
+static void check_c_abi_type(CodeGen *g, AstNode *type_node,
+                             FnTableEntry *fn_table_entry) {
+  if (fn_table_entry->internal_linkage) {
+    return;
+  }
+  TypeTableEntry *type = type_node->codegen_node->data.type_node.entry;
+  if (type->id == TypeTableEntryIdStruct ||
+      type->id == TypeTableEntryIdArray ||
+      type->id == TypeTableEntryIdSlice) {
+    add_node_error(g, type_node,
+                   buf_sprintf("`%s` cannot be passed by value to or from a "
+                               "function with C linkage",
+                               buf_ptr(&type->name)));
+    return;
+  }
+  TypeTableEntry *pointee = type;
+  while (pointee->id == TypeTableEntryIdPointer ||
+         pointee->id == TypeTableEntryIdArray) {
+    pointee = pointee->id == TypeTableEntryIdPointer ? pointee->pointer_child
+                                                     : pointee->array_child;
+  }
+  if (pointee->id == TypeTableEntryIdVector ||
+      pointee->id == TypeTableEntryIdSlice) {
+    add_node_error(g, type_node,
+                   buf_sprintf("`%s` has no C equivalent and cannot be used "
+                               "by a function with C linkage",
+                               buf_ptr(&type->name)));
+  }
+}
+
+static void resolve_function_proto(CodeGen *g, AstNode *node,
+                                   FnTableEntry *fn_table_entry) {
   assert(node->type == NodeTypeFnProto);
   for (int i = 0; i < node->data.fn_proto.directives->length; i += 1) {
     AstNode *directive_node = node->data.fn_proto.directives->at(i);
-    Buf *name = &directive_node->data.directive.name;
-    add_node_error(g, directive_node,
-                   buf_sprintf("invalid directive: `%s`", buf_ptr(name)));
+    resolve_fn_directive(g, directive_node, fn_table_entry);
   }
   for (int i = 0; i < node->data.fn_proto.params.length; i += 1) {
     AstNode *child = node->data.fn_proto.params.at(i);
     assert(child->type == NodeTypeParamDecl);
-    resolve_type(g, child->data.param_decl.type);
+    resolve_type(g, child->data.param_decl.type, fn_table_entry);
+    check_c_abi_type(g, child->data.param_decl.type, fn_table_entry);
+    TypeTableEntry *param_type =
+        child->data.param_decl.type->codegen_node->data.type_node.entry;
+    if (child->data.param_decl.is_noalias &&
+        param_type->id != TypeTableEntryIdPointer &&
+        param_type->id != TypeTableEntryIdInvalid) {
+      add_node_error(g, child,
+                     buf_sprintf("noalias parameter `%s` must be a pointer",
+                                 buf_ptr(&child->data.param_decl.name)));
+    }
+  }
+  resolve_type(g, node->data.fn_proto.return_type, fn_table_entry);
+  check_c_abi_type(g, node->data.fn_proto.return_type, fn_table_entry);
+}
+
+static void preview_struct_declaration(CodeGen *g, ImportTableEntry *import,
+                                       AstNode *node) {
+  assert(node->type == NodeTypeStructDecl);
+  Buf *name = &node->data.struct_decl.name;
+  if (g->type_table.maybe_get(name)) {
+    add_node_error(g, node,
+                   buf_sprintf("redefinition of `%s`", buf_ptr(name)));
+    return;
+  }
+  TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+  entry->id = TypeTableEntryIdStruct;
+  entry->type_ref =
+      LLVMStructCreateNamed(LLVMGetGlobalContext(), buf_ptr(name));
+  entry->struct_decl_node = node;
+  entry->struct_import = import;
+  buf_init_from_buf(&entry->name, name);
+  // pointers to the struct may be created before its fields are known, so
+  // debug info starts as a forward declaration
+  entry->di_type = LLVMJaneCreateReplaceableCompositeType(
+      g->dbuilder, LLVMJaneTag_DW_structure_type(), buf_ptr(name),
+      LLVMJaneFileToScope(import->di_file), import->di_file, node->line + 1);
+  g->type_table.put(&entry->name, entry);
+  g->struct_types.append(entry);
+}
+
+static void resolve_struct_directives(CodeGen *g, TypeTableEntry *struct_type,
+                                      uint64_t *explicit_align,
+                                      bool *reorder) {
+  AstNode *decl_node = struct_type->struct_decl_node;
+  JaneList<AstNode *> *directives = decl_node->data.struct_decl.directives;
+  for (int i = 0; i < directives->length; i += 1) {
+    AstNode *directive_node = directives->at(i);
+    Buf *name = &directive_node->data.directive.name;
+    if (!buf_eql_str(name, "packed") && !buf_eql_str(name, "align") &&
+        !buf_eql_str(name, "reorder")) {
+      add_node_error(g, directive_node,
+                     buf_sprintf("invalid directive: `%s`", buf_ptr(name)));
+      continue;
+    }
+    bool param_expected = buf_eql_str(name, "align");
+    if (!directive_has_param(g, directive_node, param_expected)) {
+      continue;
+    }
+    if (buf_eql_str(name, "packed")) {
+      struct_type->struct_is_packed = true;
+    } else if (buf_eql_str(name, "reorder")) {
+      *reorder = true;
+    } else {
+      parse_alignment(g, directive_node, explicit_align);
+    }
+  }
+  if (*reorder && struct_type->struct_is_packed) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("`#reorder` has no effect on a packed struct"));
+    *reorder = false;
+  }
+}
+
+static void resolve_struct_type(CodeGen *g, TypeTableEntry *struct_type) {
+  if (struct_type->struct_complete) {
+    return;
+  }
+  AstNode *decl_node = struct_type->struct_decl_node;
+  if (struct_type->struct_embedded_in_current) {
+    if (!struct_type->struct_is_invalid) {
+      struct_type->struct_is_invalid = true;
+      add_node_error(g, decl_node,
+                     buf_sprintf("struct `%s` contains itself",
+                                 buf_ptr(&struct_type->name)));
+    }
+    return;
+  }
+  struct_type->struct_embedded_in_current = true;
+
+  uint64_t explicit_align = 0;
+  bool reorder = false;
+  resolve_struct_directives(g, struct_type, &explicit_align, &reorder);
+
+  JaneList<AstNode *> *field_nodes = &decl_node->data.struct_decl.fields;
+  int field_count = field_nodes->length;
+  struct_type->struct_fields = allocate<TypeStructField>(field_count);
+  struct_type->struct_field_count = field_count;
+  for (int i = 0; i < field_count; i += 1) {
+    AstNode *field_node = field_nodes->at(i);
+    TypeStructField *field = &struct_type->struct_fields[i];
+    field->name = &field_node->data.struct_field.name;
+    field->decl_node = field_node;
+    resolve_type(g, field_node->data.struct_field.type, nullptr);
+    TypeTableEntry *field_type =
+        field_node->data.struct_field.type->codegen_node->data.type_node.entry;
+    if (field_type->id == TypeTableEntryIdStruct) {
+      resolve_struct_type(g, field_type);
+    }
+    field->type_entry = field_type;
+    if (field_type->id == TypeTableEntryIdInvalid ||
+        (field_type->id == TypeTableEntryIdStruct &&
+         field_type->struct_is_invalid)) {
+      struct_type->struct_is_invalid = true;
+    } else if (field_type->id == TypeTableEntryIdVoid ||
+               field_type->id == TypeTableEntryIdUnreachable) {
+      add_node_error(g, field_node,
+                     buf_sprintf("field `%s` has invalid type `%s`",
+                                 buf_ptr(field->name),
+                                 buf_ptr(&field_type->name)));
+      struct_type->struct_is_invalid = true;
+    }
+    for (int j = 0; j < i; j += 1) {
+      if (buf_eql_buf(field->name, struct_type->struct_fields[j].name)) {
+        add_node_error(g, field_node,
+                       buf_sprintf("duplicate field `%s`",
+                                   buf_ptr(field->name)));
+      }
+    }
+  }
+  struct_type->struct_embedded_in_current = false;
+  struct_type->struct_complete = true;
+  if (struct_type->struct_is_invalid) {
+    return;
+  }
+
+  int *gen_order = allocate<int>(field_count);
+  for (int i = 0; i < field_count; i += 1) {
+    gen_order[i] = i;
+  }
+  if (reorder) {
+    // decreasing alignment leaves no padding between fields. insertion sort
+    // keeps declaration order among fields of equal alignment.
+    unsigned *field_align = allocate<unsigned>(field_count);
+    for (int i = 0; i < field_count; i += 1) {
+      TypeTableEntry *field_type = struct_type->struct_fields[i].type_entry;
+      field_align[i] = get_type_alignment(g, field_type);
+    }
+    for (int i = 1; i < field_count; i += 1) {
+      int field_i = gen_order[i];
+      int j = i;
+      while (j > 0 && field_align[gen_order[j - 1]] < field_align[field_i]) {
+        gen_order[j] = gen_order[j - 1];
+        j -= 1;
+      }
+      gen_order[j] = field_i;
+    }
+    deallocate(field_align, field_count);
+  }
+
+  bool is_packed = struct_type->struct_is_packed;
+  // llvm places each field at its abi alignment only, so a field whose type
+  // is over-aligned gets explicit i8 padding in front of it
+  LLVMTypeRef *element_types = allocate<LLVMTypeRef>(field_count * 2 + 1);
+  int element_count = 0;
+  uint64_t offset = 0;
+  uint64_t natural_align = 1;
+  for (int gen_i = 0; gen_i < field_count; gen_i += 1) {
+    TypeStructField *field = &struct_type->struct_fields[gen_order[gen_i]];
+    LLVMTypeRef field_type_ref = field->type_entry->type_ref;
+    if (!is_packed) {
+      uint64_t abi_align =
+          LLVMABIAlignmentOfType(g->target_data_ref, field_type_ref);
+      uint64_t field_align = get_type_alignment(g, field->type_entry);
+      offset = (offset + abi_align - 1) / abi_align * abi_align;
+      uint64_t field_offset =
+          (offset + field_align - 1) / field_align * field_align;
+      if (field_offset > offset) {
+        element_types[element_count] =
+            LLVMArrayType(LLVMInt8Type(), (unsigned)(field_offset - offset));
+        element_count += 1;
+        offset = field_offset;
+      }
+      if (field_align > natural_align) {
+        natural_align = field_align;
+      }
+    }
+    field->gen_index = element_count;
+    element_types[element_count] = field_type_ref;
+    element_count += 1;
+    offset += LLVMABISizeOfType(g->target_data_ref, field_type_ref);
+  }
+  LLVMTypeRef layout_type =
+      LLVMStructType(element_types, element_count, is_packed);
+  uint64_t layout_align =
+      LLVMABIAlignmentOfType(g->target_data_ref, layout_type);
+  if (layout_align > natural_align) {
+    natural_align = layout_align;
+  }
+  if (explicit_align != 0 && explicit_align < natural_align) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("alignment %d is less than the natural "
+                               "alignment %d of `%s`; use `#packed`",
+                               (int)explicit_align, (int)natural_align,
+                               buf_ptr(&struct_type->name)));
+  }
+  uint64_t align =
+      explicit_align > natural_align ? explicit_align : natural_align;
+  if (align > layout_align) {
+    // tail padding so that consecutive elements of an array stay aligned
+    uint64_t size = LLVMABISizeOfType(g->target_data_ref, layout_type);
+    uint64_t padded_size = (size + align - 1) / align * align;
+    if (padded_size > size) {
+      element_types[element_count] =
+          LLVMArrayType(LLVMInt8Type(), (unsigned)(padded_size - size));
+      element_count += 1;
+    }
+  }
+  LLVMStructSetBody(struct_type->type_ref, element_types, element_count,
+                    is_packed);
+  deallocate(element_types, field_count * 2 + 1);
+  struct_type->align_in_bits = align * 8;
+  struct_type->size_in_bits =
+      LLVMABISizeOfType(g->target_data_ref, struct_type->type_ref) * 8;
+
+  ImportTableEntry *import = struct_type->struct_import;
+  LLVMJaneDIType **di_members = allocate<LLVMJaneDIType *>(field_count);
+  for (int gen_i = 0; gen_i < field_count; gen_i += 1) {
+    TypeStructField *field = &struct_type->struct_fields[gen_order[gen_i]];
+    TypeTableEntry *field_type = field->type_entry;
+    di_members[gen_i] = LLVMJaneCreateDebugMemberType(
+        g->dbuilder, LLVMJaneTypeToScope(struct_type->di_type),
+        buf_ptr(field->name), import->di_file, field->decl_node->line + 1,
+        LLVMABISizeOfType(g->target_data_ref, field_type->type_ref) * 8, 0,
+        LLVMOffsetOfElement(g->target_data_ref, struct_type->type_ref,
+                            field->gen_index) *
+            8,
+        0, field_type->di_type);
+  }
+  LLVMJaneDIType *di_type = LLVMJaneCreateDebugStructType(
+      g->dbuilder, LLVMJaneFileToScope(import->di_file),
+      buf_ptr(&struct_type->name), import->di_file, decl_node->line + 1,
+      struct_type->size_in_bits, struct_type->align_in_bits, 0, di_members,
+      field_count);
+  deallocate(di_members, field_count);
+  deallocate(gen_order, field_count);
+  LLVMJaneReplaceTemporary(g->dbuilder, struct_type->di_type, di_type);
+  struct_type->di_type = di_type;
+}
+
+static bool type_mentions_name(AstNode *type_node, Buf *name) {
+  switch (type_node->data.type.type) {
+  case AstNodeTypeTypePrimitive:
+    return buf_eql_buf(&type_node->data.type.primitive_name, name);
+  case AstNodeTypeTypePointer:
+  case AstNodeTypeTypeVector:
+  case AstNodeTypeTypeArray:
+  case AstNodeTypeTypeSlice:
+    return type_mentions_name(type_node->data.type.child_type, name);
+  }
+  jane_unreachable();
+}
+
+// type arguments are inferred from the arguments of each call, so every type
+// parameter has to appear in a parameter type
+static void check_generic_params(CodeGen *g, FnTableEntry *fn_table_entry) {
+  AstNode *proto_node = fn_table_entry->proto_node;
+  AstNodeFnProto *fn_proto = &proto_node->data.fn_proto;
+  if (fn_proto->visib_mod == FnProtoVisibModExport) {
+    add_node_error(g, proto_node,
+                   buf_sprintf("exported function `%s` cannot be generic",
+                               buf_ptr(&fn_proto->name)));
+  }
+  for (int i = 0; i < fn_proto->generic_params.length; i += 1) {
+    AstNode *generic_param = fn_proto->generic_params.at(i);
+    Buf *name = &generic_param->data.symbol;
+    if (find_generic_param(fn_proto, name) != i) {
+      add_node_error(g, generic_param,
+                     buf_sprintf("redeclaration of type parameter `%s`",
+                                 buf_ptr(name)));
+      continue;
+    }
+    bool used = false;
+    for (int param_i = 0; param_i < fn_proto->params.length; param_i += 1) {
+      AstNode *param_node = fn_proto->params.at(param_i);
+      used = used || type_mentions_name(param_node->data.param_decl.type, name);
+    }
+    if (!used) {
+      add_node_error(g, generic_param,
+                     buf_sprintf("type parameter `%s` must appear in a "
+                                 "parameter type of `%s`",
+                                 buf_ptr(name), buf_ptr(&fn_proto->name)));
+    }
   }
-  resolve_type(g, node->data.fn_proto.return_type);
 }
 
 static void preview_function_declarations(CodeGen *g, ImportTableEntry *import,
@@ -121,7 +811,10 @@ static void preview_function_declarations(CodeGen *g, ImportTableEntry *import,
       Buf *name = &directive_node->data.directive.name;
       Buf *param = &directive_node->data.directive.param;
       if (buf_eql_str(name, "link")) {
-        g->link_table.put(param, true);
+        if (!g->link_table.maybe_get(param)) {
+          g->link_table.put(param, true);
+          g->link_libs.append(param);
+        }
       } else {
         add_node_error(g, directive_node,
                        buf_sprintf("invalid directive: `%s`", buf_ptr(name)));
@@ -132,16 +825,22 @@ static void preview_function_declarations(CodeGen *g, ImportTableEntry *import,
       AstNode *fn_decl = node->data.extern_block.fn_decls.at(fn_decl_i);
       assert(fn_decl->type == NodeTypeFnDecl);
       AstNode *fn_proto = fn_decl->data.fn_decl.fn_proto;
-      resolve_function_proto(g, fn_proto);
       Buf *name = &fn_proto->data.fn_proto.name;
+      if (fn_proto->data.fn_proto.generic_params.length > 0) {
+        add_node_error(g, fn_proto,
+                       buf_sprintf("extern function `%s` cannot be generic",
+                                   buf_ptr(name)));
+      }
 
       FnTableEntry *fn_table_entry = allocate<FnTableEntry>(1);
       fn_table_entry->import_entry = import;
       fn_table_entry->proto_node = fn_proto;
       fn_table_entry->is_extern = true;
       fn_table_entry->calling_convention = LLVMCCallConv;
-      fn_table_entry->import_entry = import;
+      resolve_function_proto(g, fn_proto, fn_table_entry);
+      fn_table_entry->fn_index = g->fn_protos.length;
       g->fn_table.put(name, fn_table_entry);
+      g->fn_protos.append(fn_table_entry);
     }
     break;
   case NodeTypeFnDef: {
@@ -157,6 +856,7 @@ static void preview_function_declarations(CodeGen *g, ImportTableEntry *import,
       node->codegen_node->data.fn_def_node.skip = true;
     } else {
       FnTableEntry *fn_table_entry = allocate<FnTableEntry>(1);
+      fn_table_entry->import_entry = import;
       fn_table_entry->proto_node = proto_node;
       fn_table_entry->fn_def_node = node;
       fn_table_entry->internal_linkage =
@@ -167,8 +867,16 @@ static void preview_function_declarations(CodeGen *g, ImportTableEntry *import,
         fn_table_entry->calling_convention = LLVMCCallConv;
       }
       g->fn_table.put(proto_name, fn_table_entry);
-      g->fn_defs.append(fn_table_entry);
-      resolve_function_proto(g, proto_node);
+      if (proto_node->data.fn_proto.generic_params.length > 0) {
+        // instances are created as calls to the function are analyzed
+        fn_table_entry->is_generic = true;
+        check_generic_params(g, fn_table_entry);
+      } else {
+        fn_table_entry->fn_index = g->fn_protos.length;
+        g->fn_protos.append(fn_table_entry);
+        g->fn_defs.append(fn_table_entry);
+        resolve_function_proto(g, proto_node, fn_table_entry);
+      }
     }
   } break;
   case NodeTypeRootExportDecl:
@@ -211,6 +919,8 @@ static void preview_function_declarations(CodeGen *g, ImportTableEntry *import,
     }
     break;
   case NodeTypeUse:
+  case NodeTypeStructDecl:
+  case NodeTypeVariableDeclaration:
     break;
   case NodeTypeDirective:
   case NodeTypeParamDecl:
@@ -228,6 +938,16 @@ static void preview_function_declarations(CodeGen *g, ImportTableEntry *import,
   case NodeTypeSymbol:
   case NodeTypeCastExpr:
   case NodeTypePrefixOpExpr:
+  case NodeTypeBoolLiteral:
+  case NodeTypeIfExpr:
+  case NodeTypeWhileExpr:
+  case NodeTypeForExpr:
+  case NodeTypeBreak:
+  case NodeTypeContinue:
+  case NodeTypeStructField:
+  case NodeTypeFieldAccessExpr:
+  case NodeTypeArrayAccessExpr:
+  case NodeTypeAsmExpr:
     jane_unreachable();
   }
 }
@@ -258,180 +978,2007 @@ static void check_type_compatiblity(CodeGen *g, AstNode *node,
   add_node_error(g, node, buf_sprintf("type mismatch"));
 }
 
-static TypeTableEntry *analyze_expression(CodeGen *g, BlockContext *context,
-                                          TypeTableEntry *expected_type,
-                                          AstNode *node) {
-  switch (node->type) {
-  case NodeTypeBlock: {
-    TypeTableEntry *return_type = g->builtin_types.entry_void;
-    for (int i = 0; i < node->data.block.statements.length; i += 1) {
-      AstNode *child = node->data.block.statements.at(i);
-      if (return_type == g->builtin_types.entry_unreachable) {
-        add_node_error(g, child, buf_sprintf("unreachable code"));
-        break;
-      }
-      return_type = analyze_expression(g, context, nullptr, child);
-    }
-    return return_type;
-  }
-  case NodeTypeReturnExpr: {
-    TypeTableEntry *expected_return_type = get_return_type(context);
-    TypeTableEntry *actual_return_type;
-    if (node->data.return_expr.expression) {
-      actual_return_type = analyze_expression(
-          g, context, expected_return_type, node->data.return_expr.expression);
-    } else {
-      actual_return_type = g->builtin_types.entry_void;
-    }
+BlockContext *new_block_context(AstNode *node, BlockContext *parent) {
+  BlockContext *context = allocate<BlockContext>(1);
+  context->node = node;
+  context->parent = parent;
+  context->root = parent ? parent->root : context;
+  context->variable_table.init(8);
+  return context;
+}
 
-    if (actual_return_type == g->builtin_types.entry_unreachable) {
-      add_node_error(g, node, buf_sprintf("returning is unreachable"));
-      actual_return_type = g->builtin_types.entry_invalid;
+LocalVariableTableEntry *find_local_variable(BlockContext *context,
+                                             Buf *name) {
+  while (context) {
+    auto entry = context->variable_table.maybe_get(name);
+    if (entry) {
+      return entry->value;
     }
-    check_type_compatiblity(g, node, expected_return_type, actual_return_type);
-    return g->builtin_types.entry_unreachable;
+    context = context->parent;
   }
-  case NodeTypeBinOpExpr: {
-    analyze_expression(g, context, expected_type, node->data.bin_op_expr.op1);
-    analyze_expression(g, context, expected_type, node->data.bin_op_expr.op2);
-    return expected_type;
+  return nullptr;
+}
+
+static LocalVariableTableEntry *add_local_variable(CodeGen *g,
+                                                   BlockContext *context,
+                                                   AstNode *decl_node,
+                                                   Buf *name,
+                                                   TypeTableEntry *type,
+                                                   bool is_const) {
+  if (find_local_variable(context, name)) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("redeclaration of variable `%s`", buf_ptr(name)));
+  } else if (type == g->builtin_types.entry_unreachable ||
+             type == g->builtin_types.entry_void) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("variable of type `%s` not allowed",
+                               buf_ptr(&type->name)));
   }
-  case NodeTypeFnCallExpr: {
-    Buf *name = hack_get_fn_call_name(g, node->data.fn_call_expr.fn_ref_expr);
-    auto entry = g->fn_table.maybe_get(name);
-    if (!entry) {
-      add_node_error(g, node,
-                     buf_sprintf("undefined function: %s", buf_ptr(name)));
-      for (int i = 0; i < node->data.fn_call_expr.params.length; i += 1) {
-        AstNode *child = node->data.fn_call_expr.params.at(i);
-        analyze_expression(g, context, nullptr, child);
-      }
-      return g->builtin_types.entry_invalid;
-    } else {
-      FnTableEntry *fn_table_entry = entry->value;
-      assert(fn_table_entry->proto_node->type == NodeTypeFnProto);
-      AstNodeFnProto *fn_proto = &fn_table_entry->proto_node->data.fn_proto;
-      int expected_param_count = fn_proto->params.length;
-      int actual_param_count = node->data.fn_call_expr.params.length;
-      if (expected_param_count != actual_param_count) {
-        add_node_error(
-            g, node,
-            buf_sprintf("wrong number of argument, expected %d, got `%d`",
-                        expected_param_count, actual_param_count));
-      }
-      for (int i = 0; i < node->data.fn_call_expr.params.length; i += 1) {
-        AstNode *child = node->data.fn_call_expr.params.at(i);
-        TypeTableEntry *expected_param_type = nullptr;
-        if (i < fn_proto->params.length) {
-          AstNode *param_decl_node = fn_proto->params.at(i);
-          assert(param_decl_node->type == NodeTypeParamDecl);
-          AstNode *param_type_node = param_decl_node->data.param_decl.type;
-          if (param_type_node->codegen_node) {
-            expected_param_type =
-                param_type_node->codegen_node->data.type_node.entry;
-          }
-        }
-        analyze_expression(g, context, expected_param_type, child);
-      }
-      TypeTableEntry *return_type =
-          fn_proto->return_type->codegen_node->data.type_node.entry;
-      check_type_compatiblity(g, node, expected_type, return_type);
-      return return_type;
+  LocalVariableTableEntry *variable = allocate<LocalVariableTableEntry>(1);
+  buf_init_from_buf(&variable->name, name);
+  variable->type = type;
+  variable->is_const = is_const;
+  variable->decl_node = decl_node;
+  variable->arg_index = -1;
+  context->variable_table.put(&variable->name, variable);
+  return variable;
+}
+
+static BranchHint resolve_branch_hint(CodeGen *g,
+                                      JaneList<AstNode *> *directives) {
+  BranchHint hint = BranchHintNone;
+  for (int i = 0; i < directives->length; i += 1) {
+    AstNode *directive_node = directives->at(i);
+    Buf *name = &directive_node->data.directive.name;
+    if (!buf_eql_str(name, "likely") && !buf_eql_str(name, "unlikely")) {
+      add_node_error(g, directive_node,
+                     buf_sprintf("invalid directive: `%s`", buf_ptr(name)));
+      continue;
+    }
+    if (!directive_has_param(g, directive_node, false)) {
+      continue;
+    }
+    BranchHint this_hint =
+        buf_eql_str(name, "likely") ? BranchHintLikely : BranchHintUnlikely;
+    if (hint != BranchHintNone && hint != this_hint) {
+      add_node_error(g, directive_node,
+                     buf_sprintf("branch cannot be both likely and unlikely"));
     }
+    hint = this_hint;
   }
-  case NodeTypeNumberLiteral:
-    return g->builtin_types.entry_i32;
-  case NodeTypeStringLiteral:
-    jane_panic("TODO: node type string literal");
-  case NodeTypeUnreachable:
-    return g->builtin_types.entry_unreachable;
-  case NodeTypeSymbol:
-    jane_panic("TODO: node type symbol");
-  case NodeTypeCastExpr:
-  case NodeTypePrefixOpExpr:
-    jane_panic("TODO: prefix operation expression");
-  case NodeTypeDirective:
-  case NodeTypeFnDecl:
-  case NodeTypeFnProto:
-  case NodeTypeParamDecl:
-  case NodeTypeType:
-  case NodeTypeRoot:
-  case NodeTypeRootExportDecl:
-  case NodeTypeExternBlock:
-  case NodeTypeFnDef:
-  case NodeTypeUse:
-    jane_unreachable();
+  return hint;
+}
+
+static BlockContext *find_loop_context(BlockContext *context) {
+  while (context && context->node->type != NodeTypeWhileExpr &&
+         context->node->type != NodeTypeForExpr) {
+    context = context->parent;
   }
-  jane_unreachable();
+  return context;
 }
 
-static void check_fn_def_control_flow(CodeGen *g, AstNode *node) {
-  assert(node->type == NodeTypeFnDef);
-  AstNode *proto_node = node->data.fn_def.fn_proto;
-  assert(proto_node->type == NodeTypeFnProto);
-  AstNode *return_type_node = proto_node->data.fn_proto.return_type;
-  assert(return_type_node->type == NodeTypeType);
+static BranchNode *alloc_branch_node(AstNode *node) {
+  assert(!node->codegen_node);
   node->codegen_node = allocate<CodeGenNode>(1);
-  FnDefNode *codegen_fn_def = &node->codegen_node->data.fn_def_node;
-  assert(return_type_node->codegen_node);
-  TypeTableEntry *type_entry =
-      return_type_node->codegen_node->data.type_node.entry;
-  assert(type_entry);
-  AstNode *body_node = node->data.fn_def.body;
-  assert(body_node->type == NodeTypeBlock);
-
-  bool prev_statement_return = false;
-  for (int i = 0; i < body_node->data.block.statements.length; i += 1) {
-    AstNode *statement_node = body_node->data.block.statements.at(i);
-    if (statement_node->type == NodeTypeReturnExpr) {
-      if (type_entry == g->builtin_types.entry_unreachable) {
-        add_node_error(
-            g, statement_node,
-            buf_sprintf(
-                "return statement function with unreachable return type"));
-        return;
-      } else {
-        prev_statement_return = true;
-      }
-    } else if (prev_statement_return) {
-      add_node_error(g, statement_node, buf_sprintf("unreachable code"));
-    }
+  return &node->codegen_node->data.branch_node;
+}
+
+static void set_expr_type(AstNode *node, BlockContext *context,
+                          TypeTableEntry *type) {
+  if (!node->codegen_node) {
+    node->codegen_node = allocate<CodeGenNode>(1);
   }
+  node->codegen_node->expr_node.type_entry = type;
+  node->codegen_node->expr_node.block_context = context;
+}
 
-  if (!prev_statement_return) {
-    if (type_entry == g->builtin_types.entry_void) {
-      codegen_fn_def->add_implicit_return = true;
-    } else if (type_entry != g->builtin_types.entry_unreachable) {
-      add_node_error(g, node,
-                     buf_sprintf("control reaches end of non-void function"));
+static bool type_is_numeric(TypeTableEntry *type) {
+  return type->id == TypeTableEntryIdInt || type->id == TypeTableEntryIdFloat;
+}
+
+static bool number_literal_is_float(Buf *text) {
+  for (int i = 0; i < buf_len(text); i += 1) {
+    char c = buf_ptr(text)[i];
+    if (c == '.' || c == 'e' || c == 'E') {
+      return true;
     }
   }
+  return false;
 }
 
-static void analyze_top_level_declaration(CodeGen *g, AstNode *node) {
-  switch (node->type) {
-  case NodeTypeFnDef: {
-    if (node->codegen_node && node->codegen_node->data.fn_def_node.skip) {
-      break;
-    }
-    AstNode *fn_proto_node = node->data.fn_def.fn_proto;
-    assert(fn_proto_node->type == NodeTypeFnProto);
-    AstNodeFnProto *fn_proto = &fn_proto_node->data.fn_proto;
-    for (int i = 0; i < fn_proto->params.length; i += 1) {
+static bool int_literal_fits(Buf *text, bool negated, TypeTableEntry *type) {
+  errno = 0;
+  unsigned long long value = strtoull(buf_ptr(text), nullptr, 10);
+  if (errno == ERANGE) {
+    return false;
+  }
+  if (negated && !type->is_signed) {
+    return value == 0;
+  }
+  uint64_t bits = type->size_in_bits;
+  uint64_t max;
+  if (type->is_signed) {
+    // one more on the negative side
+    max = (1ull << (bits - 1)) - (negated ? 0 : 1);
+  } else {
+    max = bits == 64 ? UINT64_MAX : (1ull << bits) - 1;
+  }
+  return value <= max;
+}
+
+// a string literal is a `[]const u8` where such a slice is expected, which
+// carries its length and does not rely on the terminator, and a nul
+// terminated `*const u8` otherwise
+static TypeTableEntry *analyze_string_literal(CodeGen *g, AstNode *node,
+                                              TypeTableEntry *expected_type) {
+  Buf *str = &node->data.string;
+  if (!g->str_table.maybe_get(str)) {
+    g->str_table.put(str, nullptr);
+    g->string_literals.append(str);
+  }
+  TypeTableEntry *ptr_type =
+      get_pointer_to_type(g, g->builtin_types.entry_u8, true);
+  if (expected_type && expected_type->id == TypeTableEntryIdSlice &&
+      expected_type->struct_fields[0].type_entry == ptr_type) {
+    return expected_type;
+  }
+  return ptr_type;
+}
+
+// literals take the type the context expects and otherwise default to i32
+// (or i64 when the value does not fit) and f64
+static TypeTableEntry *analyze_number_literal(CodeGen *g, AstNode *node,
+                                              TypeTableEntry *expected_type,
+                                              bool negated) {
+  Buf *text = &node->data.number;
+  bool is_float = number_literal_is_float(text);
+  if (expected_type && expected_type->id == TypeTableEntryIdVector &&
+      type_is_numeric(expected_type->vector_child)) {
+    // a literal operand of a vector operation is splatted
+    TypeTableEntry *elem_type = analyze_number_literal(
+        g, node, expected_type->vector_child, negated);
+    return elem_type->id == TypeTableEntryIdInvalid ? elem_type
+                                                     : expected_type;
+  }
+  if (expected_type && expected_type->id == TypeTableEntryIdFloat) {
+    return expected_type;
+  }
+  if (expected_type && expected_type->id == TypeTableEntryIdInt) {
+    if (is_float) {
+      add_node_error(g, node,
+                     buf_sprintf("float literal cannot be implicitly converted "
+                                 "to `%s`",
+                                 buf_ptr(&expected_type->name)));
+      return g->builtin_types.entry_invalid;
+    }
+    if (!int_literal_fits(text, negated, expected_type)) {
+      add_node_error(g, node,
+                     buf_sprintf("integer literal `%s%s` does not fit in `%s`",
+                                 negated ? "-" : "", buf_ptr(text),
+                                 buf_ptr(&expected_type->name)));
+      return g->builtin_types.entry_invalid;
+    }
+    return expected_type;
+  }
+  if (is_float) {
+    return g->builtin_types.entry_f64;
+  }
+  if (int_literal_fits(text, negated, g->builtin_types.entry_i32)) {
+    return g->builtin_types.entry_i32;
+  }
+  if (int_literal_fits(text, negated, g->builtin_types.entry_i64)) {
+    return g->builtin_types.entry_i64;
+  }
+  add_node_error(g, node,
+                 buf_sprintf("integer literal `%s` is too large",
+                             buf_ptr(text)));
+  return g->builtin_types.entry_invalid;
+}
+
+static bool cast_allowed(TypeTableEntry *src, TypeTableEntry *dest) {
+  if (src == dest || src->id == TypeTableEntryIdInvalid ||
+      dest->id == TypeTableEntryIdInvalid) {
+    return true;
+  }
+  if (src->id == TypeTableEntryIdVector || dest->id == TypeTableEntryIdVector) {
+    // element-wise, between vectors of the same length
+    return src->id == dest->id && src->vector_len == dest->vector_len &&
+           cast_allowed(src->vector_child, dest->vector_child);
+  }
+  if (type_is_numeric(src) && type_is_numeric(dest)) {
+    return true;
+  }
+  if (src->id == TypeTableEntryIdBool && dest->id == TypeTableEntryIdInt) {
+    return true;
+  }
+  if (src->id == TypeTableEntryIdPointer &&
+      dest->id == TypeTableEntryIdPointer) {
+    return true;
+  }
+  // pointer <-> integer only through a pointer sized integer
+  if ((src->id == TypeTableEntryIdPointer && dest->id == TypeTableEntryIdInt) ||
+      (src->id == TypeTableEntryIdInt && dest->id == TypeTableEntryIdPointer)) {
+    return src->size_in_bits == dest->size_in_bits;
+  }
+  return false;
+}
+
+static TypeTableEntry *analyze_expression(CodeGen *g, BlockContext *context,
+                                          TypeTableEntry *expected_type,
+                                          AstNode *node);
+static TypeTableEntry *analyze_variable_declaration(CodeGen *g,
+                                                   BlockContext *context,
+                                                   AstNode *node);
+static TypeTableEntry *analyze_assignment(CodeGen *g, BlockContext *context,
+                                          AstNode *node);
+
+static void analyze_condition(CodeGen *g, BlockContext *context,
+                              AstNode *node) {
+  TypeTableEntry *type =
+      analyze_expression(g, context, g->builtin_types.entry_bool, node);
+  check_type_compatiblity(g, node, g->builtin_types.entry_bool, type);
+}
+
+// analyzes both operands of a binary operator so that they end up with the
+// same type. a literal on the left takes its type from the right operand.
+static TypeTableEntry *analyze_peer_operands(CodeGen *g, BlockContext *context,
+                                             TypeTableEntry *expected_type,
+                                             AstNode *node) {
+  AstNode *op1 = node->data.bin_op_expr.op1;
+  AstNode *op2 = node->data.bin_op_expr.op2;
+  TypeTableEntry *op1_type;
+  TypeTableEntry *op2_type;
+  if (op1->type == NodeTypeNumberLiteral && op2->type != NodeTypeNumberLiteral) {
+    op2_type = analyze_expression(g, context, expected_type, op2);
+    op1_type = analyze_expression(g, context, op2_type, op1);
+  } else {
+    op1_type = analyze_expression(g, context, expected_type, op1);
+    op2_type = analyze_expression(g, context, op1_type, op2);
+  }
+  check_type_compatiblity(g, node, op1_type, op2_type);
+  return op1_type;
+}
+
+static TypeTableEntry *get_cmp_result_type(CodeGen *g, TypeTableEntry *type) {
+  if (type->id == TypeTableEntryIdVector) {
+    return get_vector_type(g, g->builtin_types.entry_bool, type->vector_len);
+  }
+  return g->builtin_types.entry_bool;
+}
+
+static void check_operand_type(CodeGen *g, AstNode *node, TypeTableEntry *type,
+                               bool allowed) {
+  if (!allowed && type->id != TypeTableEntryIdInvalid &&
+      type->id != TypeTableEntryIdUnreachable) {
+    add_node_error(g, node,
+                   buf_sprintf("operator `%s` not allowed on type `%s`",
+                               bin_op_str(node->data.bin_op_expr.bin_op),
+                               buf_ptr(&type->name)));
+  }
+}
+
+static TypeTableEntry *analyze_bin_op_expr(CodeGen *g, BlockContext *context,
+                                           TypeTableEntry *expected_type,
+                                           AstNode *node) {
+  switch (node->data.bin_op_expr.bin_op) {
+  case BinOpTypeAssign:
+    return analyze_assignment(g, context, node);
+  case BinOpTypeBoolOr:
+  case BinOpTypeBoolAnd:
+    analyze_condition(g, context, node->data.bin_op_expr.op1);
+    analyze_condition(g, context, node->data.bin_op_expr.op2);
+    return g->builtin_types.entry_bool;
+  case BinOpTypeCmpEq:
+  case BinOpTypeCmpNotEq: {
+    TypeTableEntry *type = analyze_peer_operands(g, context, nullptr, node);
+    TypeTableEntry *scalar_type = get_scalar_type(type);
+    check_operand_type(g, node, type,
+                       type_is_numeric(scalar_type) ||
+                           scalar_type->id == TypeTableEntryIdBool ||
+                           scalar_type->id == TypeTableEntryIdPointer);
+    return get_cmp_result_type(g, type);
+  }
+  case BinOpTypeCmpLessThan:
+  case BinOpTypeCmpGreaterThan:
+  case BinOpTypeCmpLessOrEq:
+  case BinOpTypeCmpGreaterOrEq: {
+    TypeTableEntry *type = analyze_peer_operands(g, context, nullptr, node);
+    check_operand_type(g, node, type, type_is_numeric(get_scalar_type(type)));
+    return get_cmp_result_type(g, type);
+  }
+  case BinOpTypeBinOr:
+  case BinOpTypeBinXor:
+  case BinOpTypeBinAnd:
+  case BinOpTypeBitShiftLeft:
+  case BinOpTypeBitShiftRight: {
+    TypeTableEntry *type =
+        analyze_peer_operands(g, context, expected_type, node);
+    check_operand_type(g, node, type,
+                       get_scalar_type(type)->id == TypeTableEntryIdInt);
+    return type;
+  }
+  case BinOpTypeAdd:
+  case BinOpTypeSub:
+  case BinOpTypeMult:
+  case BinOpTypeDiv:
+  case BinOpTypeMod: {
+    TypeTableEntry *type =
+        analyze_peer_operands(g, context, expected_type, node);
+    check_operand_type(g, node, type, type_is_numeric(get_scalar_type(type)));
+    return type;
+  }
+  case BinOpTypeInvalid:
+    jane_unreachable();
+  }
+  jane_unreachable();
+}
+
+static TypeTableEntry *analyze_field_access_expr(CodeGen *g,
+                                                BlockContext *context,
+                                                AstNode *node) {
+  AstNode *struct_expr = node->data.field_access_expr.struct_expr;
+  Buf *field_name = &node->data.field_access_expr.field_name;
+  TypeTableEntry *struct_type =
+      analyze_expression(g, context, nullptr, struct_expr);
+  // fields are reachable through a pointer without an explicit dereference
+  TypeTableEntry *bare_type = struct_type->id == TypeTableEntryIdPointer
+                                  ? struct_type->pointer_child
+                                  : struct_type;
+  if (struct_type->id == TypeTableEntryIdInvalid) {
+    return g->builtin_types.entry_invalid;
+  } else if (bare_type->id == TypeTableEntryIdArray &&
+             buf_eql_str(field_name, "len")) {
+    assert(!node->codegen_node);
+    node->codegen_node = allocate<CodeGenNode>(1);
+    return g->builtin_types.entry_usize;
+  } else if (bare_type->id != TypeTableEntryIdStruct &&
+             bare_type->id != TypeTableEntryIdSlice) {
+    add_node_error(g, node,
+                   buf_sprintf("type `%s` does not support field access",
+                               buf_ptr(&struct_type->name)));
+    return g->builtin_types.entry_invalid;
+  } else if (bare_type->struct_is_invalid) {
+    return g->builtin_types.entry_invalid;
+  }
+  for (int i = 0; i < bare_type->struct_field_count; i += 1) {
+    TypeStructField *field = &bare_type->struct_fields[i];
+    if (buf_eql_buf(field->name, field_name)) {
+      assert(!node->codegen_node);
+      node->codegen_node = allocate<CodeGenNode>(1);
+      node->codegen_node->data.field_access_node.field = field;
+      return field->type_entry;
+    }
+  }
+  add_node_error(g, node,
+                 buf_sprintf("no field named `%s` in `%s`",
+                             buf_ptr(field_name), buf_ptr(&bare_type->name)));
+  return g->builtin_types.entry_invalid;
+}
+
+static TypeTableEntry *get_analyzed_type(AstNode *node) {
+  return node->codegen_node->expr_node.type_entry;
+}
+
+enum LValueKind {
+  LValueKindNone,
+  LValueKindConst,
+  LValueKindMut,
+};
+
+// whether an analyzed expression names a memory location, and whether that
+// location may be written
+static LValueKind get_lvalue_kind(BlockContext *context, AstNode *node) {
+  switch (node->type) {
+  case NodeTypeSymbol: {
+    if (node->codegen_node->data.symbol_node.global_const) {
+      return LValueKindConst;
+    }
+    LocalVariableTableEntry *variable =
+        find_local_variable(context, &node->data.symbol);
+    if (!variable) {
+      return LValueKindNone;
+    }
+    return variable->is_const ? LValueKindConst : LValueKindMut;
+  }
+  case NodeTypeFieldAccessExpr: {
+    if (!node->codegen_node->data.field_access_node.field) {
+      // the length of an array is not stored anywhere
+      return LValueKindNone;
+    }
+    AstNode *struct_expr = node->data.field_access_expr.struct_expr;
+    TypeTableEntry *struct_type = get_analyzed_type(struct_expr);
+    if (struct_type->id == TypeTableEntryIdPointer) {
+      return struct_type->pointer_is_const ? LValueKindConst : LValueKindMut;
+    }
+    return get_lvalue_kind(context, struct_expr);
+  }
+  case NodeTypeArrayAccessExpr: {
+    AstNode *array_ref_expr = node->data.array_access_expr.array_ref_expr;
+    TypeTableEntry *array_type = get_analyzed_type(array_ref_expr);
+    if (array_type->id == TypeTableEntryIdSlice) {
+      return array_type->struct_fields[0].type_entry->pointer_is_const
+                 ? LValueKindConst
+                 : LValueKindMut;
+    }
+    return get_lvalue_kind(context, array_ref_expr);
+  }
+  case NodeTypePrefixOpExpr: {
+    if (node->data.prefix_op_expr.prefix_op != PrefixOpDereference) {
+      return LValueKindNone;
+    }
+    TypeTableEntry *pointer_type =
+        get_analyzed_type(node->data.prefix_op_expr.primary_expr);
+    return pointer_type->pointer_is_const ? LValueKindConst : LValueKindMut;
+  }
+  default:
+    return LValueKindNone;
+  }
+}
+
+// the struct whose packing may leave the location below its type's
+// alignment, or null
+static TypeTableEntry *get_lvalue_packed_struct(CodeGen *g, AstNode *node) {
+  if (node->type == NodeTypeFieldAccessExpr) {
+    AstNode *struct_expr = node->data.field_access_expr.struct_expr;
+    TypeTableEntry *struct_type = get_analyzed_type(struct_expr);
+    TypeTableEntry *bare_type = struct_type->id == TypeTableEntryIdPointer
+                                    ? struct_type->pointer_child
+                                    : struct_type;
+    TypeStructField *field = node->codegen_node->data.field_access_node.field;
+    if (bare_type->id == TypeTableEntryIdStruct &&
+        bare_type->struct_is_packed &&
+        get_type_alignment(g, field->type_entry) > 1) {
+      return bare_type;
+    }
+    if (struct_type->id == TypeTableEntryIdPointer) {
+      return nullptr;
+    }
+    return get_lvalue_packed_struct(g, struct_expr);
+  } else if (node->type == NodeTypeArrayAccessExpr) {
+    AstNode *array_ref_expr = node->data.array_access_expr.array_ref_expr;
+    if (get_analyzed_type(array_ref_expr)->id == TypeTableEntryIdArray) {
+      return get_lvalue_packed_struct(g, array_ref_expr);
+    }
+  }
+  return nullptr;
+}
+
+static TypeTableEntry *analyze_array_access_expr(CodeGen *g,
+                                                BlockContext *context,
+                                                AstNode *node) {
+  AstNode *array_ref_expr = node->data.array_access_expr.array_ref_expr;
+  AstNode *subscript = node->data.array_access_expr.subscript;
+  TypeTableEntry *array_type =
+      analyze_expression(g, context, nullptr, array_ref_expr);
+  TypeTableEntry *return_type = g->builtin_types.entry_invalid;
+  if (array_type->id == TypeTableEntryIdArray) {
+    return_type = array_type->array_child;
+  } else if (array_type->id == TypeTableEntryIdSlice) {
+    return_type = array_type->struct_fields[0].type_entry->pointer_child;
+  } else if (array_type->id != TypeTableEntryIdInvalid) {
+    add_node_error(g, node, buf_sprintf("type `%s` does not support indexing",
+                                        buf_ptr(&array_type->name)));
+  }
+
+  TypeTableEntry *index_type = analyze_expression(
+      g, context, g->builtin_types.entry_usize, subscript);
+  if (index_type->id != TypeTableEntryIdInt &&
+      index_type->id != TypeTableEntryIdInvalid) {
+    add_node_error(g, subscript,
+                   buf_sprintf("array subscript must be an integer, got `%s`",
+                               buf_ptr(&index_type->name)));
+  } else if (array_type->id == TypeTableEntryIdArray &&
+             subscript->type == NodeTypeNumberLiteral) {
+    // number literal indexes into arrays are checked here and never at
+    // runtime; codegen checks every other index
+    unsigned long long index =
+        strtoull(buf_ptr(&subscript->data.number), nullptr, 10);
+    if (index >= array_type->array_len) {
+      add_node_error(g, subscript,
+                     buf_sprintf("index %llu is out of bounds for `%s`", index,
+                                 buf_ptr(&array_type->name)));
+    }
+  }
+  return return_type;
+}
+
+static TypeTableEntry *analyze_vector_operand(CodeGen *g, BlockContext *context,
+                                              TypeTableEntry *expected_type,
+                                              AstNode *node) {
+  TypeTableEntry *type = analyze_expression(g, context, expected_type, node);
+  if (type->id != TypeTableEntryIdVector &&
+      type->id != TypeTableEntryIdInvalid) {
+    add_node_error(g, node, buf_sprintf("expected vector type, got `%s`",
+                                        buf_ptr(&type->name)));
+    return g->builtin_types.entry_invalid;
+  }
+  return type;
+}
+
+// literals take the type of the parameter they are passed to
+static bool is_number_literal_arg(AstNode *node) {
+  if (node->type == NodeTypePrefixOpExpr &&
+      node->data.prefix_op_expr.prefix_op == PrefixOpNegation) {
+    node = node->data.prefix_op_expr.primary_expr;
+  }
+  return node->type == NodeTypeNumberLiteral;
+}
+
+// the jane type for a parameter or result of an llvm intrinsic. integers map
+// to the unsigned type of the same width; arguments only have to match in
+// their llvm type.
+static TypeTableEntry *get_type_for_llvm_type(CodeGen *g,
+                                              LLVMTypeRef type_ref) {
+  switch (LLVMGetTypeKind(type_ref)) {
+  case LLVMVoidTypeKind:
+    return g->builtin_types.entry_void;
+  case LLVMIntegerTypeKind: {
+    unsigned bits = LLVMGetIntTypeWidth(type_ref);
+    if (bits == 1) {
+      return g->builtin_types.entry_bool;
+    }
+    auto entry = g->type_table.maybe_get(buf_sprintf("u%u", bits));
+    return entry ? entry->value : nullptr;
+  }
+  case LLVMFloatTypeKind:
+    return g->builtin_types.entry_f32;
+  case LLVMDoubleTypeKind:
+    return g->builtin_types.entry_f64;
+  case LLVMPointerTypeKind:
+    return get_pointer_to_type(g, g->builtin_types.entry_u8, false);
+  case LLVMVectorTypeKind: {
+    TypeTableEntry *child_type =
+        get_type_for_llvm_type(g, LLVMGetElementType(type_ref));
+    if (!child_type) {
+      return nullptr;
+    }
+    return get_vector_type(g, child_type, (int)LLVMGetVectorSize(type_ref));
+  }
+  default:
+    return nullptr;
+  }
+}
+
+// checked against the intrinsic's llvm prototype
+static TypeTableEntry *analyze_intrinsic_call(CodeGen *g,
+                                              BlockContext *context,
+                                              AstNode *node) {
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  TypeTableEntry *invalid = g->builtin_types.entry_invalid;
+  AstNode *name_node = params->at(0);
+  unsigned intrinsic_id = 0;
+  if (name_node->type != NodeTypeStringLiteral) {
+    add_node_error(g, name_node,
+                   buf_sprintf("`@intrinsic` expects the intrinsic name as a "
+                               "string literal"));
+  } else {
+    Buf *name = &name_node->data.string;
+    intrinsic_id = LLVMLookupIntrinsicID(buf_ptr(name), buf_len(name));
+    if (!intrinsic_id) {
+      add_node_error(g, name_node,
+                     buf_sprintf("unknown llvm intrinsic `%s`", buf_ptr(name)));
+    } else if (LLVMIntrinsicIsOverloaded(intrinsic_id)) {
+      add_node_error(g, name_node,
+                     buf_sprintf("`%s` is overloaded, which `@intrinsic` does "
+                                 "not support",
+                                 buf_ptr(name)));
+      intrinsic_id = 0;
+    }
+  }
+  if (!intrinsic_id) {
+    for (int i = 1; i < params->length; i += 1) {
+      analyze_expression(g, context, nullptr, params->at(i));
+    }
+    return invalid;
+  }
+  Buf *name = &name_node->data.string;
+  LLVMTypeRef fn_type =
+      LLVMIntrinsicGetType(LLVMGetGlobalContext(), intrinsic_id, nullptr, 0);
+  int param_count = (int)LLVMCountParamTypes(fn_type);
+  LLVMTypeRef *param_types = allocate<LLVMTypeRef>(param_count);
+  LLVMGetParamTypes(fn_type, param_types);
+  int arg_count = params->length - 1;
+  if (arg_count != param_count) {
+    add_node_error(g, node,
+                   buf_sprintf("`%s` expects %d arguments, got %d",
+                               buf_ptr(name), param_count, arg_count));
+  }
+  bool ok = arg_count == param_count;
+  for (int i = 0; i < arg_count; i += 1) {
+    AstNode *arg = params->at(i + 1);
+    TypeTableEntry *param_type =
+        i < param_count ? get_type_for_llvm_type(g, param_types[i]) : nullptr;
+    TypeTableEntry *arg_type = analyze_expression(
+        g, context, is_number_literal_arg(arg) ? param_type : nullptr, arg);
+    if (i >= param_count || arg_type->id == TypeTableEntryIdInvalid) {
+      ok = false;
+    } else if (!param_type) {
+      add_node_error(g, arg,
+                     buf_sprintf("parameter %d of `%s` has no jane type",
+                                 i + 1, buf_ptr(name)));
+      ok = false;
+    } else if (arg_type->type_ref != param_types[i]) {
+      add_node_error(g, arg,
+                     buf_sprintf("argument %d of `%s` must be `%s`, got `%s`",
+                                 i + 1, buf_ptr(name),
+                                 buf_ptr(&param_type->name),
+                                 buf_ptr(&arg_type->name)));
+      ok = false;
+    }
+  }
+  deallocate(param_types, param_count);
+  TypeTableEntry *return_type =
+      get_type_for_llvm_type(g, LLVMGetReturnType(fn_type));
+  if (!return_type) {
+    add_node_error(g, node,
+                   buf_sprintf("the result of `%s` has no jane type",
+                               buf_ptr(name)));
+    return invalid;
+  }
+  if (!ok) {
+    return invalid;
+  }
+  node->codegen_node->data.fn_call_node.intrinsic_id = intrinsic_id;
+  return return_type;
+}
+
+// orderings and operations are written as string literals:
+// `@atomic_rmw(&counter, "add", 1, "relaxed")`
+static bool analyze_atomic_order(CodeGen *g, AstNode *node,
+                                 LLVMAtomicOrdering *out) {
+  static const struct {
+    const char *name;
+    LLVMAtomicOrdering order;
+  } orders[] = {
+      {"relaxed", LLVMAtomicOrderingMonotonic},
+      {"acquire", LLVMAtomicOrderingAcquire},
+      {"release", LLVMAtomicOrderingRelease},
+      {"acq_rel", LLVMAtomicOrderingAcquireRelease},
+      {"seq_cst", LLVMAtomicOrderingSequentiallyConsistent},
+  };
+  for (int i = 0; node->type == NodeTypeStringLiteral &&
+                  i < array_length(orders);
+       i += 1) {
+    if (buf_eql_str(&node->data.string, orders[i].name)) {
+      *out = orders[i].order;
+      return true;
+    }
+  }
+  add_node_error(g, node,
+                 buf_sprintf("expected memory ordering \"relaxed\", "
+                             "\"acquire\", \"release\", \"acq_rel\" or "
+                             "\"seq_cst\""));
+  return false;
+}
+
+static bool analyze_atomic_rmw_op(CodeGen *g, AstNode *node,
+                                  TypeTableEntry *type,
+                                  LLVMAtomicRMWBinOp *out) {
+  static const struct {
+    const char *name;
+    LLVMAtomicRMWBinOp int_op;
+    LLVMAtomicRMWBinOp uint_op;
+    LLVMAtomicRMWBinOp float_op;
+    bool allows_pointer;
+    bool allows_float;
+  } ops[] = {
+      {"xchg", LLVMAtomicRMWBinOpXchg, LLVMAtomicRMWBinOpXchg,
+       LLVMAtomicRMWBinOpXchg, true, true},
+      {"add", LLVMAtomicRMWBinOpAdd, LLVMAtomicRMWBinOpAdd,
+       LLVMAtomicRMWBinOpFAdd, false, true},
+      {"sub", LLVMAtomicRMWBinOpSub, LLVMAtomicRMWBinOpSub,
+       LLVMAtomicRMWBinOpFSub, false, true},
+      {"and", LLVMAtomicRMWBinOpAnd, LLVMAtomicRMWBinOpAnd,
+       LLVMAtomicRMWBinOpAnd, false, false},
+      {"nand", LLVMAtomicRMWBinOpNand, LLVMAtomicRMWBinOpNand,
+       LLVMAtomicRMWBinOpNand, false, false},
+      {"or", LLVMAtomicRMWBinOpOr, LLVMAtomicRMWBinOpOr, LLVMAtomicRMWBinOpOr,
+       false, false},
+      {"xor", LLVMAtomicRMWBinOpXor, LLVMAtomicRMWBinOpXor,
+       LLVMAtomicRMWBinOpXor, false, false},
+      {"max", LLVMAtomicRMWBinOpMax, LLVMAtomicRMWBinOpUMax,
+       LLVMAtomicRMWBinOpMax, false, false},
+      {"min", LLVMAtomicRMWBinOpMin, LLVMAtomicRMWBinOpUMin,
+       LLVMAtomicRMWBinOpMin, false, false},
+  };
+  if (node->type != NodeTypeStringLiteral) {
+    add_node_error(g, node,
+                   buf_sprintf("expected atomic operation as a string "
+                               "literal"));
+    return false;
+  }
+  for (int i = 0; i < array_length(ops); i += 1) {
+    if (!buf_eql_str(&node->data.string, ops[i].name)) {
+      continue;
+    }
+    bool allowed;
+    if (type->id == TypeTableEntryIdInt) {
+      *out = type->is_signed ? ops[i].int_op : ops[i].uint_op;
+      allowed = true;
+    } else if (type->id == TypeTableEntryIdFloat) {
+      *out = ops[i].float_op;
+      allowed = ops[i].allows_float;
+    } else {
+      *out = ops[i].int_op;
+      allowed = ops[i].allows_pointer;
+    }
+    if (!allowed) {
+      add_node_error(g, node,
+                     buf_sprintf("atomic `%s` not allowed on type `%s`",
+                                 ops[i].name, buf_ptr(&type->name)));
+    }
+    return allowed;
+  }
+  add_node_error(g, node,
+                 buf_sprintf("unknown atomic operation \"%s\"",
+                             buf_ptr(&node->data.string)));
+  return false;
+}
+
+// llvm only does atomic accesses of power of two sized integers, floats and
+// pointers
+static bool is_atomic_type(TypeTableEntry *type) {
+  switch (type->id) {
+  case TypeTableEntryIdInt:
+    return type->size_in_bits >= 8 && type->size_in_bits <= 64;
+  case TypeTableEntryIdFloat:
+  case TypeTableEntryIdPointer:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// the type pointed to by the first argument of an atomic builtin, or invalid
+static TypeTableEntry *analyze_atomic_ptr(CodeGen *g, BlockContext *context,
+                                          AstNode *node, bool is_store) {
+  TypeTableEntry *invalid = g->builtin_types.entry_invalid;
+  TypeTableEntry *ptr_type = analyze_expression(g, context, nullptr, node);
+  if (ptr_type->id == TypeTableEntryIdInvalid) {
+    return invalid;
+  } else if (ptr_type->id != TypeTableEntryIdPointer) {
+    add_node_error(g, node,
+                   buf_sprintf("expected pointer, got `%s`",
+                               buf_ptr(&ptr_type->name)));
+    return invalid;
+  } else if (!is_atomic_type(ptr_type->pointer_child)) {
+    add_node_error(g, node,
+                   buf_sprintf("`%s` cannot be accessed atomically",
+                               buf_ptr(&ptr_type->pointer_child->name)));
+    return invalid;
+  } else if (is_store && ptr_type->pointer_is_const) {
+    add_node_error(g, node,
+                   buf_sprintf("cannot store through const pointer `%s`",
+                               buf_ptr(&ptr_type->name)));
+    return invalid;
+  }
+  return ptr_type->pointer_child;
+}
+
+static bool analyze_atomic_operand(CodeGen *g, BlockContext *context,
+                                   TypeTableEntry *type, AstNode *node) {
+  TypeTableEntry *expected_type =
+      type->id == TypeTableEntryIdInvalid ? nullptr : type;
+  TypeTableEntry *actual_type =
+      analyze_expression(g, context, expected_type, node);
+  if (!expected_type || actual_type->id == TypeTableEntryIdInvalid) {
+    return false;
+  }
+  check_type_compatiblity(g, node, expected_type, actual_type);
+  return actual_type == expected_type;
+}
+
+static TypeTableEntry *analyze_atomic_call(CodeGen *g, BlockContext *context,
+                                           AstNode *node) {
+  FnCallNode *fn_call_node = &node->codegen_node->data.fn_call_node;
+  BuiltinFnId id = fn_call_node->builtin_fn->id;
+  Buf *name = &fn_call_node->builtin_fn->name;
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  TypeTableEntry *invalid = g->builtin_types.entry_invalid;
+  if (id == BuiltinFnIdFence) {
+    if (!analyze_atomic_order(g, params->at(0), &fn_call_node->atomic_order)) {
+      return invalid;
+    } else if (fn_call_node->atomic_order == LLVMAtomicOrderingMonotonic) {
+      add_node_error(g, params->at(0),
+                     buf_sprintf("a relaxed fence orders nothing"));
+      return invalid;
+    }
+    return g->builtin_types.entry_void;
+  }
+  // everything but a load writes through the pointer
+  bool is_store = id != BuiltinFnIdAtomicLoad;
+  TypeTableEntry *type =
+      analyze_atomic_ptr(g, context, params->at(0), is_store);
+  bool ok = type->id != TypeTableEntryIdInvalid;
+  AstNode *order_node = params->last();
+  switch (id) {
+  case BuiltinFnIdAtomicLoad:
+    break;
+  case BuiltinFnIdAtomicStore:
+    ok = analyze_atomic_operand(g, context, type, params->at(1)) && ok;
+    break;
+  case BuiltinFnIdAtomicRmw:
+    if (ok) {
+      ok = analyze_atomic_rmw_op(g, params->at(1), type,
+                                 &fn_call_node->atomic_rmw_op);
+    }
+    ok = analyze_atomic_operand(g, context, type, params->at(2)) && ok;
+    break;
+  case BuiltinFnIdCmpxchg:
+    if (ok && type->id == TypeTableEntryIdFloat) {
+      add_node_error(g, params->at(0),
+                     buf_sprintf("`@%s` not allowed on type `%s`",
+                                 buf_ptr(name), buf_ptr(&type->name)));
+      ok = false;
+    }
+    ok = analyze_atomic_operand(g, context, type, params->at(1)) && ok;
+    ok = analyze_atomic_operand(g, context, type, params->at(2)) && ok;
+    order_node = params->at(3);
+    break;
+  default:
+    jane_unreachable();
+  }
+  LLVMAtomicOrdering order;
+  if (!analyze_atomic_order(g, order_node, &order)) {
+    return invalid;
+  }
+  fn_call_node->atomic_order = order;
+  bool is_acquire = order == LLVMAtomicOrderingAcquire ||
+                    order == LLVMAtomicOrderingAcquireRelease;
+  bool is_release = order == LLVMAtomicOrderingRelease ||
+                    order == LLVMAtomicOrderingAcquireRelease;
+  if ((id == BuiltinFnIdAtomicLoad && is_release) ||
+      (id == BuiltinFnIdAtomicStore && is_acquire)) {
+    add_node_error(g, order_node,
+                   buf_sprintf("`@%s` cannot have memory ordering \"%s\"",
+                               buf_ptr(name),
+                               buf_ptr(&order_node->data.string)));
+    return invalid;
+  }
+  if (id == BuiltinFnIdCmpxchg) {
+    AstNode *failure_node = params->at(4);
+    LLVMAtomicOrdering failure_order;
+    if (!analyze_atomic_order(g, failure_node, &failure_order)) {
+      return invalid;
+    }
+    // the failure case is only a load, and cannot be stronger than success
+    bool too_strong =
+        (failure_order == LLVMAtomicOrderingSequentiallyConsistent &&
+         order != LLVMAtomicOrderingSequentiallyConsistent) ||
+        (failure_order == LLVMAtomicOrderingAcquire &&
+         (order == LLVMAtomicOrderingMonotonic ||
+          order == LLVMAtomicOrderingRelease));
+    if (failure_order == LLVMAtomicOrderingRelease ||
+        failure_order == LLVMAtomicOrderingAcquireRelease || too_strong) {
+      add_node_error(g, failure_node,
+                     buf_sprintf("invalid failure ordering \"%s\" for "
+                                 "success ordering \"%s\"",
+                                 buf_ptr(&failure_node->data.string),
+                                 buf_ptr(&order_node->data.string)));
+      return invalid;
+    }
+    fn_call_node->atomic_failure_order = failure_order;
+  }
+  if (!ok) {
+    return invalid;
+  }
+  return id == BuiltinFnIdAtomicStore ? g->builtin_types.entry_void : type;
+}
+
+static TypeTableEntry *analyze_builtin_fn_call_expr(
+    CodeGen *g, BlockContext *context, TypeTableEntry *expected_type,
+    AstNode *node) {
+  Buf *name = &node->data.fn_call_expr.fn_ref_expr->data.symbol;
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  auto entry = g->builtin_fn_table.maybe_get(name);
+  BuiltinFnEntry *builtin_fn = entry ? entry->value : nullptr;
+  if (!builtin_fn) {
+    add_node_error(g, node, buf_sprintf("invalid builtin function: `@%s`",
+                                        buf_ptr(name)));
+  } else if (builtin_fn->param_count >= 0 &&
+             builtin_fn->param_count != params->length) {
+    add_node_error(
+        g, node,
+        buf_sprintf("wrong number of argument, expected %d, got `%d`",
+                    builtin_fn->param_count, params->length));
+    builtin_fn = nullptr;
+  } else if (builtin_fn->id == BuiltinFnIdShuffle && params->length < 3) {
+    add_node_error(g, node,
+                   buf_sprintf("`@%s` expects two vectors and at least one "
+                               "index",
+                               buf_ptr(name)));
+    builtin_fn = nullptr;
+  } else if (builtin_fn->id == BuiltinFnIdIntrinsic && params->length < 1) {
+    add_node_error(g, node,
+                   buf_sprintf("`@%s` expects the name of an llvm intrinsic",
+                               buf_ptr(name)));
+    builtin_fn = nullptr;
+  }
+  if (!builtin_fn) {
+    for (int i = 0; i < params->length; i += 1) {
+      analyze_expression(g, context, nullptr, params->at(i));
+    }
+    return g->builtin_types.entry_invalid;
+  }
+
+  assert(!node->codegen_node);
+  node->codegen_node = allocate<CodeGenNode>(1);
+  node->codegen_node->data.fn_call_node.builtin_fn = builtin_fn;
+
+  TypeTableEntry *invalid = g->builtin_types.entry_invalid;
+  switch (builtin_fn->id) {
+  case BuiltinFnIdSplat:
+  case BuiltinFnIdVectorLoad: {
+    // the vector type comes from the context: `const v: vector(4, f32) = ...`
+    if (!expected_type || expected_type->id != TypeTableEntryIdVector) {
+      add_node_error(g, node,
+                     buf_sprintf("unable to infer vector type for `@%s`",
+                                 buf_ptr(name)));
+      analyze_expression(g, context, nullptr, params->at(0));
+      return invalid;
+    }
+    TypeTableEntry *elem_type = expected_type->vector_child;
+    if (builtin_fn->id == BuiltinFnIdSplat) {
+      TypeTableEntry *type =
+          analyze_expression(g, context, elem_type, params->at(0));
+      check_type_compatiblity(g, params->at(0), elem_type, type);
+      return expected_type;
+    }
+    TypeTableEntry *ptr_type =
+        analyze_expression(g, context, nullptr, params->at(0));
+    if (ptr_type->id == TypeTableEntryIdInvalid) {
+      return invalid;
+    } else if (ptr_type->id != TypeTableEntryIdPointer ||
+               ptr_type->pointer_child != elem_type) {
+      add_node_error(g, params->at(0),
+                     buf_sprintf("expected pointer to `%s`, got `%s`",
+                                 buf_ptr(&elem_type->name),
+                                 buf_ptr(&ptr_type->name)));
+      return invalid;
+    }
+    return expected_type;
+  }
+  case BuiltinFnIdShuffle: {
+    TypeTableEntry *type =
+        analyze_vector_operand(g, context, nullptr, params->at(0));
+    TypeTableEntry *other_type =
+        analyze_expression(g, context, type, params->at(1));
+    check_type_compatiblity(g, params->at(1), type, other_type);
+    int index_count = params->length - 2;
+    for (int i = 2; i < params->length; i += 1) {
+      AstNode *index_node = params->at(i);
+      if (index_node->type != NodeTypeNumberLiteral) {
+        add_node_error(g, index_node,
+                       buf_sprintf("shuffle index must be an integer literal"));
+        analyze_expression(g, context, nullptr, index_node);
+        continue;
+      }
+      analyze_expression(g, context, g->builtin_types.entry_i32, index_node);
+      long index = strtol(buf_ptr(&index_node->data.number), nullptr, 10);
+      if (type->id == TypeTableEntryIdVector &&
+          index >= 2 * (long)type->vector_len) {
+        add_node_error(g, index_node,
+                       buf_sprintf("shuffle index %ld out of range for two "
+                                   "vectors of length %d",
+                                   index, type->vector_len));
+      }
+    }
+    if (type->id == TypeTableEntryIdInvalid) {
+      return invalid;
+    }
+    return get_vector_type(g, type->vector_child, index_count);
+  }
+  case BuiltinFnIdSlice: {
+    TypeTableEntry *ptr_type =
+        analyze_expression(g, context, nullptr, params->at(0));
+    TypeTableEntry *len_type = analyze_expression(
+        g, context, g->builtin_types.entry_usize, params->at(1));
+    if (len_type->id != TypeTableEntryIdInt &&
+        len_type->id != TypeTableEntryIdInvalid) {
+      add_node_error(g, params->at(1),
+                     buf_sprintf("slice length must be an integer, got `%s`",
+                                 buf_ptr(&len_type->name)));
+    }
+    if (ptr_type->id == TypeTableEntryIdInvalid) {
+      return invalid;
+    } else if (ptr_type->id != TypeTableEntryIdPointer ||
+               ptr_type->pointer_child->id == TypeTableEntryIdVoid) {
+      add_node_error(g, params->at(0),
+                     buf_sprintf("expected pointer, got `%s`",
+                                 buf_ptr(&ptr_type->name)));
+      return invalid;
+    }
+    // a pointer to an array slices its elements
+    TypeTableEntry *child_type = ptr_type->pointer_child;
+    if (child_type->id == TypeTableEntryIdArray) {
+      child_type = child_type->array_child;
+    }
+    return get_slice_type(g, child_type, ptr_type->pointer_is_const);
+  }
+  case BuiltinFnIdIntrinsic:
+    return analyze_intrinsic_call(g, context, node);
+  case BuiltinFnIdAtomicLoad:
+  case BuiltinFnIdAtomicStore:
+  case BuiltinFnIdAtomicRmw:
+  case BuiltinFnIdCmpxchg:
+  case BuiltinFnIdFence:
+    return analyze_atomic_call(g, context, node);
+  case BuiltinFnIdComptime: {
+    TypeTableEntry *type =
+        analyze_expression(g, context, expected_type, params->at(0));
+    if (type->id == TypeTableEntryIdInvalid) {
+      return invalid;
+    } else if (!type_has_const_value(type)) {
+      add_node_error(g, node,
+                     buf_sprintf("`@comptime` cannot produce a value of type "
+                                 "`%s`",
+                                 buf_ptr(&type->name)));
+      return invalid;
+    }
+    g->comptime_calls.append(node);
+    return type;
+  }
+  case BuiltinFnIdVectorStore: {
+    TypeTableEntry *ptr_type =
+        analyze_expression(g, context, nullptr, params->at(0));
+    TypeTableEntry *type =
+        analyze_vector_operand(g, context, nullptr, params->at(1));
+    if (ptr_type->id == TypeTableEntryIdInvalid ||
+        type->id == TypeTableEntryIdInvalid) {
+      return invalid;
+    } else if (ptr_type->id != TypeTableEntryIdPointer ||
+               ptr_type->pointer_child != type->vector_child) {
+      add_node_error(g, params->at(0),
+                     buf_sprintf("expected pointer to `%s`, got `%s`",
+                                 buf_ptr(&type->vector_child->name),
+                                 buf_ptr(&ptr_type->name)));
+      return invalid;
+    } else if (ptr_type->pointer_is_const) {
+      add_node_error(g, params->at(0),
+                     buf_sprintf("cannot store through const pointer `%s`",
+                                 buf_ptr(&ptr_type->name)));
+      return invalid;
+    }
+    return g->builtin_types.entry_void;
+  }
+  case BuiltinFnIdReduceAdd:
+  case BuiltinFnIdReduceMul:
+  case BuiltinFnIdReduceMin:
+  case BuiltinFnIdReduceMax:
+  case BuiltinFnIdReduceAnd:
+  case BuiltinFnIdReduceOr:
+  case BuiltinFnIdReduceXor: {
+    TypeTableEntry *type =
+        analyze_vector_operand(g, context, nullptr, params->at(0));
+    if (type->id == TypeTableEntryIdInvalid) {
+      return invalid;
+    }
+    TypeTableEntry *elem_type = type->vector_child;
+    bool is_bitwise = builtin_fn->id == BuiltinFnIdReduceAnd ||
+                      builtin_fn->id == BuiltinFnIdReduceOr ||
+                      builtin_fn->id == BuiltinFnIdReduceXor;
+    bool allowed = is_bitwise ? (elem_type->id == TypeTableEntryIdInt ||
+                                 elem_type->id == TypeTableEntryIdBool)
+                              : type_is_numeric(elem_type);
+    if (!allowed) {
+      add_node_error(g, node, buf_sprintf("`@%s` not allowed on type `%s`",
+                                          buf_ptr(name),
+                                          buf_ptr(&type->name)));
+      return invalid;
+    }
+    return elem_type;
+  }
+  }
+  jane_unreachable();
+}
+
+uint32_t generic_fn_key_hash(GenericFnKey *key) {
+  // fnv over the pointers; types are unique, so identity is equality
+  uint32_t result = 2166136261u;
+  result = (result ^ (uint32_t)(uintptr_t)key->fn_entry) * 16777619u;
+  for (int i = 0; i < key->type_arg_count; i += 1) {
+    result = (result ^ (uint32_t)(uintptr_t)key->type_args[i]) * 16777619u;
+  }
+  return result;
+}
+
+bool generic_fn_key_eql(GenericFnKey *a, GenericFnKey *b) {
+  if (a->fn_entry != b->fn_entry || a->type_arg_count != b->type_arg_count) {
+    return false;
+  }
+  for (int i = 0; i < a->type_arg_count; i += 1) {
+    if (a->type_args[i] != b->type_args[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool type_mentions_generic_param(AstNodeFnProto *fn_proto,
+                                        AstNode *type_node) {
+  for (int i = 0; i < fn_proto->generic_params.length; i += 1) {
+    Buf *name = &fn_proto->generic_params.at(i)->data.symbol;
+    if (type_mentions_name(type_node, name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// binds the type parameters named in `type_node` by matching it against the
+// type of an argument. a mismatch binds nothing and is reported as a type
+// mismatch once the instance's parameter types are known.
+static void deduce_type_args(AstNodeFnProto *fn_proto, AstNode *type_node,
+                             TypeTableEntry *actual_type,
+                             TypeTableEntry **type_args) {
+  if (actual_type->id == TypeTableEntryIdInvalid ||
+      actual_type->id == TypeTableEntryIdUnreachable) {
+    return;
+  }
+  AstNode *child_type_node = type_node->data.type.child_type;
+  switch (type_node->data.type.type) {
+  case AstNodeTypeTypePrimitive: {
+    int index =
+        find_generic_param(fn_proto, &type_node->data.type.primitive_name);
+    if (index >= 0 && !type_args[index]) {
+      type_args[index] = actual_type;
+    }
+    return;
+  }
+  case AstNodeTypeTypePointer:
+    if (actual_type->id == TypeTableEntryIdPointer &&
+        actual_type->pointer_is_const == type_node->data.type.is_const) {
+      deduce_type_args(fn_proto, child_type_node, actual_type->pointer_child,
+                       type_args);
+    }
+    return;
+  case AstNodeTypeTypeVector:
+    if (actual_type->id == TypeTableEntryIdVector) {
+      deduce_type_args(fn_proto, child_type_node, actual_type->vector_child,
+                       type_args);
+    }
+    return;
+  case AstNodeTypeTypeArray:
+    if (actual_type->id == TypeTableEntryIdArray) {
+      deduce_type_args(fn_proto, child_type_node, actual_type->array_child,
+                       type_args);
+    }
+    return;
+  case AstNodeTypeTypeSlice:
+    if (actual_type->id == TypeTableEntryIdSlice) {
+      TypeTableEntry *ptr_type = actual_type->struct_fields[0].type_entry;
+      if (ptr_type->pointer_is_const == type_node->data.type.is_const) {
+        deduce_type_args(fn_proto, child_type_node, ptr_type->pointer_child,
+                         type_args);
+      }
+    }
+    return;
+  }
+  jane_unreachable();
+}
+
+static const int max_instance_depth = 64;
+
+// one instance per distinct list of type arguments. the instance is a copy
+// of the generic definition, analyzed and generated like any other function.
+static FnTableEntry *get_generic_instance(CodeGen *g, BlockContext *context,
+                                          AstNode *call_node,
+                                          FnTableEntry *generic_fn,
+                                          TypeTableEntry **type_args) {
+  AstNodeFnProto *generic_proto = &generic_fn->proto_node->data.fn_proto;
+  GenericFnKey key = {generic_fn, type_args,
+                      generic_proto->generic_params.length};
+  auto entry = g->generic_instance_table.maybe_get(&key);
+  if (entry) {
+    return entry->value;
+  }
+  FnTableEntry *caller = context->root->fn_entry;
+  int instance_depth = caller ? caller->instance_depth + 1 : 1;
+  if (instance_depth > max_instance_depth) {
+    add_node_error(g, call_node,
+                   buf_sprintf("instances of `%s` are nested more than %d "
+                               "deep",
+                               buf_ptr(&generic_proto->name),
+                               max_instance_depth));
+    return nullptr;
+  }
+
+  AstNode *fn_def_node = ast_clone_subtree(generic_fn->fn_def_node);
+  AstNode *proto_node = fn_def_node->data.fn_def.fn_proto;
+  Buf *name = &proto_node->data.fn_proto.name;
+  buf_append_char(name, '<');
+  for (int i = 0; i < key.type_arg_count; i += 1) {
+    if (i > 0) {
+      buf_append_str(name, ", ");
+    }
+    buf_append_buf(name, &type_args[i]->name);
+  }
+  buf_append_char(name, '>');
+
+  FnTableEntry *instance = allocate<FnTableEntry>(1);
+  instance->import_entry = generic_fn->import_entry;
+  instance->proto_node = proto_node;
+  instance->fn_def_node = fn_def_node;
+  instance->internal_linkage = true;
+  instance->calling_convention = LLVMFastCallConv;
+  instance->generic_args = type_args;
+  instance->instance_depth = instance_depth;
+  instance->fn_index = g->fn_protos.length;
+  g->fn_protos.append(instance);
+  // the body is analyzed along with the rest of fn_defs
+  g->fn_defs.append(instance);
+  GenericFnKey *stored_key = allocate<GenericFnKey>(1);
+  *stored_key = key;
+  g->generic_instance_table.put(stored_key, instance);
+  resolve_function_proto(g, proto_node, instance);
+  return instance;
+}
+
+// analyzes the arguments that decide the type parameters, recording their
+// types in `arg_types`, and returns the instance they select
+static FnTableEntry *resolve_generic_call(CodeGen *g, BlockContext *context,
+                                          AstNode *node,
+                                          FnTableEntry *generic_fn,
+                                          TypeTableEntry **arg_types) {
+  AstNodeFnProto *fn_proto = &generic_fn->proto_node->data.fn_proto;
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  int param_count = min(params->length, fn_proto->params.length);
+  TypeTableEntry **type_args =
+      allocate<TypeTableEntry *>(fn_proto->generic_params.length);
+  for (int pass = 0; pass < 2; pass += 1) {
+    for (int i = 0; i < param_count; i += 1) {
+      AstNode *arg = params->at(i);
+      AstNode *type_node = fn_proto->params.at(i)->data.param_decl.type;
+      if (arg_types[i] || !type_mentions_generic_param(fn_proto, type_node)) {
+        continue;
+      }
+      if (is_number_literal_arg(arg)) {
+        // literals take their default type, and only for a parameter typed
+        // exactly `T` with `T` still unbound
+        if (pass == 0 ||
+            type_node->data.type.type != AstNodeTypeTypePrimitive ||
+            type_args[find_generic_param(
+                fn_proto, &type_node->data.type.primitive_name)]) {
+          continue;
+        }
+      }
+      arg_types[i] = analyze_expression(g, context, nullptr, arg);
+      deduce_type_args(fn_proto, type_node, arg_types[i], type_args);
+    }
+  }
+  bool ok = true;
+  for (int i = 0; i < fn_proto->generic_params.length; i += 1) {
+    if (!type_args[i]) {
+      add_node_error(g, node,
+                     buf_sprintf("unable to infer type parameter `%s` of `%s`",
+                                 buf_ptr(&fn_proto->generic_params.at(i)
+                                              ->data.symbol),
+                                 buf_ptr(&fn_proto->name)));
+      ok = false;
+    }
+  }
+  if (!ok) {
+    deallocate(type_args, fn_proto->generic_params.length);
+    return nullptr;
+  }
+  return get_generic_instance(g, context, node, generic_fn, type_args);
+}
+
+static bool is_asm_operand_type(TypeTableEntry *type) {
+  return type->id == TypeTableEntryIdInt || type->id == TypeTableEntryIdFloat ||
+         type->id == TypeTableEntryIdPointer ||
+         type->id == TypeTableEntryIdVector;
+}
+
+// the constraint string is the prototype: its output decides whether there
+// is a result and its inputs the operand count
+static TypeTableEntry *analyze_asm_expr(CodeGen *g, BlockContext *context,
+                                        AstNode *node) {
+  AstNodeAsmExpr *asm_expr = &node->data.asm_expr;
+  resolve_type(g, asm_expr->return_type, context->root->fn_entry);
+  TypeTableEntry *return_type =
+      asm_expr->return_type->codegen_node->data.type_node.entry;
+  int output_count = 0;
+  int input_count = 0;
+  Buf *constraints = &asm_expr->constraints;
+  for (int i = 0; i < buf_len(constraints); i += 1) {
+    if (i > 0 && buf_ptr(constraints)[i - 1] != ',') {
+      continue;
+    }
+    char c = buf_ptr(constraints)[i];
+    if (c == '=') {
+      output_count += 1;
+    } else if (c != '~') {
+      input_count += 1;
+    }
+  }
+  bool ok = return_type->id != TypeTableEntryIdInvalid;
+  if (output_count > 1) {
+    add_node_error(g, node,
+                   buf_sprintf("asm can have at most one output, got %d",
+                               output_count));
+    ok = false;
+  } else if (ok && output_count == 1 &&
+             !is_asm_operand_type(return_type)) {
+    add_node_error(g, asm_expr->return_type,
+                   buf_sprintf("asm cannot produce a value of type `%s`",
+                               buf_ptr(&return_type->name)));
+    ok = false;
+  } else if (ok && output_count == 0 &&
+             return_type->id != TypeTableEntryIdVoid) {
+    add_node_error(g, asm_expr->return_type,
+                   buf_sprintf("asm result of type `%s` needs an output "
+                               "constraint",
+                               buf_ptr(&return_type->name)));
+    ok = false;
+  }
+  JaneList<AstNode *> *operands = &asm_expr->operands;
+  if (input_count != operands->length) {
+    add_node_error(g, node,
+                   buf_sprintf("asm constraints name %d inputs, got %d "
+                               "operands",
+                               input_count, operands->length));
+    ok = false;
+  }
+  for (int i = 0; i < operands->length; i += 1) {
+    AstNode *operand = operands->at(i);
+    TypeTableEntry *type = analyze_expression(g, context, nullptr, operand);
+    if (type->id == TypeTableEntryIdInvalid) {
+      ok = false;
+    } else if (!is_asm_operand_type(type)) {
+      add_node_error(g, operand,
+                     buf_sprintf("`%s` cannot be an asm operand",
+                                 buf_ptr(&type->name)));
+      ok = false;
+    }
+  }
+  return ok ? return_type : g->builtin_types.entry_invalid;
+}
+
+static TypeTableEntry *analyze_fn_call_expr(CodeGen *g, BlockContext *context,
+                                            TypeTableEntry *expected_type,
+                                            AstNode *node) {
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  Buf *name = hack_get_fn_call_name(g, node->data.fn_call_expr.fn_ref_expr);
+  auto entry = g->fn_table.maybe_get(name);
+  // types of the arguments analyzed while resolving a generic call
+  TypeTableEntry **arg_types = allocate<TypeTableEntry *>(params->length);
+  FnTableEntry *fn_table_entry = nullptr;
+  if (!entry) {
+    add_node_error(g, node,
+                   buf_sprintf("undefined function: %s", buf_ptr(name)));
+  } else if (entry->value->is_generic) {
+    fn_table_entry =
+        resolve_generic_call(g, context, node, entry->value, arg_types);
+  } else {
+    fn_table_entry = entry->value;
+  }
+  if (!fn_table_entry) {
+    for (int i = 0; i < params->length; i += 1) {
+      if (!arg_types[i]) {
+        analyze_expression(g, context, nullptr, params->at(i));
+      }
+    }
+    deallocate(arg_types, params->length);
+    return g->builtin_types.entry_invalid;
+  }
+
+  assert(!node->codegen_node);
+  node->codegen_node = allocate<CodeGenNode>(1);
+  node->codegen_node->data.fn_call_node.fn_entry = fn_table_entry;
+  assert(fn_table_entry->proto_node->type == NodeTypeFnProto);
+  AstNodeFnProto *fn_proto = &fn_table_entry->proto_node->data.fn_proto;
+  int expected_param_count = fn_proto->params.length;
+  int actual_param_count = params->length;
+  if (expected_param_count != actual_param_count) {
+    add_node_error(
+        g, node,
+        buf_sprintf("wrong number of argument, expected %d, got `%d`",
+                    expected_param_count, actual_param_count));
+  }
+  for (int i = 0; i < params->length; i += 1) {
+    AstNode *child = params->at(i);
+    TypeTableEntry *expected_param_type = nullptr;
+    if (i < fn_proto->params.length) {
+      AstNode *param_decl_node = fn_proto->params.at(i);
+      assert(param_decl_node->type == NodeTypeParamDecl);
+      AstNode *param_type_node = param_decl_node->data.param_decl.type;
+      if (param_type_node->codegen_node) {
+        expected_param_type =
+            param_type_node->codegen_node->data.type_node.entry;
+      }
+    }
+    if (!arg_types[i]) {
+      analyze_expression(g, context, expected_param_type, child);
+    } else if (expected_param_type) {
+      check_type_compatiblity(g, child, expected_param_type, arg_types[i]);
+    }
+  }
+  deallocate(arg_types, params->length);
+  TypeTableEntry *return_type =
+      fn_proto->return_type->codegen_node->data.type_node.entry;
+  if (expected_type) {
+    check_type_compatiblity(g, node, expected_type, return_type);
+  }
+  return return_type;
+}
+
+// llvm only guarantees a tail call when the caller's frame can be reused
+// as is: same calling convention and identical prototypes
+static void check_tail_call(CodeGen *g, BlockContext *context,
+                            AstNode *node) {
+  AstNode *call_node = node->data.return_expr.expression;
+  if (!call_node || call_node->type != NodeTypeFnCallExpr ||
+      call_node->data.fn_call_expr.is_builtin) {
+    add_node_error(g, node,
+                   buf_sprintf("`return tail` requires a function call"));
+    return;
+  }
+  if (!call_node->codegen_node) {
+    // the callee was not found
+    return;
+  }
+  FnTableEntry *caller = context->root->fn_entry;
+  FnTableEntry *callee = call_node->codegen_node->data.fn_call_node.fn_entry;
+  AstNodeFnProto *caller_proto = &caller->proto_node->data.fn_proto;
+  AstNodeFnProto *callee_proto = &callee->proto_node->data.fn_proto;
+  if (caller->calling_convention != callee->calling_convention) {
+    add_node_error(g, node,
+                   buf_sprintf("tail call to `%s` requires matching calling "
+                               "conventions",
+                               buf_ptr(&callee_proto->name)));
+    return;
+  }
+  bool same_prototype =
+      caller_proto->params.length == callee_proto->params.length &&
+      caller_proto->return_type->codegen_node->data.type_node.entry ==
+          callee_proto->return_type->codegen_node->data.type_node.entry;
+  for (int i = 0; same_prototype && i < caller_proto->params.length; i += 1) {
+    AstNode *caller_type = caller_proto->params.at(i)->data.param_decl.type;
+    AstNode *callee_type = callee_proto->params.at(i)->data.param_decl.type;
+    same_prototype = caller_type->codegen_node->data.type_node.entry ==
+                     callee_type->codegen_node->data.type_node.entry;
+  }
+  if (!same_prototype) {
+    add_node_error(g, node,
+                   buf_sprintf("tail call to `%s` requires it to have the "
+                               "same parameter and return types as `%s`",
+                               buf_ptr(&callee_proto->name),
+                               buf_ptr(&caller_proto->name)));
+  }
+}
+
+static TypeTableEntry *analyze_expression(CodeGen *g, BlockContext *context,
+                                          TypeTableEntry *expected_type,
+                                          AstNode *node) {
+  TypeTableEntry *return_type = nullptr;
+  switch (node->type) {
+  case NodeTypeBlock: {
+    BlockContext *child_context = new_block_context(node, context);
+    return_type = g->builtin_types.entry_void;
+    for (int i = 0; i < node->data.block.statements.length; i += 1) {
+      AstNode *child = node->data.block.statements.at(i);
+      if (return_type == g->builtin_types.entry_unreachable) {
+        add_node_error(g, child, buf_sprintf("unreachable code"));
+        break;
+      }
+      return_type = analyze_expression(g, child_context, nullptr, child);
+    }
+    break;
+  }
+  case NodeTypeReturnExpr: {
+    if (context->root->node->type != NodeTypeFnDef) {
+      add_node_error(g, node, buf_sprintf("return outside of a function"));
+      if (node->data.return_expr.expression) {
+        analyze_expression(g, context, nullptr,
+                           node->data.return_expr.expression);
+      }
+      return_type = g->builtin_types.entry_unreachable;
+      break;
+    }
+    TypeTableEntry *expected_return_type = get_return_type(context);
+    if (expected_return_type == g->builtin_types.entry_unreachable) {
+      add_node_error(
+          g, node,
+          buf_sprintf("return statement in function with unreachable return "
+                      "type"));
+    }
+    TypeTableEntry *actual_return_type;
+    if (node->data.return_expr.expression) {
+      actual_return_type = analyze_expression(
+          g, context, expected_return_type, node->data.return_expr.expression);
+    } else {
+      actual_return_type = g->builtin_types.entry_void;
+    }
+
+    if (actual_return_type == g->builtin_types.entry_unreachable) {
+      add_node_error(g, node, buf_sprintf("returning is unreachable"));
+      actual_return_type = g->builtin_types.entry_invalid;
+    }
+    check_type_compatiblity(g, node, expected_return_type, actual_return_type);
+    if (node->data.return_expr.is_tail) {
+      check_tail_call(g, context, node);
+    }
+    return_type = g->builtin_types.entry_unreachable;
+    break;
+  }
+  case NodeTypeVariableDeclaration:
+    return_type = analyze_variable_declaration(g, context, node);
+    break;
+  case NodeTypeBinOpExpr:
+    return_type = analyze_bin_op_expr(g, context, expected_type, node);
+    break;
+  case NodeTypeIfExpr: {
+    AstNodeIfExpr *if_expr = &node->data.if_expr;
+    BranchNode *branch_node = alloc_branch_node(node);
+    branch_node->hint = resolve_branch_hint(g, if_expr->directives);
+    analyze_condition(g, context, if_expr->condition);
+    TypeTableEntry *then_type =
+        analyze_expression(g, context, nullptr, if_expr->then_block);
+    TypeTableEntry *else_type = g->builtin_types.entry_void;
+    if (if_expr->else_node) {
+      else_type = analyze_expression(g, context, nullptr, if_expr->else_node);
+    }
+    if (then_type == g->builtin_types.entry_unreachable &&
+        else_type == g->builtin_types.entry_unreachable) {
+      return_type = g->builtin_types.entry_unreachable;
+    } else {
+      return_type = g->builtin_types.entry_void;
+    }
+    break;
+  }
+  case NodeTypeWhileExpr: {
+    AstNodeWhileExpr *while_expr = &node->data.while_expr;
+    BranchNode *branch_node = alloc_branch_node(node);
+    branch_node->hint = resolve_branch_hint(g, while_expr->directives);
+    BlockContext *loop_context = new_block_context(node, context);
+    analyze_condition(g, loop_context, while_expr->condition);
+    analyze_expression(g, loop_context, nullptr, while_expr->body);
+    bool is_infinite = while_expr->condition->type == NodeTypeBoolLiteral &&
+                       while_expr->condition->data.bool_literal;
+    if (is_infinite && !branch_node->contains_break) {
+      return_type = g->builtin_types.entry_unreachable;
+    } else {
+      return_type = g->builtin_types.entry_void;
+    }
+    break;
+  }
+  case NodeTypeForExpr: {
+    AstNodeForExpr *for_expr = &node->data.for_expr;
+    BranchNode *branch_node = alloc_branch_node(node);
+    branch_node->hint = resolve_branch_hint(g, for_expr->directives);
+    // the init declaration is scoped to the loop
+    BlockContext *loop_context = new_block_context(node, context);
+    if (for_expr->init) {
+      analyze_expression(g, loop_context, nullptr, for_expr->init);
+    }
+    if (for_expr->condition) {
+      analyze_condition(g, loop_context, for_expr->condition);
+    }
+    analyze_expression(g, loop_context, nullptr, for_expr->body);
+    if (for_expr->step) {
+      analyze_expression(g, loop_context, nullptr, for_expr->step);
+    }
+    if (!for_expr->condition && !branch_node->contains_break) {
+      return_type = g->builtin_types.entry_unreachable;
+    } else {
+      return_type = g->builtin_types.entry_void;
+    }
+    break;
+  }
+  case NodeTypeBreak:
+  case NodeTypeContinue: {
+    BlockContext *loop_context = find_loop_context(context);
+    if (!loop_context) {
+      add_node_error(g, node,
+                     buf_sprintf("%s outside of loop",
+                                 node->type == NodeTypeBreak ? "break"
+                                                             : "continue"));
+    } else if (node->type == NodeTypeBreak) {
+      loop_context->node->codegen_node->data.branch_node.contains_break = true;
+    }
+    return_type = g->builtin_types.entry_unreachable;
+    break;
+  }
+  case NodeTypeBoolLiteral:
+    return_type = g->builtin_types.entry_bool;
+    break;
+  case NodeTypeFieldAccessExpr:
+    return_type = analyze_field_access_expr(g, context, node);
+    break;
+  case NodeTypeArrayAccessExpr:
+    return_type = analyze_array_access_expr(g, context, node);
+    break;
+  case NodeTypeAsmExpr:
+    return_type = analyze_asm_expr(g, context, node);
+    if (expected_type) {
+      check_type_compatiblity(g, node, expected_type, return_type);
+    }
+    break;
+  case NodeTypeFnCallExpr: {
+    if (node->data.fn_call_expr.is_builtin) {
+      return_type =
+          analyze_builtin_fn_call_expr(g, context, expected_type, node);
+      if (expected_type) {
+        check_type_compatiblity(g, node, expected_type, return_type);
+      }
+      break;
+    }
+    return_type = analyze_fn_call_expr(g, context, expected_type, node);
+    break;
+  }
+  case NodeTypeNumberLiteral:
+    return_type = analyze_number_literal(g, node, expected_type, false);
+    break;
+  case NodeTypeStringLiteral:
+    return_type = analyze_string_literal(g, node, expected_type);
+    break;
+  case NodeTypeUnreachable:
+    return_type = g->builtin_types.entry_unreachable;
+    break;
+  case NodeTypeSymbol: {
+    Buf *name = &node->data.symbol;
+    LocalVariableTableEntry *variable = find_local_variable(context, name);
+    auto global_entry =
+        variable ? nullptr : g->global_const_table.maybe_get(name);
+    if (variable) {
+      return_type = variable->type;
+    } else if (global_entry) {
+      GlobalConstEntry *global_const = global_entry->value;
+      resolve_global_const(g, global_const);
+      assert(!node->codegen_node);
+      node->codegen_node = allocate<CodeGenNode>(1);
+      node->codegen_node->data.symbol_node.global_const = global_const;
+      return_type = global_const->type;
+    } else {
+      add_node_error(g, node,
+                     buf_sprintf("use of undeclared identifier `%s`",
+                                 buf_ptr(name)));
+      return_type = g->builtin_types.entry_invalid;
+    }
+    break;
+  }
+  case NodeTypePrefixOpExpr: {
+    AstNode *operand = node->data.prefix_op_expr.primary_expr;
+    switch (node->data.prefix_op_expr.prefix_op) {
+    case PrefixOpBoolNot:
+      analyze_condition(g, context, operand);
+      return_type = g->builtin_types.entry_bool;
+      break;
+    case PrefixOpBinNot:
+      return_type = analyze_expression(g, context, expected_type, operand);
+      if (get_scalar_type(return_type)->id != TypeTableEntryIdInt &&
+          return_type->id != TypeTableEntryIdInvalid) {
+        add_node_error(g, node,
+                       buf_sprintf("operator `~` not allowed on type `%s`",
+                                   buf_ptr(&return_type->name)));
+      }
+      break;
+    case PrefixOpNegation:
+      if (operand->type == NodeTypeNumberLiteral) {
+        // checked as a negative literal so that e.g. -128 fits in i8
+        return_type = analyze_number_literal(g, operand, expected_type, true);
+        set_expr_type(operand, context, return_type);
+        break;
+      }
+      return_type = analyze_expression(g, context, expected_type, operand);
+      if (!type_is_numeric(get_scalar_type(return_type)) &&
+          return_type->id != TypeTableEntryIdInvalid) {
+        add_node_error(g, node,
+                       buf_sprintf("operator `-` not allowed on type `%s`",
+                                   buf_ptr(&return_type->name)));
+      } else if (get_scalar_type(return_type)->id == TypeTableEntryIdInt &&
+                 !get_scalar_type(return_type)->is_signed) {
+        add_node_error(g, node,
+                       buf_sprintf("negation of unsigned type `%s`",
+                                   buf_ptr(&return_type->name)));
+      }
+      break;
+    case PrefixOpAddressOf: {
+      TypeTableEntry *child_type =
+          analyze_expression(g, context, nullptr, operand);
+      return_type = g->builtin_types.entry_invalid;
+      if (child_type->id == TypeTableEntryIdInvalid) {
+        break;
+      }
+      LValueKind lvalue_kind = get_lvalue_kind(context, operand);
+      TypeTableEntry *packed_struct = get_lvalue_packed_struct(g, operand);
+      if (lvalue_kind == LValueKindNone) {
+        add_node_error(g, node,
+                       buf_sprintf("cannot take the address of an rvalue"));
+      } else if (packed_struct) {
+        add_node_error(g, node,
+                       buf_sprintf("cannot take the address of a field of "
+                                   "packed struct `%s`",
+                                   buf_ptr(&packed_struct->name)));
+      } else {
+        return_type = get_pointer_to_type(g, child_type,
+                                          lvalue_kind == LValueKindConst);
+      }
+      break;
+    }
+    case PrefixOpDereference: {
+      TypeTableEntry *pointer_type =
+          analyze_expression(g, context, nullptr, operand);
+      return_type = g->builtin_types.entry_invalid;
+      if (pointer_type->id == TypeTableEntryIdInvalid) {
+        break;
+      } else if (pointer_type->id != TypeTableEntryIdPointer ||
+                 pointer_type->pointer_child->id == TypeTableEntryIdVoid) {
+        add_node_error(g, node,
+                       buf_sprintf("cannot dereference type `%s`",
+                                   buf_ptr(&pointer_type->name)));
+      } else {
+        return_type = pointer_type->pointer_child;
+      }
+      break;
+    }
+    case PrefixOpInvalid:
+      jane_unreachable();
+    }
+    break;
+  }
+  case NodeTypeCastExpr: {
+    AstNode *type_node = node->data.cast_expr.type;
+    resolve_type(g, type_node, context->root->fn_entry);
+    TypeTableEntry *dest_type = type_node->codegen_node->data.type_node.entry;
+    TypeTableEntry *src_type = analyze_expression(
+        g, context, nullptr, node->data.cast_expr.prefix_op_expr);
+    if (!cast_allowed(src_type, dest_type)) {
+      add_node_error(g, node,
+                     buf_sprintf("invalid cast from `%s` to `%s`",
+                                 buf_ptr(&src_type->name),
+                                 buf_ptr(&dest_type->name)));
+    }
+    return_type = dest_type;
+    break;
+  }
+  case NodeTypeDirective:
+  case NodeTypeFnDecl:
+  case NodeTypeFnProto:
+  case NodeTypeParamDecl:
+  case NodeTypeType:
+  case NodeTypeRoot:
+  case NodeTypeRootExportDecl:
+  case NodeTypeExternBlock:
+  case NodeTypeFnDef:
+  case NodeTypeUse:
+  case NodeTypeStructDecl:
+  case NodeTypeStructField:
+    jane_unreachable();
+  }
+  assert(return_type);
+  set_expr_type(node, context, return_type);
+  return return_type;
+}
+
+static TypeTableEntry *analyze_variable_declaration(CodeGen *g,
+                                                   BlockContext *context,
+                                                   AstNode *node) {
+  AstNodeVariableDeclaration *variable_declaration =
+      &node->data.variable_declaration;
+  TypeTableEntry *explicit_type = nullptr;
+  if (variable_declaration->type) {
+    resolve_type(g, variable_declaration->type, context->root->fn_entry);
+    explicit_type =
+        variable_declaration->type->codegen_node->data.type_node.entry;
+  }
+  // the initializer is analyzed before the variable is in scope, so
+  // `const x = x;` refers to an outer `x` or is an error
+  TypeTableEntry *implicit_type = nullptr;
+  if (variable_declaration->expr) {
+    implicit_type = analyze_expression(g, context, explicit_type,
+                                       variable_declaration->expr);
+    if (explicit_type) {
+      check_type_compatiblity(g, node, explicit_type, implicit_type);
+    }
+  } else if (variable_declaration->is_const) {
+    add_node_error(g, node,
+                   buf_sprintf("constant `%s` must be initialized",
+                               buf_ptr(&variable_declaration->symbol)));
+  }
+  TypeTableEntry *type = explicit_type ? explicit_type : implicit_type;
+  LocalVariableTableEntry *variable =
+      add_local_variable(g, context, node, &variable_declaration->symbol, type,
+                         variable_declaration->is_const);
+
+  // blocks in the initializer of a global constant only run at compile time
+  // and need no stack slots
+  AstNode *fn_def_node = context->root->node;
+  if (fn_def_node->type == NodeTypeFnDef) {
+    fn_def_node->codegen_node->data.fn_def_node.variable_list.append(variable);
+  }
+
+  assert(!node->codegen_node);
+  node->codegen_node = allocate<CodeGenNode>(1);
+  node->codegen_node->data.var_decl_node.variable = variable;
+  return g->builtin_types.entry_void;
+}
+
+static TypeTableEntry *analyze_assignment(CodeGen *g, BlockContext *context,
+                                          AstNode *node) {
+  AstNode *lhs_node = node->data.bin_op_expr.op1;
+  TypeTableEntry *expected_rhs_type = nullptr;
+  if (lhs_node->type == NodeTypeSymbol) {
+    Buf *name = &lhs_node->data.symbol;
+    LocalVariableTableEntry *variable = find_local_variable(context, name);
+    if (!variable && g->global_const_table.maybe_get(name)) {
+      add_node_error(g, lhs_node,
+                     buf_sprintf("cannot assign to constant `%s`",
+                                 buf_ptr(name)));
+    } else if (!variable) {
+      add_node_error(g, lhs_node,
+                     buf_sprintf("use of undeclared identifier `%s`",
+                                 buf_ptr(name)));
+    } else if (variable->is_const) {
+      add_node_error(g, lhs_node,
+                     buf_sprintf("cannot assign to constant `%s`",
+                                 buf_ptr(name)));
+    } else {
+      expected_rhs_type = variable->type;
+    }
+    set_expr_type(lhs_node, context,
+                  variable ? variable->type : g->builtin_types.entry_invalid);
+  } else {
+    TypeTableEntry *lhs_type =
+        analyze_expression(g, context, nullptr, lhs_node);
+    if (lhs_type->id != TypeTableEntryIdInvalid) {
+      LValueKind lvalue_kind = get_lvalue_kind(context, lhs_node);
+      if (lvalue_kind == LValueKindNone) {
+        add_node_error(g, lhs_node, buf_sprintf("invalid assignment target"));
+      } else if (lvalue_kind == LValueKindConst) {
+        add_node_error(g, lhs_node,
+                       buf_sprintf("cannot assign to constant location"));
+      } else {
+        expected_rhs_type = lhs_type;
+      }
+    }
+  }
+  TypeTableEntry *rhs_type = analyze_expression(
+      g, context, expected_rhs_type, node->data.bin_op_expr.op2);
+  if (expected_rhs_type) {
+    check_type_compatiblity(g, node, expected_rhs_type, rhs_type);
+  }
+  return g->builtin_types.entry_void;
+}
+
+static void check_fn_def_control_flow(CodeGen *g, AstNode *node,
+                                      TypeTableEntry *body_type) {
+  assert(node->type == NodeTypeFnDef);
+  FnDefNode *codegen_fn_def = &node->codegen_node->data.fn_def_node;
+  AstNode *proto_node = node->data.fn_def.fn_proto;
+  assert(proto_node->type == NodeTypeFnProto);
+  AstNode *return_type_node = proto_node->data.fn_proto.return_type;
+  assert(return_type_node->codegen_node);
+  TypeTableEntry *type_entry =
+      return_type_node->codegen_node->data.type_node.entry;
+  assert(type_entry);
+
+  // analysis types every statement that cannot fall through as unreachable,
+  // so the body's type says whether control can reach the closing brace.
+  if (body_type == g->builtin_types.entry_unreachable) {
+    return;
+  }
+  if (type_entry == g->builtin_types.entry_void) {
+    codegen_fn_def->add_implicit_return = true;
+  } else if (type_entry != g->builtin_types.entry_invalid) {
+    add_node_error(g, node,
+                   buf_sprintf("control reaches end of non-void function"));
+  }
+}
+
+void analyze_fn_body(CodeGen *g, FnTableEntry *fn_table_entry) {
+  if (fn_table_entry->body_analyzed || fn_table_entry->body_analyzing) {
+    return;
+  }
+  fn_table_entry->body_analyzing = true;
+  AstNode *node = fn_table_entry->fn_def_node;
+  {
+    AstNode *fn_proto_node = node->data.fn_def.fn_proto;
+    assert(fn_proto_node->type == NodeTypeFnProto);
+    AstNodeFnProto *fn_proto = &fn_proto_node->data.fn_proto;
+    assert(!node->codegen_node);
+    node->codegen_node = allocate<CodeGenNode>(1);
+    BlockContext *context = new_block_context(node, nullptr);
+    context->fn_entry = fn_table_entry;
+    for (int i = 0; i < fn_proto->params.length; i += 1) {
       AstNode *param_decl_node = fn_proto->params.at(i);
       assert(param_decl_node->type == NodeTypeParamDecl);
+      AstNodeParamDecl *param_decl = &param_decl_node->data.param_decl;
+      TypeTableEntry *type =
+          param_decl->type->codegen_node->data.type_node.entry;
+      LocalVariableTableEntry *variable = add_local_variable(
+          g, context, param_decl_node, &param_decl->name, type, true);
+      variable->arg_index = i;
+      node->codegen_node->data.fn_def_node.variable_list.append(variable);
     }
-    check_fn_def_control_flow(g, node);
-    BlockContext context;
-    context.node = node;
-    context.root = &context;
-    context.parent = nullptr;
     TypeTableEntry *expected_type =
         fn_proto->return_type->codegen_node->data.type_node.entry;
-    analyze_expression(g, &context, expected_type, node->data.fn_def.body);
+    TypeTableEntry *body_type =
+        analyze_expression(g, context, expected_type, node->data.fn_def.body);
+    check_fn_def_control_flow(g, node, body_type);
+  }
+  fn_table_entry->body_analyzing = false;
+  fn_table_entry->body_analyzed = true;
+}
+
+void resolve_global_const(CodeGen *g, GlobalConstEntry *global_const) {
+  if (global_const->type) {
+    return;
+  }
+  AstNode *decl_node = global_const->decl_node;
+  if (global_const->resolving) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("constant `%s` depends on itself",
+                               buf_ptr(global_const->name)));
+    global_const->type = g->builtin_types.entry_invalid;
+    return;
+  }
+  global_const->resolving = true;
+  AstNodeVariableDeclaration *variable_declaration =
+      &decl_node->data.variable_declaration;
+  TypeTableEntry *explicit_type = nullptr;
+  if (variable_declaration->type) {
+    resolve_type(g, variable_declaration->type, nullptr);
+    explicit_type =
+        variable_declaration->type->codegen_node->data.type_node.entry;
+  }
+  TypeTableEntry *type = explicit_type;
+  if (!variable_declaration->expr) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("constant `%s` must be initialized",
+                               buf_ptr(global_const->name)));
+  } else {
+    BlockContext *context = new_block_context(decl_node, nullptr);
+    TypeTableEntry *implicit_type = analyze_expression(
+        g, context, explicit_type, variable_declaration->expr);
+    if (explicit_type) {
+      check_type_compatiblity(g, decl_node, explicit_type, implicit_type);
+    } else {
+      type = implicit_type;
+    }
+  }
+  if (type && type->id != TypeTableEntryIdInvalid &&
+      !type_has_const_value(type)) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("constant `%s` of type `%s` cannot be "
+                               "evaluated at compile time",
+                               buf_ptr(global_const->name),
+                               buf_ptr(&type->name)));
+    type = g->builtin_types.entry_invalid;
+  }
+  global_const->resolving = false;
+  // a dependency loop already reported an error and set the type
+  if (!global_const->type) {
+    global_const->type = type ? type : g->builtin_types.entry_invalid;
+  }
+}
+
+static void analyze_top_level_declaration(CodeGen *g, AstNode *node) {
+  switch (node->type) {
+  case NodeTypeFnDef: {
+    if (node->codegen_node && node->codegen_node->data.fn_def_node.skip) {
+      break;
+    }
+    Buf *name = &node->data.fn_def.fn_proto->data.fn_proto.name;
+    FnTableEntry *fn_table_entry = g->fn_table.get(name);
+    // generic bodies are analyzed once per instance
+    if (!fn_table_entry->is_generic) {
+      analyze_fn_body(g, fn_table_entry);
+    }
+  } break;
+  case NodeTypeVariableDeclaration: {
+    auto entry =
+        g->global_const_table.get(&node->data.variable_declaration.symbol);
+    if (entry->decl_node == node) {
+      resolve_global_const(g, entry);
+    }
   } break;
   case NodeTypeRootExportDecl:
   case NodeTypeExternBlock:
+  case NodeTypeStructDecl:
+    // handled while previewing declarations
+    break;
   case NodeTypeUse:
     for (int i = 0; i < node->data.use.directive->length; i += 1) {
       AstNode *directive_node = node->data.use.directive->at(i);
@@ -456,41 +3003,115 @@ static void analyze_top_level_declaration(CodeGen *g, AstNode *node) {
   case NodeTypeSymbol:
   case NodeTypeCastExpr:
   case NodeTypePrefixOpExpr:
+  case NodeTypeBoolLiteral:
+  case NodeTypeIfExpr:
+  case NodeTypeWhileExpr:
+  case NodeTypeForExpr:
+  case NodeTypeBreak:
+  case NodeTypeContinue:
+  case NodeTypeStructField:
+  case NodeTypeFieldAccessExpr:
+  case NodeTypeArrayAccessExpr:
+  case NodeTypeAsmExpr:
     jane_unreachable();
   }
 }
 
-static void analyze_root(CodeGen *g, ImportTableEntry *import, AstNode *node) {
+static void preview_global_const(CodeGen *g, ImportTableEntry *import,
+                                 AstNode *node) {
+  Buf *name = &node->data.variable_declaration.symbol;
+  if (g->global_const_table.maybe_get(name)) {
+    add_node_error(g, node,
+                   buf_sprintf("redefinition of `%s`", buf_ptr(name)));
+    return;
+  }
+  GlobalConstEntry *global_const = allocate<GlobalConstEntry>(1);
+  global_const->name = name;
+  global_const->decl_node = node;
+  global_const->import = import;
+  g->global_const_table.put(name, global_const);
+  g->global_consts.append(global_const);
+}
+
+static void preview_root_types(CodeGen *g, ImportTableEntry *import) {
+  AstNode *node = import->root;
+  assert(node->type == NodeTypeRoot);
+  for (int i = 0; i < node->data.root.top_level_decls.length; i += 1) {
+    AstNode *child = node->data.root.top_level_decls.at(i);
+    if (child->type == NodeTypeStructDecl) {
+      preview_struct_declaration(g, import, child);
+    } else if (child->type == NodeTypeVariableDeclaration) {
+      preview_global_const(g, import, child);
+    }
+  }
+}
+
+static void preview_root(CodeGen *g, ImportTableEntry *import) {
+  AstNode *node = import->root;
   assert(node->type == NodeTypeRoot);
   for (int i = 0; i < node->data.root.top_level_decls.length; i += 1) {
     AstNode *child = node->data.root.top_level_decls.at(i);
     preview_function_declarations(g, import, child);
   }
+}
 
+static void analyze_root(CodeGen *g, ImportTableEntry *import) {
+  AstNode *node = import->root;
+  assert(node->type == NodeTypeRoot);
   for (int i = 0; i < node->data.root.top_level_decls.length; i += 1) {
+    if (err_list_full(&g->errors)) {
+      return;
+    }
     AstNode *child = node->data.root.top_level_decls.at(i);
     analyze_top_level_declaration(g, child);
   }
+}
 
+void semantic_analyze(CodeGen *g) {
+  // struct names are known before any field or function signature is
+  // resolved, so declaration order between them does not matter.
+  for (int i = 0; i < g->import_list.length; i += 1) {
+    preview_root_types(g, g->import_list.at(i));
+  }
+  for (int i = 0; i < g->struct_types.length; i += 1) {
+    resolve_struct_type(g, g->struct_types.at(i));
+  }
+  // every import is previewed before any body is analyzed, so a function may
+  // call into an import that was discovered after its own file.
+  for (int i = 0; i < g->import_list.length; i += 1) {
+    preview_root(g, g->import_list.at(i));
+  }
+  for (int i = 0; i < g->import_list.length; i += 1) {
+    analyze_root(g, g->import_list.at(i));
+  }
+  // analyzing a call to a generic function appends its instance to fn_defs
+  for (int i = 0; i < g->fn_defs.length; i += 1) {
+    if (err_list_full(&g->errors)) {
+      return;
+    }
+    analyze_fn_body(g, g->fn_defs.at(i));
+  }
+  // constants are evaluated once every body they might call is analyzed.
+  // array lengths are the exception and evaluate on demand.
+  if (g->errors.msgs.length == 0) {
+    for (int i = 0; i < g->global_consts.length; i += 1) {
+      eval_global_const(g, g->global_consts.at(i));
+    }
+    for (int i = 0; i < g->comptime_calls.length; i += 1) {
+      AstNode *call_node = g->comptime_calls.at(i);
+      call_node->codegen_node->data.fn_call_node.const_val =
+          eval_const_expr(g, call_node->data.fn_call_expr.params.at(0));
+    }
+  }
+
+  AstNode *root = g->import_list.at(0)->root;
   if (!g->root_out_name) {
     add_node_error(
-        g, node,
+        g, root,
         buf_sprintf("missing export declaration and outptu name not provided"));
   } else if (g->out_type == OutTypeUnknown) {
     add_node_error(
-        g, node,
+        g, root,
         buf_sprintf("missing export declaration and export type not provided"));
   }
-}
-
-void semantic_analyze(CodeGen *g, ImportTableEntry *import_table_entry) {
-  auto it = g->import_table.entry_iterator();
-  for (;;) {
-    auto *entry = it.next();
-    if (!entry) {
-      break;
-    }
-    ImportTableEntry *import = entry->value;
-    analyze_root(g, import, import->root);
-  }
 }
\ No newline at end of file
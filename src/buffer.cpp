@@ -4,8 +4,15 @@
 #include <stdlib.h>
 
 Buf *buf_sprintf(const char *format, ...) {
-  va_list ap, ap2;
+  va_list ap;
   va_start(ap, format);
+  Buf *buf = buf_vprintf(format, ap);
+  va_end(ap);
+  return buf;
+}
+
+Buf *buf_vprintf(const char *format, va_list ap) {
+  va_list ap2;
   va_copy(ap2, ap);
   // determine the length of the formatted string
   int len1 = vsnprintf(nullptr, 0, format, ap);
@@ -19,7 +26,6 @@ Buf *buf_sprintf(const char *format, ...) {
   assert(len2 == len1);
   // cleanup the argument list
   va_end(ap2);
-  va_end(ap);
   return buf;
 }
 
@@ -37,8 +43,9 @@ void buf_appendf(Buf *buf, const char *format, ...) {
   size_t required_size = len1 + 1;
   // get the original length of the buffer
   int orig_len = buf_len(buf);
-  // resize the buffer to accomodate the new string
-  buf_resize(buf, orig_len + required_size);
+  // resize the buffer to accomodate the new string; buf_resize keeps room
+  // for the terminator vsnprintf writes
+  buf_resize(buf, orig_len + len1);
   // format the string into the buffer at the appropriate position
   int len2 = vsnprintf(buf_ptr(buf) + orig_len, required_size, format, ap2);
   assert(len2 == len1);
@@ -47,6 +54,33 @@ void buf_appendf(Buf *buf, const char *format, ...) {
   va_end(ap);
 }
 
+void buf_append_json_string(Buf *buf, const char *str) {
+  buf_append_char(buf, '"');
+  for (const char *c = str; *c; c += 1) {
+    switch (*c) {
+    case '"':
+      buf_append_str(buf, "\\\"");
+      break;
+    case '\\':
+      buf_append_str(buf, "\\\\");
+      break;
+    case '\n':
+      buf_append_str(buf, "\\n");
+      break;
+    case '\t':
+      buf_append_str(buf, "\\t");
+      break;
+    default:
+      if ((unsigned char)*c < 0x20) {
+        buf_appendf(buf, "\\u%04x", (unsigned char)*c);
+      } else {
+        buf_append_char(buf, *c);
+      }
+    }
+  }
+  buf_append_char(buf, '"');
+}
+
 bool buf_eql_buf(Buf *buf, Buf *other) {
   assert(buf->list.length);
   return buf_eql_mem(buf, buf_ptr(other), buf_len(other));
@@ -56,7 +90,7 @@ uint32_t buf_hash(Buf *buf) {
   assert(buf->list.length);
   uint32_t h = 2166136261;
   for (int i = 0; i < buf_len(buf); i += 1) {
-    h = h ^ ((uint8_t)buf->list.at(1));
+    h = h ^ ((uint8_t)buf->list.at(i));
     h = h * 1677619;
   }
   return h;
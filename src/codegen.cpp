@@ -3,12 +3,14 @@
 #include "include/analyze.hpp"
 #include "include/error.hpp"
 #include "include/hash_map.hpp"
+#include "include/interface.hpp"
 #include "include/jane_llvm.hpp"
 #include "include/os.hpp"
 #include "include/parser.hpp"
 #include "include/semantic_info.hpp"
 #include "include/util.hpp"
 
+#include <ctype.h>
 #include <errno.h>
 #include <llvm-c/Core.h>
 #include <llvm-c/Target.h>
@@ -22,6 +24,10 @@ CodeGen *codegen_crate(Buf *root_source_dir) {
   g->type_table.init(32);
   g->link_table.init(32);
   g->import_table.init(32);
+  g->builtin_fn_table.init(32);
+  g->tbaa_table.init(16);
+  g->global_const_table.init(16);
+  g->generic_instance_table.init(16);
   g->build_type = CodeGenBuildTypeDebug;
   g->root_source_dir = root_source_dir;
   return g;
@@ -37,8 +43,12 @@ void codegen_set_is_static(CodeGen *g, bool is_static) {
 
 void codegen_set_verbose(CodeGen *g, bool verbose) { g->verbose = verbose; }
 
-void codegen_set_strip(CodeGen *g, bool strip) {
-  g->strip_debug_symbols = strip;
+void codegen_set_debug_info(CodeGen *g, CodeGenDebugInfo debug_info) {
+  g->debug_info = debug_info;
+}
+
+void codegen_set_split_dwarf(CodeGen *g, bool split_dwarf) {
+  g->split_dwarf = split_dwarf;
 }
 
 void codegen_set_out_type(CodeGen *g, OutType out_type) {
@@ -49,6 +59,54 @@ void codegen_set_out_name(CodeGen *g, Buf *out_name) {
   g->root_out_name = out_name;
 }
 
+void codegen_set_target_triple(CodeGen *g, Buf *triple) {
+  g->target_triple = triple;
+}
+
+void codegen_set_max_errors(CodeGen *g, int max_errors) {
+  g->errors.max_errors = max_errors;
+}
+
+void codegen_set_diag_format(CodeGen *g, DiagFormat format) {
+  g->errors.format = format;
+}
+
+CodeGenCache *codegen_cache_create(void) {
+  CodeGenCache *cache = allocate<CodeGenCache>(1);
+  cache->parsed_files.init(32);
+  return cache;
+}
+
+void codegen_set_cache(CodeGen *g, CodeGenCache *cache) { g->cache = cache; }
+
+void codegen_set_dep_file(CodeGen *g, Buf *dep_file_path) {
+  g->dep_file_path = dep_file_path;
+}
+
+void codegen_set_interface_dir(CodeGen *g, Buf *interface_dir) {
+  g->interface_dir = interface_dir;
+}
+
+void codegen_set_function_sections(CodeGen *g, bool function_sections) {
+  g->function_sections = function_sections;
+}
+
+void codegen_set_data_sections(CodeGen *g, bool data_sections) {
+  g->data_sections = data_sections;
+}
+
+void codegen_set_gc_sections(CodeGen *g, bool gc_sections) {
+  g->gc_sections = gc_sections;
+}
+
+void codegen_set_symbol_order_file(CodeGen *g, Buf *path) {
+  g->symbol_order_file = path;
+}
+
+static void add_time_event(CodeGen *g, const char *name) {
+  g->timing_events.append({os_get_time(), name});
+}
+
 static LLVMValueRef gen_expr(CodeGen *g, AstNode *expr_node);
 
 static LLVMTypeRef to_llvm_type(AstNode *type_node) {
@@ -73,48 +131,496 @@ static bool type_is_unreachable(CodeGen *g, AstNode *type_node) {
          g->builtin_types.entry_unreachable;
 }
 
+static TypeTableEntry *get_expr_type(AstNode *node) {
+  assert(node->codegen_node);
+  assert(node->codegen_node->expr_node.type_entry);
+  return node->codegen_node->expr_node.type_entry;
+}
+
+static bool expr_is_unreachable(CodeGen *g, AstNode *node) {
+  return get_expr_type(node) == g->builtin_types.entry_unreachable;
+}
+
 static void add_debug_source_node(CodeGen *g, AstNode *node) {
+  if (g->debug_info == CodeGenDebugInfoNone) {
+    return;
+  }
   LLVMJaneSetCurrentDebugLocation(g->builder, node->line + 1, node->column + 1,
                                   g->block_scopes.last());
 }
 
-static LLVMValueRef find_or_create_string(CodeGen *g, Buf *str) {
-  auto entry = g->str_table.maybe_get(str);
-  if (entry) {
-    return entry->value;
+// orders strings by their text read backwards, so a string comes right
+// before the nearest one it is a suffix of
+static int compare_reversed(const void *a, const void *b) {
+  Buf *str_a = *(Buf *const *)a;
+  Buf *str_b = *(Buf *const *)b;
+  int len_a = buf_len(str_a);
+  int len_b = buf_len(str_b);
+  for (int i = 1; i <= len_a && i <= len_b; i += 1) {
+    unsigned char byte_a = buf_ptr(str_a)[len_a - i];
+    unsigned char byte_b = buf_ptr(str_b)[len_b - i];
+    if (byte_a != byte_b) {
+      return byte_a < byte_b ? -1 : 1;
+    }
   }
-  LLVMValueRef text = LLVMConstString(buf_ptr(str), buf_len(str), false);
-  LLVMValueRef global_value = LLVMAddGlobal(g->module, LLVMTypeOf(text), "");
+  return len_a - len_b;
+}
+
+// every string literal of the module is stored once, nul terminated, in a
+// private unnamed_addr global of alignment 1. llvm puts those in a mergeable
+// `.rodata.str1.1` section (SHF_MERGE|SHF_STRINGS), so the linker also merges
+// them across objects. a literal that is the tail of another one points into
+// it, which shares "disk full" with "error: disk full".
+static void gen_string_pool(CodeGen *g) {
+  int count = g->string_literals.length;
+  Buf **sorted = allocate<Buf *>(count);
+  for (int i = 0; i < count; i += 1) {
+    sorted[i] = g->string_literals.at(i);
+  }
+  qsort(sorted, count, sizeof(Buf *), compare_reversed);
+  LLVMTypeRef pool_type = nullptr;
+  LLVMValueRef pool_value = nullptr;
+  int pool_len = 0;
+  for (int i = count - 1; i >= 0; i -= 1) {
+    Buf *str = sorted[i];
+    int len = buf_len(str);
+    Buf *next = (i + 1 < count) ? sorted[i + 1] : nullptr;
+    bool is_tail = next && len <= buf_len(next) &&
+                   memcmp(buf_ptr(next) + buf_len(next) - len, buf_ptr(str),
+                          len) == 0;
+    if (!is_tail) {
+      LLVMValueRef text = LLVMConstString(buf_ptr(str), len, false);
+      pool_type = LLVMTypeOf(text);
+      pool_value = LLVMAddGlobal(g->module, pool_type, "");
+      LLVMSetLinkage(pool_value, LLVMPrivateLinkage);
+      LLVMSetInitializer(pool_value, text);
+      LLVMSetGlobalConstant(pool_value, true);
+      LLVMSetUnnamedAddr(pool_value, true);
+      // llvm would raise the alignment of a long string, which moves it out
+      // of the 1 byte mergeable section
+      LLVMSetAlignment(pool_value, 1);
+      pool_len = len;
+    }
+    LLVMValueRef indices[] = {
+        LLVMConstInt(LLVMInt32Type(), 0, false),
+        LLVMConstInt(LLVMInt32Type(), pool_len - len, false)};
+    g->str_table.put(str,
+                     LLVMConstInBoundsGEP2(pool_type, pool_value, indices, 2));
+  }
+  deallocate(sorted, count);
+}
+
+static LocalVariableTableEntry *get_local_variable(AstNode *node) {
+  assert(node->type == NodeTypeSymbol);
+  assert(node->codegen_node);
+  BlockContext *context = node->codegen_node->expr_node.block_context;
+  LocalVariableTableEntry *variable =
+      find_local_variable(context, &node->data.symbol);
+  assert(variable);
+  return variable;
+}
+
+static LLVMValueRef gen_const_val(CodeGen *g, ConstExprValue *val) {
+  TypeTableEntry *type = val->type;
+  switch (type->id) {
+  case TypeTableEntryIdBool:
+    return LLVMConstInt(type->type_ref, val->x_bool, false);
+  case TypeTableEntryIdInt:
+    return LLVMConstInt(type->type_ref, val->x_int, false);
+  case TypeTableEntryIdFloat:
+    return LLVMConstReal(type->type_ref, val->x_float);
+  case TypeTableEntryIdArray: {
+    int len = (int)type->array_len;
+    LLVMValueRef *elements = allocate<LLVMValueRef>(len);
+    for (int i = 0; i < len; i += 1) {
+      elements[i] = gen_const_val(g, &val->elements[i]);
+    }
+    LLVMValueRef result =
+        LLVMConstArray(type->array_child->type_ref, elements, len);
+    deallocate(elements, len);
+    return result;
+  }
+  case TypeTableEntryIdStruct: {
+    // llvm field order, with explicit padding fields left zero
+    unsigned count = LLVMCountStructElementTypes(type->type_ref);
+    LLVMValueRef *fields = allocate<LLVMValueRef>(count);
+    for (int i = 0; i < type->struct_field_count; i += 1) {
+      fields[type->struct_fields[i].gen_index] =
+          gen_const_val(g, &val->elements[i]);
+    }
+    for (unsigned i = 0; i < count; i += 1) {
+      if (!fields[i]) {
+        fields[i] =
+            LLVMConstNull(LLVMStructGetTypeAtIndex(type->type_ref, i));
+      }
+    }
+    LLVMValueRef result = LLVMConstNamedStruct(type->type_ref, fields, count);
+    deallocate(fields, count);
+    return result;
+  }
+  case TypeTableEntryIdInvalid:
+  case TypeTableEntryIdVoid:
+  case TypeTableEntryIdUnreachable:
+  case TypeTableEntryIdPointer:
+  case TypeTableEntryIdVector:
+  case TypeTableEntryIdSlice:
+    jane_unreachable();
+  }
+  jane_unreachable();
+}
+
+static LLVMValueRef gen_symbol(CodeGen *g, AstNode *node) {
+  GlobalConstEntry *global_const =
+      node->codegen_node->data.symbol_node.global_const;
+  if (global_const) {
+    return gen_const_val(g, global_const->value);
+  }
+  LocalVariableTableEntry *variable = get_local_variable(node);
+  if (variable->arg_index >= 0) {
+    return variable->value_ref;
+  }
+  add_debug_source_node(g, node);
+  return LLVMBuildLoad(g->builder, variable->value_ref, "");
+}
+
+static LLVMValueRef gen_const_global(CodeGen *g, ConstExprValue *val,
+                                     const char *name) {
+  LLVMValueRef init = gen_const_val(g, val);
+  LLVMValueRef global_value = LLVMAddGlobal(g->module, LLVMTypeOf(init), name);
   LLVMSetLinkage(global_value, LLVMPrivateLinkage);
-  LLVMSetInitializer(global_value, text);
+  LLVMSetInitializer(global_value, init);
   LLVMSetGlobalConstant(global_value, true);
   LLVMSetUnnamedAddr(global_value, true);
-  g->str_table.put(str, global_value);
+  LLVMSetAlignment(global_value, get_type_alignment(g, val->type));
   return global_value;
 }
 
-static LLVMValueRef get_variable_value(CodeGen *g, Buf *name) {
-  assert(g->cur_fn->proto_node->type == NodeTypeFnProto);
-  int param_count = g->cur_fn->proto_node->data.fn_proto.params.length;
-  for (int i = 0; i < param_count; i += 1) {
-    AstNode *param_decl_node =
-        g->cur_fn->proto_node->data.fn_proto.params.at(i);
-    assert(param_decl_node->type == NodeTypeParamDecl);
-    Buf *param_name = &param_decl_node->data.param_decl.name;
-    if (buf_eql_buf(name, param_name)) {
-      CodeGenNode *codegen_node = g->cur_fn->fn_def_node->codegen_node;
-      assert(codegen_node);
-      FnDefNode *codegen_fn_def = &codegen_node->data.fn_def_node;
-      return codegen_fn_def->params[i];
+// null for types whose accesses may alias anything
+static LLVMJaneTBAANode *get_tbaa_node(CodeGen *g, TypeTableEntry *type) {
+  Buf *name;
+  switch (type->id) {
+  case TypeTableEntryIdInt:
+    if (type->size_in_bits == 8) {
+      return g->tbaa_byte_node;
+    }
+    // signed and unsigned integers of one size alias each other, as in C
+    name = buf_sprintf("int%d", (int)type->size_in_bits);
+    break;
+  case TypeTableEntryIdFloat:
+    name = buf_sprintf("float%d", (int)type->size_in_bits);
+    break;
+  case TypeTableEntryIdBool:
+    name = buf_create_from_str("bool");
+    break;
+  case TypeTableEntryIdPointer:
+    // pointer casts are common, so all pointers share a node
+    name = buf_create_from_str("pointer");
+    break;
+  case TypeTableEntryIdInvalid:
+  case TypeTableEntryIdVoid:
+  case TypeTableEntryIdUnreachable:
+  case TypeTableEntryIdVector:
+  case TypeTableEntryIdStruct:
+  case TypeTableEntryIdArray:
+  case TypeTableEntryIdSlice:
+    return nullptr;
+  }
+  auto entry = g->tbaa_table.maybe_get(name);
+  if (entry) {
+    return entry->value;
+  }
+  LLVMJaneTBAANode *node =
+      LLVMJaneCreateTBAAScalarType(g->tbaa_byte_node, buf_ptr(name));
+  g->tbaa_table.put(name, node);
+  return node;
+}
+
+static void add_tbaa(CodeGen *g, LLVMValueRef instruction,
+                     TypeTableEntry *type) {
+  LLVMJaneTBAANode *node = get_tbaa_node(g, type);
+  if (node) {
+    LLVMJaneSetTBAA(instruction, node);
+  }
+}
+
+static LLVMValueRef get_intrinsic_fn(CodeGen *g, Buf *name,
+                                     LLVMTypeRef return_type,
+                                     LLVMTypeRef *param_types,
+                                     int param_count) {
+  LLVMValueRef fn_val = LLVMGetNamedFunction(g->module, buf_ptr(name));
+  if (fn_val) {
+    return fn_val;
+  }
+  LLVMTypeRef fn_type =
+      LLVMFunctionType(return_type, param_types, param_count, false);
+  return LLVMAddFunction(g->module, buf_ptr(name), fn_type);
+}
+
+// the overload suffix of vector intrinsics, e.g. `v4i32`
+static Buf *get_intrinsic_suffix(TypeTableEntry *vector_type) {
+  TypeTableEntry *elem_type = vector_type->vector_child;
+  return buf_sprintf("v%d%c%d", vector_type->vector_len,
+                     elem_type->id == TypeTableEntryIdFloat ? 'f' : 'i',
+                     (int)elem_type->size_in_bits);
+}
+
+static LLVMValueRef gen_vector_reduce(CodeGen *g, BuiltinFnId builtin_fn_id,
+                                      TypeTableEntry *vector_type,
+                                      LLVMValueRef vector) {
+  TypeTableEntry *elem_type = vector_type->vector_child;
+  bool is_float = elem_type->id == TypeTableEntryIdFloat;
+  bool is_signed = elem_type->is_signed;
+  const char *op_name;
+  switch (builtin_fn_id) {
+  case BuiltinFnIdReduceAdd:
+    op_name = is_float ? "fadd" : "add";
+    break;
+  case BuiltinFnIdReduceMul:
+    op_name = is_float ? "fmul" : "mul";
+    break;
+  case BuiltinFnIdReduceMin:
+    op_name = is_float ? "fmin" : (is_signed ? "smin" : "umin");
+    break;
+  case BuiltinFnIdReduceMax:
+    op_name = is_float ? "fmax" : (is_signed ? "smax" : "umax");
+    break;
+  case BuiltinFnIdReduceAnd:
+    op_name = "and";
+    break;
+  case BuiltinFnIdReduceOr:
+    op_name = "or";
+    break;
+  case BuiltinFnIdReduceXor:
+    op_name = "xor";
+    break;
+  default:
+    jane_unreachable();
+  }
+  Buf *name = buf_sprintf("llvm.vector.reduce.%s.%s", op_name,
+                          buf_ptr(get_intrinsic_suffix(vector_type)));
+  bool ordered_float = is_float && (builtin_fn_id == BuiltinFnIdReduceAdd ||
+                                    builtin_fn_id == BuiltinFnIdReduceMul);
+  if (!ordered_float) {
+    LLVMTypeRef param_types[] = {vector_type->type_ref};
+    LLVMValueRef fn_val =
+        get_intrinsic_fn(g, name, elem_type->type_ref, param_types, 1);
+    return LLVMJaneBuildCall(g->builder, fn_val, &vector, 1, LLVMCCallConv,
+                             "");
+  }
+  // fadd/fmul take a start value and are sequential unless reassociation is
+  // allowed, which lets the backend use a tree reduction
+  LLVMValueRef start_val = builtin_fn_id == BuiltinFnIdReduceAdd
+                               ? LLVMConstReal(elem_type->type_ref, -0.0)
+                               : LLVMConstReal(elem_type->type_ref, 1.0);
+  LLVMTypeRef param_types[] = {elem_type->type_ref, vector_type->type_ref};
+  LLVMValueRef fn_val =
+      get_intrinsic_fn(g, name, elem_type->type_ref, param_types, 2);
+  LLVMValueRef args[] = {start_val, vector};
+  LLVMValueRef result =
+      LLVMJaneBuildCall(g->builder, fn_val, args, 2, LLVMCCallConv, "");
+  LLVMJaneSetAllowReassoc(result);
+  return result;
+}
+
+static LLVMValueRef gen_atomic_call(CodeGen *g, AstNode *node) {
+  FnCallNode *fn_call_node = &node->codegen_node->data.fn_call_node;
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  LLVMAtomicOrdering order = fn_call_node->atomic_order;
+  if (fn_call_node->builtin_fn->id == BuiltinFnIdFence) {
+    add_debug_source_node(g, node);
+    return LLVMBuildFence(g->builder, order, false, "");
+  }
+  LLVMValueRef ptr = gen_expr(g, params->at(0));
+  TypeTableEntry *type = get_expr_type(params->at(0))->pointer_child;
+  // atomic accesses must be naturally aligned, which can be stricter than
+  // the abi alignment (i64 on 32-bit x86)
+  unsigned align =
+      (unsigned)LLVMStoreSizeOfType(g->target_data_ref, type->type_ref);
+  switch (fn_call_node->builtin_fn->id) {
+  case BuiltinFnIdAtomicLoad: {
+    add_debug_source_node(g, node);
+    LLVMValueRef load = LLVMBuildLoad(g->builder, ptr, "");
+    LLVMSetOrdering(load, order);
+    LLVMSetAlignment(load, align);
+    return load;
+  }
+  case BuiltinFnIdAtomicStore: {
+    LLVMValueRef value = gen_expr(g, params->at(1));
+    add_debug_source_node(g, node);
+    LLVMValueRef store = LLVMBuildStore(g->builder, value, ptr);
+    LLVMSetOrdering(store, order);
+    LLVMSetAlignment(store, align);
+    return store;
+  }
+  case BuiltinFnIdAtomicRmw: {
+    LLVMValueRef value = gen_expr(g, params->at(2));
+    add_debug_source_node(g, node);
+    return LLVMBuildAtomicRMW(g->builder, fn_call_node->atomic_rmw_op, ptr,
+                              value, order, false);
+  }
+  case BuiltinFnIdCmpxchg: {
+    LLVMValueRef expected = gen_expr(g, params->at(1));
+    LLVMValueRef desired = gen_expr(g, params->at(2));
+    add_debug_source_node(g, node);
+    LLVMValueRef pair = LLVMBuildAtomicCmpXchg(
+        g->builder, ptr, expected, desired, order,
+        fn_call_node->atomic_failure_order, false);
+    // the old value; it equals `expected` exactly when the exchange happened
+    return LLVMBuildExtractValue(g->builder, pair, 0, "");
+  }
+  default:
+    jane_unreachable();
+  }
+}
+
+static LLVMValueRef gen_builtin_fn_call_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeFnCallExpr);
+  BuiltinFnEntry *builtin_fn = node->codegen_node->data.fn_call_node.builtin_fn;
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  TypeTableEntry *type = get_expr_type(node);
+  switch (builtin_fn->id) {
+  case BuiltinFnIdSplat: {
+    LLVMValueRef scalar = gen_expr(g, params->at(0));
+    LLVMValueRef undef = LLVMGetUndef(type->type_ref);
+    LLVMValueRef zero = LLVMConstInt(LLVMInt32Type(), 0, false);
+    LLVMValueRef mask =
+        LLVMConstNull(LLVMVectorType(LLVMInt32Type(), type->vector_len));
+    add_debug_source_node(g, node);
+    LLVMValueRef inserted =
+        LLVMBuildInsertElement(g->builder, undef, scalar, zero, "");
+    return LLVMBuildShuffleVector(g->builder, inserted, undef, mask, "");
+  }
+  case BuiltinFnIdShuffle: {
+    LLVMValueRef val1 = gen_expr(g, params->at(0));
+    LLVMValueRef val2 = gen_expr(g, params->at(1));
+    int index_count = params->length - 2;
+    LLVMValueRef *indices = allocate<LLVMValueRef>(index_count);
+    for (int i = 0; i < index_count; i += 1) {
+      Buf *index_str = &params->at(i + 2)->data.number;
+      indices[i] = LLVMConstIntOfStringAndSize(
+          LLVMInt32Type(), buf_ptr(index_str), buf_len(index_str), 10);
     }
+    LLVMValueRef mask = LLVMConstVector(indices, index_count);
+    deallocate(indices, index_count);
+    add_debug_source_node(g, node);
+    return LLVMBuildShuffleVector(g->builder, val1, val2, mask, "");
+  }
+  case BuiltinFnIdVectorLoad: {
+    // the pointer is only known to be aligned for the element type
+    LLVMValueRef ptr = gen_expr(g, params->at(0));
+    add_debug_source_node(g, node);
+    LLVMValueRef vector_ptr = LLVMBuildBitCast(
+        g->builder, ptr, LLVMPointerType(type->type_ref, 0), "");
+    LLVMValueRef load = LLVMBuildLoad(g->builder, vector_ptr, "");
+    LLVMSetAlignment(load,
+                     LLVMABIAlignmentOfType(g->target_data_ref,
+                                            type->vector_child->type_ref));
+    return load;
+  }
+  case BuiltinFnIdVectorStore: {
+    LLVMValueRef ptr = gen_expr(g, params->at(0));
+    LLVMValueRef vector = gen_expr(g, params->at(1));
+    TypeTableEntry *vector_type = get_expr_type(params->at(1));
+    add_debug_source_node(g, node);
+    LLVMValueRef vector_ptr = LLVMBuildBitCast(
+        g->builder, ptr, LLVMPointerType(vector_type->type_ref, 0), "");
+    LLVMValueRef store = LLVMBuildStore(g->builder, vector, vector_ptr);
+    LLVMSetAlignment(store,
+                     LLVMABIAlignmentOfType(g->target_data_ref,
+                                            vector_type->vector_child->type_ref));
+    return store;
+  }
+  case BuiltinFnIdSlice: {
+    LLVMValueRef ptr = gen_expr(g, params->at(0));
+    LLVMValueRef len = gen_expr(g, params->at(1));
+    TypeTableEntry *len_type = get_expr_type(params->at(1));
+    LLVMTypeRef ptr_type_ref = type->struct_fields[0].type_entry->type_ref;
+    LLVMTypeRef len_type_ref = type->struct_fields[1].type_entry->type_ref;
+    add_debug_source_node(g, node);
+    ptr = LLVMBuildBitCast(g->builder, ptr, ptr_type_ref, "");
+    len = LLVMBuildIntCast2(g->builder, len, len_type_ref, len_type->is_signed,
+                            "");
+    LLVMValueRef slice = LLVMGetUndef(type->type_ref);
+    slice = LLVMBuildInsertValue(g->builder, slice, ptr, 0, "");
+    return LLVMBuildInsertValue(g->builder, slice, len, 1, "");
+  }
+  case BuiltinFnIdComptime:
+    return gen_const_val(g, node->codegen_node->data.fn_call_node.const_val);
+  case BuiltinFnIdIntrinsic: {
+    LLVMValueRef fn_val = LLVMGetIntrinsicDeclaration(
+        g->module, node->codegen_node->data.fn_call_node.intrinsic_id,
+        nullptr, 0);
+    // the first parameter is the intrinsic name
+    int arg_count = params->length - 1;
+    LLVMValueRef *args = allocate<LLVMValueRef>(arg_count);
+    for (int i = 0; i < arg_count; i += 1) {
+      args[i] = gen_expr(g, params->at(i + 1));
+    }
+    add_debug_source_node(g, node);
+    LLVMValueRef result = LLVMJaneBuildCall(g->builder, fn_val, args,
+                                            arg_count, LLVMCCallConv, "");
+    deallocate(args, arg_count);
+    return result;
+  }
+  case BuiltinFnIdAtomicLoad:
+  case BuiltinFnIdAtomicStore:
+  case BuiltinFnIdAtomicRmw:
+  case BuiltinFnIdCmpxchg:
+  case BuiltinFnIdFence:
+    return gen_atomic_call(g, node);
+  case BuiltinFnIdReduceAdd:
+  case BuiltinFnIdReduceMul:
+  case BuiltinFnIdReduceMin:
+  case BuiltinFnIdReduceMax:
+  case BuiltinFnIdReduceAnd:
+  case BuiltinFnIdReduceOr:
+  case BuiltinFnIdReduceXor: {
+    LLVMValueRef vector = gen_expr(g, params->at(0));
+    add_debug_source_node(g, node);
+    return gen_vector_reduce(g, builtin_fn->id, get_expr_type(params->at(0)),
+                             vector);
+  }
   }
   jane_unreachable();
 }
 
+// asm without a result is only there for its side effects, so it is always
+// volatile
+static LLVMValueRef gen_asm_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeAsmExpr);
+  AstNodeAsmExpr *asm_expr = &node->data.asm_expr;
+  TypeTableEntry *return_type = get_expr_type(node);
+  int operand_count = asm_expr->operands.length;
+  LLVMValueRef *operands = allocate<LLVMValueRef>(operand_count);
+  LLVMTypeRef *operand_types = allocate<LLVMTypeRef>(operand_count);
+  for (int i = 0; i < operand_count; i += 1) {
+    AstNode *operand = asm_expr->operands.at(i);
+    operands[i] = gen_expr(g, operand);
+    operand_types[i] = get_expr_type(operand)->type_ref;
+  }
+  LLVMTypeRef fn_type = LLVMFunctionType(return_type->type_ref, operand_types,
+                                         operand_count, false);
+  deallocate(operand_types, operand_count);
+  bool is_volatile =
+      asm_expr->is_volatile || return_type->id == TypeTableEntryIdVoid;
+  LLVMValueRef asm_val = LLVMGetInlineAsm(
+      fn_type, buf_ptr(&asm_expr->asm_template),
+      buf_len(&asm_expr->asm_template), buf_ptr(&asm_expr->constraints),
+      buf_len(&asm_expr->constraints), is_volatile, false,
+      LLVMInlineAsmDialectATT, false);
+  add_debug_source_node(g, node);
+  LLVMValueRef result = LLVMBuildCall2(g->builder, fn_type, asm_val, operands,
+                                       operand_count, "");
+  deallocate(operands, operand_count);
+  return result;
+}
+
 static LLVMValueRef gen_fn_call_expr(CodeGen *g, AstNode *node) {
   assert(node->type == NodeTypeFnCallExpr);
-  Buf *name = hack_get_fn_call_name(g, node->data.fn_call_expr.fn_ref_expr);
-  FnTableEntry *fn_table_entry = g->fn_table.get(name);
+  if (node->data.fn_call_expr.is_builtin) {
+    return gen_builtin_fn_call_expr(g, node);
+  }
+  FnTableEntry *fn_table_entry = node->codegen_node->data.fn_call_node.fn_entry;
   assert(fn_table_entry->proto_node->type == NodeTypeFnProto);
   int expected_param_count =
       fn_table_entry->proto_node->data.fn_proto.params.length;
@@ -129,6 +635,7 @@ static LLVMValueRef gen_fn_call_expr(CodeGen *g, AstNode *node) {
   LLVMValueRef result = LLVMJaneBuildCall(
       g->builder, fn_table_entry->fn_value, param_values, actual_param_count,
       fn_table_entry->calling_convention, "");
+  deallocate(param_values, actual_param_count);
   if (type_is_unreachable(
           g, fn_table_entry->proto_node->data.fn_proto.return_type)) {
     return LLVMBuildUnreachable(g->builder);
@@ -137,14 +644,24 @@ static LLVMValueRef gen_fn_call_expr(CodeGen *g, AstNode *node) {
   }
 }
 
+static LLVMValueRef gen_address(CodeGen *g, AstNode *node, unsigned *align);
+
 static LLVMValueRef gen_prefix_op_expr(CodeGen *g, AstNode *node) {
   assert(node->type == NodeTypePrefixOpExpr);
-  assert(node->data.prefix_op_expr.primary_expr);
-  LLVMValueRef expr = gen_expr(g, node->data.prefix_op_expr.primary_expr);
+  AstNode *operand = node->data.prefix_op_expr.primary_expr;
+  assert(operand);
+  if (node->data.prefix_op_expr.prefix_op == PrefixOpAddressOf) {
+    unsigned align;
+    return gen_address(g, operand, &align);
+  }
+  LLVMValueRef expr = gen_expr(g, operand);
 
   switch (node->data.prefix_op_expr.prefix_op) {
   case PrefixOpNegation:
     add_debug_source_node(g, node);
+    if (get_scalar_type(get_expr_type(node))->id == TypeTableEntryIdFloat) {
+      return LLVMBuildFNeg(g->builder, expr, "");
+    }
     return LLVMBuildNeg(g->builder, expr, "");
   case PrefixOpBoolNot: {
     LLVMValueRef zero = LLVMConstNull(LLVMTypeOf(expr));
@@ -154,6 +671,14 @@ static LLVMValueRef gen_prefix_op_expr(CodeGen *g, AstNode *node) {
   case PrefixOpBinNot:
     add_debug_source_node(g, node);
     return LLVMBuildNot(g->builder, expr, "");
+  case PrefixOpDereference: {
+    add_debug_source_node(g, node);
+    LLVMValueRef load = LLVMBuildLoad(g->builder, expr, "");
+    LLVMSetAlignment(load, get_type_alignment(g, get_expr_type(node)));
+    add_tbaa(g, load, get_expr_type(node));
+    return load;
+  }
+  case PrefixOpAddressOf:
   case PrefixOpInvalid:
     jane_unreachable();
   }
@@ -162,49 +687,108 @@ static LLVMValueRef gen_prefix_op_expr(CodeGen *g, AstNode *node) {
 
 static LLVMValueRef gen_cast_expr(CodeGen *g, AstNode *node) {
   assert(node->type == NodeTypeCastExpr);
-  LLVMValueRef expr = gen_expr(g, node->data.cast_expr.prefix_op_expr);
-  if (!node->data.cast_expr.type) {
+  AstNode *operand = node->data.cast_expr.prefix_op_expr;
+  LLVMValueRef expr = gen_expr(g, operand);
+  TypeTableEntry *src = get_expr_type(operand);
+  TypeTableEntry *dest = get_expr_type(node);
+  if (src == dest) {
     return expr;
   }
-  jane_panic("TODO: casting expression");
+  LLVMTypeRef dest_ref = dest->type_ref;
+  // vector casts convert element-wise with the same instructions
+  src = get_scalar_type(src);
+  dest = get_scalar_type(dest);
+  add_debug_source_node(g, node);
+  switch (dest->id) {
+  case TypeTableEntryIdInt:
+    if (src->id == TypeTableEntryIdInt) {
+      if (src->size_in_bits > dest->size_in_bits) {
+        return LLVMBuildTrunc(g->builder, expr, dest_ref, "");
+      } else if (src->size_in_bits == dest->size_in_bits) {
+        return expr;
+      } else if (src->is_signed) {
+        return LLVMBuildSExt(g->builder, expr, dest_ref, "");
+      } else {
+        return LLVMBuildZExt(g->builder, expr, dest_ref, "");
+      }
+    } else if (src->id == TypeTableEntryIdBool) {
+      return LLVMBuildZExt(g->builder, expr, dest_ref, "");
+    } else if (src->id == TypeTableEntryIdFloat) {
+      return dest->is_signed ? LLVMBuildFPToSI(g->builder, expr, dest_ref, "")
+                             : LLVMBuildFPToUI(g->builder, expr, dest_ref, "");
+    } else {
+      assert(src->id == TypeTableEntryIdPointer);
+      return LLVMBuildPtrToInt(g->builder, expr, dest_ref, "");
+    }
+  case TypeTableEntryIdFloat:
+    if (src->id == TypeTableEntryIdFloat) {
+      return src->size_in_bits > dest->size_in_bits
+                 ? LLVMBuildFPTrunc(g->builder, expr, dest_ref, "")
+                 : LLVMBuildFPExt(g->builder, expr, dest_ref, "");
+    }
+    assert(src->id == TypeTableEntryIdInt);
+    return src->is_signed ? LLVMBuildSIToFP(g->builder, expr, dest_ref, "")
+                          : LLVMBuildUIToFP(g->builder, expr, dest_ref, "");
+  case TypeTableEntryIdPointer:
+    if (src->id == TypeTableEntryIdInt) {
+      return LLVMBuildIntToPtr(g->builder, expr, dest_ref, "");
+    }
+    return LLVMBuildBitCast(g->builder, expr, dest_ref, "");
+  case TypeTableEntryIdInvalid:
+  case TypeTableEntryIdVoid:
+  case TypeTableEntryIdBool:
+  case TypeTableEntryIdUnreachable:
+  case TypeTableEntryIdVector:
+  case TypeTableEntryIdStruct:
+  case TypeTableEntryIdArray:
+  case TypeTableEntryIdSlice:
+    jane_unreachable();
+  }
+  jane_unreachable();
 }
 
 static LLVMValueRef gen_arithmetic_bin_op_expr(CodeGen *g, AstNode *node) {
   assert(node->type == NodeTypeBinOpExpr);
   LLVMValueRef val1 = gen_expr(g, node->data.bin_op_expr.op1);
   LLVMValueRef val2 = gen_expr(g, node->data.bin_op_expr.op2);
+  TypeTableEntry *type = get_scalar_type(get_expr_type(node));
+  bool is_float = type->id == TypeTableEntryIdFloat;
+  bool is_signed = type->is_signed;
 
+  add_debug_source_node(g, node);
   switch (node->data.bin_op_expr.bin_op) {
   case BinOpTypeBinOr:
-    add_debug_source_node(g, node);
     return LLVMBuildOr(g->builder, val1, val2, "");
   case BinOpTypeBinXor:
-    add_debug_source_node(g, node);
     return LLVMBuildXor(g->builder, val1, val2, "");
   case BinOpTypeBinAnd:
-    add_debug_source_node(g, node);
     return LLVMBuildAnd(g->builder, val1, val2, "");
   case BinOpTypeBitShiftLeft:
-    add_debug_source_node(g, node);
     return LLVMBuildShl(g->builder, val1, val2, "");
   case BinOpTypeBitShiftRight:
-    add_debug_source_node(g, node);
-    return LLVMBuildLShr(g->builder, val1, val2, "");
+    return is_signed ? LLVMBuildAShr(g->builder, val1, val2, "")
+                     : LLVMBuildLShr(g->builder, val1, val2, "");
   case BinOpTypeAdd:
-    add_debug_source_node(g, node);
-    return LLVMBuildAdd(g->builder, val1, val2, "");
+    return is_float ? LLVMBuildFAdd(g->builder, val1, val2, "")
+                    : LLVMBuildAdd(g->builder, val1, val2, "");
   case BinOpTypeSub:
-    add_debug_source_node(g, node);
-    return LLVMBuildSub(g->builder, val1, val2, "");
+    return is_float ? LLVMBuildFSub(g->builder, val1, val2, "")
+                    : LLVMBuildSub(g->builder, val1, val2, "");
   case BinOpTypeMult:
-    add_debug_source_node(g, node);
-    return LLVMBuildMul(g->builder, val1, val2, "");
+    return is_float ? LLVMBuildFMul(g->builder, val1, val2, "")
+                    : LLVMBuildMul(g->builder, val1, val2, "");
   case BinOpTypeDiv:
-    add_debug_source_node(g, node);
-    return LLVMBuildSDiv(g->builder, val1, val2, "");
+    if (is_float) {
+      return LLVMBuildFDiv(g->builder, val1, val2, "");
+    }
+    return is_signed ? LLVMBuildSDiv(g->builder, val1, val2, "")
+                     : LLVMBuildUDiv(g->builder, val1, val2, "");
   case BinOpTypeMod:
-    add_debug_source_node(g, node);
-    return LLVMBuildSRem(g->builder, val1, val2, "");
+    if (is_float) {
+      return LLVMBuildFRem(g->builder, val1, val2, "");
+    }
+    return is_signed ? LLVMBuildSRem(g->builder, val1, val2, "")
+                     : LLVMBuildURem(g->builder, val1, val2, "");
   case BinOpTypeBoolOr:
   case BinOpTypeBoolAnd:
   case BinOpTypeCmpEq:
@@ -213,6 +797,7 @@ static LLVMValueRef gen_arithmetic_bin_op_expr(CodeGen *g, AstNode *node) {
   case BinOpTypeCmpGreaterThan:
   case BinOpTypeCmpLessOrEq:
   case BinOpTypeCmpGreaterOrEq:
+  case BinOpTypeAssign:
   case BinOpTypeInvalid:
     jane_unreachable();
   }
@@ -239,40 +824,64 @@ static LLVMIntPredicate cmp_op_to_int_predicate(BinOpType cmp_op,
   }
 }
 
+// ordered predicates, except `!=` which is unordered so that NaN != NaN
+static LLVMRealPredicate cmp_op_to_real_predicate(BinOpType cmp_op) {
+  switch (cmp_op) {
+  case BinOpTypeCmpEq:
+    return LLVMRealOEQ;
+  case BinOpTypeCmpNotEq:
+    return LLVMRealUNE;
+  case BinOpTypeCmpLessThan:
+    return LLVMRealOLT;
+  case BinOpTypeCmpGreaterThan:
+    return LLVMRealOGT;
+  case BinOpTypeCmpLessOrEq:
+    return LLVMRealOLE;
+  case BinOpTypeCmpGreaterOrEq:
+    return LLVMRealOGE;
+  default:
+    jane_unreachable();
+  }
+}
+
 static LLVMValueRef gen_cmp_expr(CodeGen *g, AstNode *node) {
   assert(node->type == NodeTypeBinOpExpr);
   LLVMValueRef val1 = gen_expr(g, node->data.bin_op_expr.op1);
   LLVMValueRef val2 = gen_expr(g, node->data.bin_op_expr.op2);
-  LLVMIntPredicate pred =
-      cmp_op_to_int_predicate(node->data.bin_op_expr.bin_op, true);
+  TypeTableEntry *op_type =
+      get_scalar_type(get_expr_type(node->data.bin_op_expr.op1));
   add_debug_source_node(g, node);
+  if (op_type->id == TypeTableEntryIdFloat) {
+    LLVMRealPredicate pred =
+        cmp_op_to_real_predicate(node->data.bin_op_expr.bin_op);
+    return LLVMBuildFCmp(g->builder, pred, val1, val2, "");
+  }
+  LLVMIntPredicate pred = cmp_op_to_int_predicate(
+      node->data.bin_op_expr.bin_op, op_type->is_signed);
   return LLVMBuildICmp(g->builder, pred, val1, val2, "");
 }
 
 static LLVMValueRef gen_bool_and_expr(CodeGen *g, AstNode *node) {
   assert(node->type == NodeTypeBinOpExpr);
   LLVMValueRef val1 = gen_expr(g, node->data.bin_op_expr.op1);
+  LLVMBasicBlockRef post_val1_block = LLVMGetInsertBlock(g->builder);
   LLVMBasicBlockRef true_block =
       LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoolAndTrue");
-  LLVMBasicBlockRef false_block =
-      LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoolAndFalse");
-  LLVMValueRef zero = LLVMConstNull(LLVMTypeOf(val1));
+  LLVMBasicBlockRef end_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoolAndEnd");
   add_debug_source_node(g, node);
-  LLVMValueRef val1_i1 = LLVMBuildICmp(g->builder, LLVMIntEQ, val1, zero, "");
-  LLVMBuildCondBr(g->builder, val1_i1, false_block, true_block);
+  LLVMBuildCondBr(g->builder, val1, true_block, end_block);
 
   LLVMPositionBuilderAtEnd(g->builder, true_block);
   LLVMValueRef val2 = gen_expr(g, node->data.bin_op_expr.op2);
+  LLVMBasicBlockRef post_val2_block = LLVMGetInsertBlock(g->builder);
   add_debug_source_node(g, node);
-  LLVMValueRef val2_i1 = LLVMBuildICmp(g->builder, LLVMIntEQ, val2, zero, "");
+  LLVMBuildBr(g->builder, end_block);
 
-  LLVMPositionBuilderAtEnd(g->builder, false_block);
-  add_debug_source_node(g, node);
+  LLVMPositionBuilderAtEnd(g->builder, end_block);
   LLVMValueRef phi = LLVMBuildPhi(g->builder, LLVMInt1Type(), "");
-  LLVMValueRef one_i1 = LLVMConstAllOnes(LLVMInt1Type());
-  LLVMValueRef incoming_values[2] = {one_i1, val2_i1};
-  LLVMBasicBlockRef incoming_blocks[2] = {LLVMGetInsertBlock(g->builder),
-                                          true_block};
+  LLVMValueRef incoming_values[2] = {val1, val2};
+  LLVMBasicBlockRef incoming_blocks[2] = {post_val1_block, post_val2_block};
   LLVMAddIncoming(phi, incoming_values, incoming_blocks, 2);
   return phi;
 }
@@ -280,37 +889,326 @@ static LLVMValueRef gen_bool_and_expr(CodeGen *g, AstNode *node) {
 static LLVMValueRef gen_bool_or_expr(CodeGen *g, AstNode *expr_node) {
   assert(expr_node->type == NodeTypeBinOpExpr);
   LLVMValueRef val1 = gen_expr(g, expr_node->data.bin_op_expr.op1);
+  LLVMBasicBlockRef post_val1_block = LLVMGetInsertBlock(g->builder);
   LLVMBasicBlockRef false_block =
       LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoolOrFalse");
-  LLVMBasicBlockRef true_block =
-      LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoolOrTrue");
-
-  LLVMValueRef zero = LLVMConstNull(LLVMTypeOf(val1));
+  LLVMBasicBlockRef end_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoolOrEnd");
   add_debug_source_node(g, expr_node);
-  LLVMValueRef val1_i1 = LLVMBuildICmp(g->builder, LLVMIntEQ, val1, zero, "");
-  LLVMBuildCondBr(g->builder, val1_i1, false_block, true_block);
+  LLVMBuildCondBr(g->builder, val1, end_block, false_block);
 
   LLVMPositionBuilderAtEnd(g->builder, false_block);
   LLVMValueRef val2 = gen_expr(g, expr_node->data.bin_op_expr.op2);
+  LLVMBasicBlockRef post_val2_block = LLVMGetInsertBlock(g->builder);
   add_debug_source_node(g, expr_node);
-  LLVMValueRef val2_i1 = LLVMBuildICmp(g->builder, LLVMIntEQ, val2, zero, "");
+  LLVMBuildBr(g->builder, end_block);
 
-  LLVMPositionBuilderAtEnd(g->builder, true_block);
-  add_debug_source_node(g, expr_node);
+  LLVMPositionBuilderAtEnd(g->builder, end_block);
   LLVMValueRef phi = LLVMBuildPhi(g->builder, LLVMInt1Type(), "");
-  LLVMValueRef one_i1 = LLVMConstAllOnes(LLVMInt1Type());
-  LLVMValueRef incoming_values[2] = {one_i1, val2_i1};
-  LLVMBasicBlockRef incoming_blocks[2] = {LLVMGetInsertBlock(g->builder),
-                                          false_block};
+  LLVMValueRef incoming_values[2] = {val1, val2};
+  LLVMBasicBlockRef incoming_blocks[2] = {post_val1_block, post_val2_block};
   LLVMAddIncoming(phi, incoming_values, incoming_blocks, 2);
-
   return phi;
 }
 
+// a stack slot in the entry block, for values that need an address but do
+// not have one
+static LLVMValueRef gen_entry_alloca(CodeGen *g, TypeTableEntry *type) {
+  LLVMBasicBlockRef cur_block = LLVMGetInsertBlock(g->builder);
+  LLVMBasicBlockRef entry_block = LLVMGetEntryBasicBlock(g->cur_fn->fn_value);
+  LLVMValueRef first_instruction = LLVMGetFirstInstruction(entry_block);
+  if (first_instruction) {
+    LLVMPositionBuilderBefore(g->builder, first_instruction);
+  } else {
+    LLVMPositionBuilderAtEnd(g->builder, entry_block);
+  }
+  LLVMValueRef alloca = LLVMBuildAlloca(g->builder, type->type_ref, "");
+  LLVMSetAlignment(alloca, get_type_alignment(g, type));
+  LLVMPositionBuilderAtEnd(g->builder, cur_block);
+  return alloca;
+}
+
+static LLVMValueRef gen_field_ptr(CodeGen *g, AstNode *node, unsigned *align);
+static LLVMValueRef gen_array_elem_ptr(CodeGen *g, AstNode *node,
+                                       unsigned *align);
+
+// the address of an expression that names memory, or null without emitting
+// any code when it does not. `align` receives the known alignment of the
+// result, which is below the type's abi alignment inside packed structs.
+static LLVMValueRef gen_lvalue(CodeGen *g, AstNode *node, unsigned *align) {
+  switch (node->type) {
+  case NodeTypeSymbol: {
+    GlobalConstEntry *global_const =
+        node->codegen_node->data.symbol_node.global_const;
+    if (global_const) {
+      if (!global_const->global_ref) {
+        global_const->global_ref = gen_const_global(
+            g, global_const->value, buf_ptr(global_const->name));
+      }
+      *align = get_type_alignment(g, global_const->type);
+      return global_const->global_ref;
+    }
+    LocalVariableTableEntry *variable = get_local_variable(node);
+    if (variable->arg_index >= 0) {
+      return nullptr;
+    }
+    *align = get_type_alignment(g, variable->type);
+    return variable->value_ref;
+  }
+  case NodeTypeFnCallExpr: {
+    FnCallNode *fn_call_node = &node->codegen_node->data.fn_call_node;
+    if (!node->data.fn_call_expr.is_builtin ||
+        fn_call_node->builtin_fn->id != BuiltinFnIdComptime) {
+      return nullptr;
+    }
+    if (!fn_call_node->const_global_ref) {
+      fn_call_node->const_global_ref =
+          gen_const_global(g, fn_call_node->const_val, "");
+    }
+    *align = get_type_alignment(g, get_expr_type(node));
+    return fn_call_node->const_global_ref;
+  }
+  case NodeTypeFieldAccessExpr:
+    if (!node->codegen_node->data.field_access_node.field) {
+      return nullptr;
+    }
+    return gen_field_ptr(g, node, align);
+  case NodeTypeArrayAccessExpr:
+    return gen_array_elem_ptr(g, node, align);
+  case NodeTypePrefixOpExpr:
+    if (node->data.prefix_op_expr.prefix_op != PrefixOpDereference) {
+      return nullptr;
+    }
+    *align = get_type_alignment(g, get_expr_type(node));
+    return gen_expr(g, node->data.prefix_op_expr.primary_expr);
+  default:
+    return nullptr;
+  }
+}
+
+// like gen_lvalue, but spills values without an address to the stack
+static LLVMValueRef gen_address(CodeGen *g, AstNode *node, unsigned *align) {
+  LLVMValueRef ptr = gen_lvalue(g, node, align);
+  if (ptr) {
+    return ptr;
+  }
+  TypeTableEntry *type = get_expr_type(node);
+  LLVMValueRef value = gen_expr(g, node);
+  LLVMValueRef alloca = gen_entry_alloca(g, type);
+  add_debug_source_node(g, node);
+  LLVMValueRef store = LLVMBuildStore(g->builder, value, alloca);
+  *align = get_type_alignment(g, type);
+  LLVMSetAlignment(store, *align);
+  return alloca;
+}
+
+// the address of a field, or null when the struct is a temporary or a
+// parameter and has no address
+static LLVMValueRef gen_field_ptr(CodeGen *g, AstNode *node, unsigned *align) {
+  assert(node->type == NodeTypeFieldAccessExpr);
+  AstNode *struct_expr = node->data.field_access_expr.struct_expr;
+  TypeTableEntry *struct_type = get_expr_type(struct_expr);
+  LLVMValueRef struct_ptr;
+  unsigned struct_align = 0;
+  if (struct_type->id == TypeTableEntryIdPointer) {
+    struct_ptr = gen_expr(g, struct_expr);
+    struct_type = struct_type->pointer_child;
+    struct_align = get_type_alignment(g, struct_type);
+  } else {
+    struct_ptr = gen_lvalue(g, struct_expr, &struct_align);
+  }
+  if (!struct_ptr) {
+    return nullptr;
+  }
+  TypeStructField *field = node->codegen_node->data.field_access_node.field;
+  unsigned long long offset = LLVMOffsetOfElement(
+      g->target_data_ref, struct_type->type_ref, field->gen_index);
+  // the largest power of two dividing both the struct alignment and the
+  // field offset
+  *align = struct_align;
+  while (offset % *align != 0) {
+    *align /= 2;
+  }
+  add_debug_source_node(g, node);
+  return LLVMBuildStructGEP(g->builder, struct_ptr, field->gen_index, "");
+}
+
+// a slice never holds more bytes than isize can count
+static void add_slice_len_range(CodeGen *g, TypeTableEntry *slice_type,
+                                LLVMValueRef len_load) {
+  TypeTableEntry *child_type =
+      slice_type->struct_fields[0].type_entry->pointer_child;
+  unsigned long long elem_size =
+      LLVMABISizeOfType(g->target_data_ref, child_type->type_ref);
+  if (elem_size == 0) {
+    return;
+  }
+  uint64_t isize_max = (1ULL << (g->pointer_size_bytes * 8 - 1)) - 1;
+  LLVMJaneSetRangeMetadata(len_load, 0, isize_max / elem_size + 1);
+}
+
+static LLVMValueRef gen_field_access_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeFieldAccessExpr);
+  AstNode *struct_expr = node->data.field_access_expr.struct_expr;
+  TypeStructField *field = node->codegen_node->data.field_access_node.field;
+  if (!field) {
+    TypeTableEntry *array_type = get_expr_type(struct_expr);
+    if (array_type->id == TypeTableEntryIdPointer) {
+      array_type = array_type->pointer_child;
+    }
+    return LLVMConstInt(g->builtin_types.entry_usize->type_ref,
+                        array_type->array_len, false);
+  }
+  unsigned align;
+  LLVMValueRef field_ptr = gen_field_ptr(g, node, &align);
+  if (field_ptr) {
+    LLVMValueRef load = LLVMBuildLoad(g->builder, field_ptr, "");
+    LLVMSetAlignment(load, align);
+    add_tbaa(g, load, field->type_entry);
+    TypeTableEntry *struct_type = get_expr_type(struct_expr);
+    if (struct_type->id == TypeTableEntryIdPointer) {
+      struct_type = struct_type->pointer_child;
+    }
+    if (struct_type->id == TypeTableEntryIdSlice && field->gen_index == 1) {
+      add_slice_len_range(g, struct_type, load);
+    }
+    return load;
+  }
+  LLVMValueRef struct_val = gen_expr(g, struct_expr);
+  add_debug_source_node(g, node);
+  return LLVMBuildExtractValue(g->builder, struct_val, field->gen_index, "");
+}
+
+// traps unless index < len. debug builds only; release builds trust the
+// program.
+// the index is compared before it is cast to usize, at the wider of the two
+// widths, so that a 64-bit index on a 32-bit target cannot truncate into range
+static void gen_bounds_check(CodeGen *g, AstNode *node, LLVMValueRef index,
+                             bool index_is_signed, LLVMValueRef len) {
+  if (g->build_type == CodeGenBuildTypeRelease) {
+    return;
+  }
+  add_debug_source_node(g, node);
+  LLVMTypeRef index_type = LLVMTypeOf(index);
+  LLVMTypeRef len_type = LLVMTypeOf(len);
+  if (LLVMGetIntTypeWidth(index_type) > LLVMGetIntTypeWidth(len_type)) {
+    len = LLVMBuildZExt(g->builder, len, index_type, "");
+  } else {
+    index = LLVMBuildIntCast2(g->builder, index, len_type, index_is_signed, "");
+  }
+  LLVMBasicBlockRef ok_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoundsCheckOk");
+  LLVMBasicBlockRef fail_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "BoundsCheckFail");
+  LLVMValueRef ok_bit = LLVMBuildICmp(g->builder, LLVMIntULT, index, len, "");
+  LLVMValueRef br = LLVMBuildCondBr(g->builder, ok_bit, ok_block, fail_block);
+  LLVMJaneSetBranchWeights(br, 2000, 1);
+
+  LLVMPositionBuilderAtEnd(g->builder, fail_block);
+  LLVMValueRef trap_fn =
+      get_intrinsic_fn(g, buf_create_from_str("llvm.trap"), LLVMVoidType(),
+                       nullptr, 0);
+  LLVMJaneBuildCall(g->builder, trap_fn, nullptr, 0, LLVMCCallConv, "");
+  LLVMBuildUnreachable(g->builder);
+
+  LLVMPositionBuilderAtEnd(g->builder, ok_block);
+}
+
+static LLVMValueRef gen_array_elem_ptr(CodeGen *g, AstNode *node,
+                                       unsigned *align) {
+  assert(node->type == NodeTypeArrayAccessExpr);
+  AstNode *array_ref_expr = node->data.array_access_expr.array_ref_expr;
+  AstNode *subscript = node->data.array_access_expr.subscript;
+  TypeTableEntry *array_type = get_expr_type(array_ref_expr);
+  TypeTableEntry *usize = g->builtin_types.entry_usize;
+  TypeTableEntry *child_type = get_expr_type(node);
+
+  if (array_type->id == TypeTableEntryIdArray) {
+    unsigned array_align;
+    LLVMValueRef array_ptr = gen_address(g, array_ref_expr, &array_align);
+    LLVMValueRef index = gen_expr(g, subscript);
+    bool index_is_signed = get_expr_type(subscript)->is_signed;
+    // analysis proved number literal indexes in range; any other index,
+    // even one that folds to a constant, is checked here
+    if (subscript->type != NodeTypeNumberLiteral) {
+      LLVMValueRef len =
+          LLVMConstInt(usize->type_ref, array_type->array_len, false);
+      gen_bounds_check(g, node, index, index_is_signed, len);
+    }
+    add_debug_source_node(g, node);
+    index = LLVMBuildIntCast2(g->builder, index, usize->type_ref,
+                              index_is_signed, "");
+    unsigned long long elem_size =
+        LLVMABISizeOfType(g->target_data_ref, child_type->type_ref);
+    *align = array_align;
+    while (elem_size % *align != 0) {
+      *align /= 2;
+    }
+    LLVMValueRef indices[] = {LLVMConstNull(usize->type_ref), index};
+    add_debug_source_node(g, node);
+    return LLVMBuildInBoundsGEP(g->builder, array_ptr, indices, 2, "");
+  }
+
+  assert(array_type->id == TypeTableEntryIdSlice);
+  LLVMValueRef ptr;
+  LLVMValueRef len;
+  unsigned slice_align;
+  LLVMValueRef slice_ptr = gen_lvalue(g, array_ref_expr, &slice_align);
+  if (slice_ptr) {
+    add_debug_source_node(g, node);
+    LLVMValueRef ptr_field = LLVMBuildStructGEP(g->builder, slice_ptr, 0, "");
+    ptr = LLVMBuildLoad(g->builder, ptr_field, "");
+    add_tbaa(g, ptr, array_type->struct_fields[0].type_entry);
+    LLVMValueRef len_field = LLVMBuildStructGEP(g->builder, slice_ptr, 1, "");
+    len = LLVMBuildLoad(g->builder, len_field, "");
+    add_tbaa(g, len, array_type->struct_fields[1].type_entry);
+    add_slice_len_range(g, array_type, len);
+  } else {
+    LLVMValueRef slice = gen_expr(g, array_ref_expr);
+    add_debug_source_node(g, node);
+    ptr = LLVMBuildExtractValue(g->builder, slice, 0, "");
+    len = LLVMBuildExtractValue(g->builder, slice, 1, "");
+  }
+  LLVMValueRef index = gen_expr(g, subscript);
+  bool index_is_signed = get_expr_type(subscript)->is_signed;
+  gen_bounds_check(g, node, index, index_is_signed, len);
+  add_debug_source_node(g, node);
+  index = LLVMBuildIntCast2(g->builder, index, usize->type_ref,
+                            index_is_signed, "");
+  *align = get_type_alignment(g, child_type);
+  add_debug_source_node(g, node);
+  return LLVMBuildInBoundsGEP(g->builder, ptr, &index, 1, "");
+}
+
+static LLVMValueRef gen_array_access_expr(CodeGen *g, AstNode *node) {
+  unsigned align;
+  LLVMValueRef elem_ptr = gen_array_elem_ptr(g, node, &align);
+  LLVMValueRef load = LLVMBuildLoad(g->builder, elem_ptr, "");
+  LLVMSetAlignment(load, align);
+  add_tbaa(g, load, get_expr_type(node));
+  return load;
+}
+
+static LLVMValueRef gen_assign_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeBinOpExpr);
+  AstNode *lhs_node = node->data.bin_op_expr.op1;
+  unsigned align;
+  LLVMValueRef ptr = gen_lvalue(g, lhs_node, &align);
+  assert(ptr);
+  LLVMValueRef value = gen_expr(g, node->data.bin_op_expr.op2);
+  add_debug_source_node(g, node);
+  LLVMValueRef store = LLVMBuildStore(g->builder, value, ptr);
+  LLVMSetAlignment(store, align);
+  add_tbaa(g, store, get_expr_type(lhs_node));
+  return store;
+}
+
 static LLVMValueRef gen_bin_op_expr(CodeGen *g, AstNode *node) {
   switch (node->data.bin_op_expr.bin_op) {
   case BinOpTypeInvalid:
     jane_unreachable();
+  case BinOpTypeAssign:
+    return gen_assign_expr(g, node);
   case BinOpTypeBoolOr:
     return gen_bool_or_expr(g, node);
   case BinOpTypeBoolAnd:
@@ -342,8 +1240,14 @@ static LLVMValueRef gen_return_expr(CodeGen *g, AstNode *node) {
   AstNode *param_node = node->data.return_expr.expression;
   if (param_node) {
     LLVMValueRef value = gen_expr(g, param_node);
+    if (node->data.return_expr.is_tail) {
+      LLVMJaneSetMustTail(value);
+    }
 
     add_debug_source_node(g, node);
+    if (LLVMGetTypeKind(LLVMTypeOf(value)) == LLVMVoidTypeKind) {
+      return LLVMBuildRetVoid(g->builder);
+    }
     return LLVMBuildRet(g->builder, value);
   } else {
     add_debug_source_node(g, node);
@@ -351,6 +1255,175 @@ static LLVMValueRef gen_return_expr(CodeGen *g, AstNode *node) {
   }
 }
 
+static LLVMValueRef gen_cond_br(CodeGen *g, AstNode *branch_node,
+                                LLVMValueRef cond, LLVMBasicBlockRef then_block,
+                                LLVMBasicBlockRef else_block) {
+  LLVMValueRef br = LLVMBuildCondBr(g->builder, cond, then_block, else_block);
+  // same ratio clang uses for __builtin_expect
+  switch (branch_node->codegen_node->data.branch_node.hint) {
+  case BranchHintNone:
+    break;
+  case BranchHintLikely:
+    LLVMJaneSetBranchWeights(br, 2000, 1);
+    break;
+  case BranchHintUnlikely:
+    LLVMJaneSetBranchWeights(br, 1, 2000);
+    break;
+  }
+  return br;
+}
+
+static void gen_block(CodeGen *g, ImportTableEntry *import, AstNode *block_node,
+                      bool add_implicit_return);
+
+static LLVMValueRef gen_if_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeIfExpr);
+  AstNodeIfExpr *if_expr = &node->data.if_expr;
+  ImportTableEntry *import = g->cur_fn->import_entry;
+  LLVMValueRef cond = gen_expr(g, if_expr->condition);
+
+  LLVMBasicBlockRef then_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "Then");
+  LLVMBasicBlockRef else_block = nullptr;
+  if (if_expr->else_node) {
+    else_block = LLVMAppendBasicBlock(g->cur_fn->fn_value, "Else");
+  }
+  LLVMBasicBlockRef endif_block = nullptr;
+  if (!expr_is_unreachable(g, node)) {
+    endif_block = LLVMAppendBasicBlock(g->cur_fn->fn_value, "EndIf");
+  }
+  add_debug_source_node(g, node);
+  gen_cond_br(g, node, cond, then_block, else_block ? else_block : endif_block);
+
+  LLVMPositionBuilderAtEnd(g->builder, then_block);
+  gen_block(g, import, if_expr->then_block, false);
+  if (!expr_is_unreachable(g, if_expr->then_block)) {
+    LLVMBuildBr(g->builder, endif_block);
+  }
+  if (else_block) {
+    LLVMPositionBuilderAtEnd(g->builder, else_block);
+    gen_expr(g, if_expr->else_node);
+    if (!expr_is_unreachable(g, if_expr->else_node)) {
+      LLVMBuildBr(g->builder, endif_block);
+    }
+  }
+  if (endif_block) {
+    LLVMPositionBuilderAtEnd(g->builder, endif_block);
+  }
+  return nullptr;
+}
+
+// shared tail of while and for: runs the body with break/continue targets
+// set and closes the loop with a back edge to `continue_block`
+static void gen_loop_body(CodeGen *g, AstNode *body,
+                          LLVMBasicBlockRef body_block,
+                          LLVMBasicBlockRef continue_block,
+                          LLVMBasicBlockRef end_block) {
+  LLVMPositionBuilderAtEnd(g->builder, body_block);
+  g->break_block_stack.append(end_block);
+  g->continue_block_stack.append(continue_block);
+  gen_block(g, g->cur_fn->import_entry, body, false);
+  g->break_block_stack.pop();
+  g->continue_block_stack.pop();
+  if (!expr_is_unreachable(g, body)) {
+    LLVMBuildBr(g->builder, continue_block);
+  }
+}
+
+static void gen_loop_end(CodeGen *g, AstNode *node,
+                         LLVMBasicBlockRef end_block) {
+  LLVMPositionBuilderAtEnd(g->builder, end_block);
+  if (expr_is_unreachable(g, node)) {
+    // an infinite loop without break: nothing branches here
+    LLVMBuildUnreachable(g->builder);
+  }
+}
+
+static LLVMValueRef gen_while_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeWhileExpr);
+  AstNodeWhileExpr *while_expr = &node->data.while_expr;
+  LLVMBasicBlockRef cond_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "WhileCond");
+  LLVMBasicBlockRef body_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "WhileBody");
+  LLVMBasicBlockRef end_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "WhileEnd");
+  add_debug_source_node(g, node);
+  LLVMBuildBr(g->builder, cond_block);
+
+  LLVMPositionBuilderAtEnd(g->builder, cond_block);
+  LLVMValueRef cond = gen_expr(g, while_expr->condition);
+  add_debug_source_node(g, node);
+  gen_cond_br(g, node, cond, body_block, end_block);
+
+  gen_loop_body(g, while_expr->body, body_block, cond_block, end_block);
+  gen_loop_end(g, node, end_block);
+  return nullptr;
+}
+
+static LLVMValueRef gen_for_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeForExpr);
+  AstNodeForExpr *for_expr = &node->data.for_expr;
+  if (for_expr->init) {
+    gen_expr(g, for_expr->init);
+  }
+  LLVMBasicBlockRef cond_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "ForCond");
+  LLVMBasicBlockRef body_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "ForBody");
+  LLVMBasicBlockRef step_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "ForStep");
+  LLVMBasicBlockRef end_block =
+      LLVMAppendBasicBlock(g->cur_fn->fn_value, "ForEnd");
+  add_debug_source_node(g, node);
+  LLVMBuildBr(g->builder, cond_block);
+
+  LLVMPositionBuilderAtEnd(g->builder, cond_block);
+  if (for_expr->condition) {
+    LLVMValueRef cond = gen_expr(g, for_expr->condition);
+    add_debug_source_node(g, node);
+    gen_cond_br(g, node, cond, body_block, end_block);
+  } else {
+    add_debug_source_node(g, node);
+    LLVMBuildBr(g->builder, body_block);
+  }
+
+  gen_loop_body(g, for_expr->body, body_block, step_block, end_block);
+
+  LLVMPositionBuilderAtEnd(g->builder, step_block);
+  if (for_expr->step) {
+    gen_expr(g, for_expr->step);
+  }
+  add_debug_source_node(g, node);
+  LLVMBuildBr(g->builder, cond_block);
+
+  gen_loop_end(g, node, end_block);
+  return nullptr;
+}
+
+static LLVMValueRef gen_var_decl_expr(CodeGen *g, AstNode *node) {
+  assert(node->type == NodeTypeVariableDeclaration);
+  assert(node->codegen_node);
+  LocalVariableTableEntry *variable =
+      node->codegen_node->data.var_decl_node.variable;
+  // `mut x: T;` starts out zeroed
+  LLVMValueRef value = node->data.variable_declaration.expr
+                           ? gen_expr(g, node->data.variable_declaration.expr)
+                           : LLVMConstNull(variable->type->type_ref);
+  if (g->debug_info == CodeGenDebugInfoFull) {
+    ImportTableEntry *import = g->cur_fn->import_entry;
+    LLVMJaneDILocalVariable *di_variable = LLVMJaneCreateAutoVariable(
+        g->dbuilder, g->block_scopes.last(), buf_ptr(&variable->name),
+        import->di_file, node->line + 1, variable->type->di_type, false, 0);
+    LLVMJaneInsertDeclareAtEnd(g->dbuilder, variable->value_ref, di_variable,
+                               node->line + 1, node->column + 1,
+                               g->block_scopes.last(),
+                               LLVMGetInsertBlock(g->builder));
+  }
+  add_debug_source_node(g, node);
+  return LLVMBuildStore(g->builder, value, variable->value_ref);
+}
+
 static LLVMValueRef gen_expr(CodeGen *g, AstNode *node) {
   switch (node->type) {
   case NodeTypeBinOpExpr:
@@ -368,24 +1441,66 @@ static LLVMValueRef gen_expr(CodeGen *g, AstNode *node) {
     return LLVMBuildUnreachable(g->builder);
   case NodeTypeNumberLiteral: {
     Buf *number_str = &node->data.number;
-    LLVMTypeRef number_type = LLVMInt32Type();
-    LLVMValueRef number_val = LLVMConstIntOfStringAndSize(
-        number_type, buf_ptr(number_str), buf_len(number_str), 10);
-    return number_val;
+    TypeTableEntry *number_type = get_expr_type(node);
+    TypeTableEntry *scalar_type = get_scalar_type(number_type);
+    LLVMValueRef scalar;
+    if (scalar_type->id == TypeTableEntryIdFloat) {
+      scalar = LLVMConstRealOfStringAndSize(
+          scalar_type->type_ref, buf_ptr(number_str), buf_len(number_str));
+    } else {
+      scalar = LLVMConstIntOfStringAndSize(
+          scalar_type->type_ref, buf_ptr(number_str), buf_len(number_str), 10);
+    }
+    if (number_type->id != TypeTableEntryIdVector) {
+      return scalar;
+    }
+    LLVMValueRef *elements = allocate<LLVMValueRef>(number_type->vector_len);
+    for (int i = 0; i < number_type->vector_len; i += 1) {
+      elements[i] = scalar;
+    }
+    LLVMValueRef result = LLVMConstVector(elements, number_type->vector_len);
+    deallocate(elements, number_type->vector_len);
+    return result;
   }
   case NodeTypeStringLiteral: {
     Buf *str = &node->data.string;
-    LLVMValueRef str_val = find_or_create_string(g, str);
-    LLVMValueRef indices[] = {LLVMConstInt(LLVMInt32Type(), 0, false),
-                              LLVMConstInt(LLVMInt32Type(), 0, false)};
-    LLVMValueRef ptr_val =
-        LLVMBuildInBoundsGEP(g->builder, str_val, indices, 2, "");
+    LLVMValueRef ptr_val = g->str_table.get(str);
+    TypeTableEntry *type = get_expr_type(node);
+    if (type->id == TypeTableEntryIdSlice) {
+      LLVMTypeRef len_type_ref = type->struct_fields[1].type_entry->type_ref;
+      LLVMValueRef fields[] = {
+          ptr_val, LLVMConstInt(len_type_ref, buf_len(str), false)};
+      return LLVMConstStruct(fields, 2, false);
+    }
     return ptr_val;
   }
-  case NodeTypeSymbol: {
-    Buf *name = &node->data.symbol;
-    return get_variable_value(g, name);
-  }
+  case NodeTypeSymbol:
+    return gen_symbol(g, node);
+  case NodeTypeVariableDeclaration:
+    return gen_var_decl_expr(g, node);
+  case NodeTypeBoolLiteral:
+    return LLVMConstInt(LLVMInt1Type(), node->data.bool_literal, false);
+  case NodeTypeFieldAccessExpr:
+    return gen_field_access_expr(g, node);
+  case NodeTypeArrayAccessExpr:
+    return gen_array_access_expr(g, node);
+  case NodeTypeAsmExpr:
+    return gen_asm_expr(g, node);
+  case NodeTypeIfExpr:
+    return gen_if_expr(g, node);
+  case NodeTypeWhileExpr:
+    return gen_while_expr(g, node);
+  case NodeTypeForExpr:
+    return gen_for_expr(g, node);
+  case NodeTypeBreak:
+    add_debug_source_node(g, node);
+    return LLVMBuildBr(g->builder, g->break_block_stack.last());
+  case NodeTypeContinue:
+    add_debug_source_node(g, node);
+    return LLVMBuildBr(g->builder, g->continue_block_stack.last());
+  case NodeTypeBlock:
+    gen_block(g, g->cur_fn->import_entry, node, false);
+    return nullptr;
   case NodeTypeRoot:
   case NodeTypeRootExportDecl:
   case NodeTypeFnProto:
@@ -393,10 +1508,11 @@ static LLVMValueRef gen_expr(CodeGen *g, AstNode *node) {
   case NodeTypeFnDecl:
   case NodeTypeParamDecl:
   case NodeTypeType:
-  case NodeTypeBlock:
   case NodeTypeExternBlock:
   case NodeTypeDirective:
   case NodeTypeUse:
+  case NodeTypeStructDecl:
+  case NodeTypeStructField:
     jane_unreachable();
   }
   jane_unreachable();
@@ -405,10 +1521,14 @@ static LLVMValueRef gen_expr(CodeGen *g, AstNode *node) {
 static void gen_block(CodeGen *g, ImportTableEntry *import, AstNode *block_node,
                       bool add_implicit_return) {
   assert(block_node->type == NodeTypeBlock);
-  LLVMJaneDILexicalBlock *di_block = LLVMJaneCreateLexicalBlock(
-      g->dbuilder, g->block_scopes.last(), import->di_file,
-      block_node->line + 1, block_node->column + 1);
-  g->block_scopes.append(LLVMJaneLexicalBlockToScope(di_block));
+  // line tables attribute every location to the function
+  bool has_scope = g->debug_info == CodeGenDebugInfoFull;
+  if (has_scope) {
+    LLVMJaneDILexicalBlock *di_block = LLVMJaneCreateLexicalBlock(
+        g->dbuilder, g->block_scopes.last(), import->di_file,
+        block_node->line + 1, block_node->column + 1);
+    g->block_scopes.append(LLVMJaneLexicalBlockToScope(di_block));
+  }
   add_debug_source_node(g, block_node);
   for (int i = 0; i < block_node->data.block.statements.length; i += 1) {
     AstNode *statement_node = block_node->data.block.statements.at(i);
@@ -417,13 +1537,18 @@ static void gen_block(CodeGen *g, ImportTableEntry *import, AstNode *block_node,
   if (add_implicit_return) {
     LLVMBuildRetVoid(g->builder);
   }
-  g->block_scopes.pop();
+  if (has_scope) {
+    g->block_scopes.pop();
+  }
 }
 
 static LLVMJaneDISubroutineType *
 create_di_function_type(CodeGen *g, AstNodeFnProto *fn_proto,
                         LLVMJaneDIFile *di_file) {
-
+  // line tables carry no types
+  if (g->debug_info != CodeGenDebugInfoFull) {
+    return LLVMJaneCreateSubroutineType(g->dbuilder, di_file, nullptr, 0, 0);
+  }
   LLVMJaneDIType **types =
       allocate<LLVMJaneDIType *>(1 + fn_proto->params.length);
   types[0] = to_llvm_debug_type(fn_proto->return_type);
@@ -436,20 +1561,20 @@ create_di_function_type(CodeGen *g, AstNodeFnProto *fn_proto,
         to_llvm_debug_type(param_node->data.param_decl.type);
     types[i + 1] = param_type;
   }
-  return LLVMJaneCreateSubroutineType(g->dbuilder, di_file, types, types_len,
-                                      0);
+  LLVMJaneDISubroutineType *result = LLVMJaneCreateSubroutineType(
+      g->dbuilder, di_file, types, types_len, 0);
+  deallocate(types, types_len);
+  return result;
 }
 
 static void do_code_gen(CodeGen *g) {
-  assert(!g->errors.length);
+  assert(!g->errors.msgs.length);
+  gen_string_pool(g);
   g->block_scopes.append(LLVMJaneCompileUnitToScope(g->compile_unit));
-  auto it = g->fn_table.entry_iterator();
-  for (;;) {
-    auto *entry = it.next();
-    if (!entry) {
-      break;
-    }
-    FnTableEntry *fn_table_entry = entry->value;
+  // declarations follow source order: imports in the order they were
+  // discovered, then top level declarations in the order they appear.
+  for (int fn_proto_i = 0; fn_proto_i < g->fn_protos.length; fn_proto_i += 1) {
+    FnTableEntry *fn_table_entry = g->fn_protos.at(fn_proto_i);
     AstNode *proto_node = fn_table_entry->proto_node;
     assert(proto_node->type == NodeTypeFnProto);
     AstNodeFnProto *fn_proto = &proto_node->data.fn_proto;
@@ -464,16 +1589,65 @@ static void do_code_gen(CodeGen *g) {
     }
     LLVMTypeRef function_type =
         LLVMFunctionType(ret_type, param_types, fn_proto->params.length, 0);
+    deallocate(param_types, fn_proto->params.length);
     LLVMValueRef fn =
         LLVMAddFunction(g->module, buf_ptr(&fn_proto->name), function_type);
     LLVMSetLinkage(fn, fn_table_entry->internal_linkage ? LLVMInternalLinkage
                                                         : LLVMExternalLinkage);
     if (type_is_unreachable(g, fn_proto->return_type)) {
-      LLVMAddFunctionAttr(fn, LLVMNoReturnAttribute);
+      LLVMJaneAddFunctionAttr(fn, "noreturn");
     }
     LLVMSetFunctionCallConv(fn, fn_table_entry->calling_convention);
     if (!fn_table_entry->is_extern) {
-      LLVMAddFunctionAttr(fn, LLVMNoUnwindAttribute);
+      LLVMJaneAddFunctionAttr(fn, "nounwind");
+    }
+    switch (fn_table_entry->fn_inline) {
+    case FnInlineAuto:
+      break;
+    case FnInlineAlways:
+      LLVMJaneAddFunctionAttr(fn, "alwaysinline");
+      break;
+    case FnInlineNever:
+      LLVMJaneAddFunctionAttr(fn, "noinline");
+      break;
+    }
+    if (fn_table_entry->is_hot) {
+      LLVMJaneAddFunctionAttr(fn, "hot");
+    }
+    if (fn_table_entry->is_cold) {
+      LLVMJaneAddFunctionAttr(fn, "cold");
+    }
+    if (fn_table_entry->is_optsize) {
+      LLVMJaneAddFunctionAttr(fn, "optsize");
+    }
+    if (fn_table_entry->alignment) {
+      LLVMSetAlignment(fn, fn_table_entry->alignment);
+    }
+    for (int param_decl_i = 0; param_decl_i < fn_proto->params.length;
+         param_decl_i += 1) {
+      AstNode *param_node = fn_proto->params.at(param_decl_i);
+      TypeTableEntry *param_type =
+          param_node->data.param_decl.type->codegen_node->data.type_node.entry;
+      if (param_type->id != TypeTableEntryIdPointer) {
+        continue;
+      }
+      if (param_node->data.param_decl.is_noalias) {
+        LLVMJaneAddParamAttr(fn, param_decl_i, "noalias");
+      }
+      // jane code never writes through a const pointer. C callees make no
+      // such promise. pointers can be null, so they are not nonnull.
+      if (param_type->pointer_is_const && !fn_table_entry->is_extern) {
+        LLVMJaneAddParamAttr(fn, param_decl_i, "readonly");
+      }
+      // a pointer to an array is null or valid for the whole array. C
+      // callers of an exported function make no such promise.
+      if (param_type->pointer_child->id == TypeTableEntryIdArray &&
+          fn_proto->visib_mod != FnProtoVisibModExport) {
+        LLVMJaneAddDereferenceableOrNullAttr(
+            fn, param_decl_i,
+            LLVMABISizeOfType(g->target_data_ref,
+                              param_type->pointer_child->type_ref));
+      }
     }
     fn_table_entry->fn_value = fn;
   }
@@ -487,18 +1661,22 @@ static void do_code_gen(CodeGen *g) {
     AstNode *proto_node = fn_table_entry->proto_node;
     assert(proto_node->type == NodeTypeFnProto);
     AstNodeFnProto *fn_proto = &proto_node->data.fn_proto;
-    LLVMJaneDIScope *fn_scope = LLVMJaneFileToScope(import->di_file);
-    unsigned line_number = fn_def_node->line + 1;
-    unsigned scope_line = line_number;
-    bool is_definition = true;
-    unsigned flags = 0;
-    bool is_optimized = g->build_type == CodeGenBuildTypeRelease;
-    LLVMJaneDISubprogram *subprogram = LLVMJaneCreateFunction(
-        g->dbuilder, fn_scope, buf_ptr(&fn_proto->name), "", import->di_file,
-        line_number, create_di_function_type(g, fn_proto, import->di_file),
-        fn_table_entry->internal_linkage, is_definition, scope_line, flags,
-        is_optimized, fn);
-    g->block_scopes.append(LLVMJaneSubprogramToScope(subprogram));
+    bool has_subprogram = g->debug_info != CodeGenDebugInfoNone;
+    if (has_subprogram) {
+      LLVMJaneDIScope *fn_scope = LLVMJaneFileToScope(import->di_file);
+      unsigned line_number = fn_def_node->line + 1;
+      unsigned scope_line = line_number;
+      bool is_definition = true;
+      unsigned flags = 0;
+      bool is_optimized = g->build_type == CodeGenBuildTypeRelease;
+      LLVMJaneDISubprogram *subprogram = LLVMJaneCreateFunction(
+          g->dbuilder, fn_scope, buf_ptr(&fn_proto->name), "",
+          import->di_file, line_number,
+          create_di_function_type(g, fn_proto, import->di_file),
+          fn_table_entry->internal_linkage, is_definition, scope_line, flags,
+          is_optimized, fn);
+      g->block_scopes.append(LLVMJaneSubprogramToScope(subprogram));
+    }
     LLVMBasicBlockRef entry_block = LLVMAppendBasicBlock(fn, "entry");
     LLVMPositionBuilderAtEnd(g->builder, entry_block);
     CodeGenNode *codegen_node = fn_def_node->codegen_node;
@@ -507,12 +1685,30 @@ static void do_code_gen(CodeGen *g) {
     codegen_fn_def->params = allocate<LLVMValueRef>(LLVMCountParams(fn));
     LLVMGetParams(fn, codegen_fn_def->params);
 
+    // every stack slot lives in the entry block, ahead of any code, which is
+    // the form mem2reg promotes to ssa values.
+    for (int var_i = 0; var_i < codegen_fn_def->variable_list.length;
+         var_i += 1) {
+      LocalVariableTableEntry *variable =
+          codegen_fn_def->variable_list.at(var_i);
+      if (variable->arg_index >= 0) {
+        variable->value_ref = codegen_fn_def->params[variable->arg_index];
+      } else {
+        variable->value_ref = LLVMBuildAlloca(
+            g->builder, variable->type->type_ref, buf_ptr(&variable->name));
+        LLVMSetAlignment(variable->value_ref,
+                         get_type_alignment(g, variable->type));
+      }
+    }
+
     bool add_implicit_return = codegen_fn_def->add_implicit_return;
     gen_block(g, import, fn_def_node->data.fn_def.body, add_implicit_return);
 
-    g->block_scopes.pop();
+    if (has_subprogram) {
+      g->block_scopes.pop();
+    }
   }
-  assert(!g->errors.length);
+  assert(!g->errors.msgs.length);
   LLVMJaneDIBuilderFinalize(g->dbuilder);
   if (g->verbose) {
     LLVMDumpModule(g->module);
@@ -523,94 +1719,206 @@ static void do_code_gen(CodeGen *g) {
 #endif
 }
 
+static TypeTableEntry *define_primitive_type(CodeGen *g, TypeTableEntryId id,
+                                             const char *name,
+                                             LLVMTypeRef type_ref,
+                                             uint64_t size_in_bits,
+                                             unsigned dwarf_encoding) {
+  TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+  entry->id = id;
+  entry->type_ref = type_ref;
+  entry->size_in_bits = size_in_bits;
+  buf_init_from_str(&entry->name, name);
+  entry->di_type = LLVMJaneCreateDebugBasicType(
+      g->dbuilder, name, size_in_bits,
+      LLVMABIAlignmentOfType(g->target_data_ref, type_ref) * 8, dwarf_encoding);
+  g->type_table.put(&entry->name, entry);
+  return entry;
+}
+
+static TypeTableEntry *define_int_type(CodeGen *g, const char *name,
+                                       unsigned size_in_bits, bool is_signed) {
+  TypeTableEntry *entry = define_primitive_type(
+      g, TypeTableEntryIdInt, name, LLVMIntType(size_in_bits), size_in_bits,
+      is_signed ? LLVMJaneEncoding_DW_ATE_signed()
+                : LLVMJaneEncoding_DW_ATE_unsigned());
+  entry->is_signed = is_signed;
+  return entry;
+}
+
 static void define_primitive_types(CodeGen *g) {
+  g->builtin_types.entry_bool =
+      define_primitive_type(g, TypeTableEntryIdBool, "bool", LLVMInt1Type(), 1,
+                            LLVMJaneEncoding_DW_ATE_boolean());
+
+  g->builtin_types.entry_i8 = define_int_type(g, "i8", 8, true);
+  g->builtin_types.entry_i16 = define_int_type(g, "i16", 16, true);
+  g->builtin_types.entry_i32 = define_int_type(g, "i32", 32, true);
+  g->builtin_types.entry_i64 = define_int_type(g, "i64", 64, true);
+  g->builtin_types.entry_u8 = define_int_type(g, "u8", 8, false);
+  g->builtin_types.entry_u16 = define_int_type(g, "u16", 16, false);
+  g->builtin_types.entry_u32 = define_int_type(g, "u32", 32, false);
+  g->builtin_types.entry_u64 = define_int_type(g, "u64", 64, false);
+  unsigned pointer_bits = g->pointer_size_bytes * 8;
+  g->builtin_types.entry_isize = define_int_type(g, "isize", pointer_bits, true);
+  g->builtin_types.entry_usize =
+      define_int_type(g, "usize", pointer_bits, false);
+
+  g->builtin_types.entry_f32 =
+      define_primitive_type(g, TypeTableEntryIdFloat, "f32", LLVMFloatType(),
+                            32, LLVMJaneEncoding_DW_ATE_float());
+  g->builtin_types.entry_f64 =
+      define_primitive_type(g, TypeTableEntryIdFloat, "f64", LLVMDoubleType(),
+                            64, LLVMJaneEncoding_DW_ATE_float());
   {
     TypeTableEntry *entry = allocate<TypeTableEntry>(1);
-    entry->type_ref = LLVMInt8Type();
-    buf_init_from_str(&entry->name, "u8");
-    entry->di_type =
-        LLVMJaneCreateDebugBasicType(g->dbuilder, buf_ptr(&entry->name), 8, 8,
-                                     LLVMJaneEncoding_DW_ATE_unsigned());
-    g->type_table.put(&entry->name, entry);
-    g->builtin_types.entry_u8 = entry;
-  }
-  {
-    TypeTableEntry *entry = allocate<TypeTableEntry>(1);
-    entry->type_ref = LLVMInt32Type();
-    buf_init_from_str(&entry->name, "i32");
+    entry->id = TypeTableEntryIdVoid;
+    entry->type_ref = LLVMVoidType();
+    buf_init_from_str(&entry->name, "void");
     entry->di_type =
-        LLVMJaneCreateDebugBasicType(g->dbuilder, buf_ptr(&entry->name), 32, 32,
+        LLVMJaneCreateDebugBasicType(g->dbuilder, buf_ptr(&entry->name), 0, 0,
                                      LLVMJaneEncoding_DW_ATE_signed());
     g->type_table.put(&entry->name, entry);
-    g->builtin_types.entry_i32 = entry;
+    g->builtin_types.entry_void = entry;
   }
   {
+    // not in the type table; given to expressions that already reported an
+    // error so that follow-up checks stay quiet
     TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+    entry->id = TypeTableEntryIdInvalid;
     entry->type_ref = LLVMVoidType();
-    buf_init_from_str(&entry->name, "void");
-    entry->di_type =
-        LLVMJaneCreateDebugBasicType(g->dbuilder, buf_ptr(&entry->name), 0, 0,
-                                     LLVMJaneEncoding_DW_ATE_signed());
-    g->type_table.put(&entry->name, entry);
+    buf_init_from_str(&entry->name, "(invalid)");
+    entry->di_type = g->builtin_types.entry_void->di_type;
     g->builtin_types.entry_invalid = entry;
   }
   {
     TypeTableEntry *entry = allocate<TypeTableEntry>(1);
+    entry->id = TypeTableEntryIdUnreachable;
     entry->type_ref = LLVMVoidType();
     buf_init_from_str(&entry->name, "unreachable");
-    entry->di_type = g->builtin_types.entry_invalid->di_type;
+    entry->di_type = g->builtin_types.entry_void->di_type;
     g->type_table.put(&entry->name, entry);
     g->builtin_types.entry_unreachable = entry;
   }
 }
 
-static void init(CodeGen *g, Buf *source_path) {
-  LLVMInitializeAllTargets();
-  LLVMInitializeAllTargetMCs();
-  LLVMInitializeAllAsmPrinters();
-  LLVMInitializeAllAsmParsers();
-  LLVMInitializeNativeTarget();
+static void define_builtin_fn(CodeGen *g, BuiltinFnId id, const char *name,
+                              int param_count) {
+  BuiltinFnEntry *builtin_fn = allocate<BuiltinFnEntry>(1);
+  builtin_fn->id = id;
+  buf_init_from_str(&builtin_fn->name, name);
+  builtin_fn->param_count = param_count;
+  g->builtin_fn_table.put(&builtin_fn->name, builtin_fn);
+}
 
-  g->is_native_target = true;
+static void define_builtin_fns(CodeGen *g) {
+  define_builtin_fn(g, BuiltinFnIdSplat, "splat", 1);
+  define_builtin_fn(g, BuiltinFnIdShuffle, "shuffle", -1);
+  define_builtin_fn(g, BuiltinFnIdVectorLoad, "vector_load", 1);
+  define_builtin_fn(g, BuiltinFnIdVectorStore, "vector_store", 2);
+  define_builtin_fn(g, BuiltinFnIdReduceAdd, "reduce_add", 1);
+  define_builtin_fn(g, BuiltinFnIdReduceMul, "reduce_mul", 1);
+  define_builtin_fn(g, BuiltinFnIdReduceMin, "reduce_min", 1);
+  define_builtin_fn(g, BuiltinFnIdReduceMax, "reduce_max", 1);
+  define_builtin_fn(g, BuiltinFnIdReduceAnd, "reduce_and", 1);
+  define_builtin_fn(g, BuiltinFnIdReduceOr, "reduce_or", 1);
+  define_builtin_fn(g, BuiltinFnIdReduceXor, "reduce_xor", 1);
+  define_builtin_fn(g, BuiltinFnIdSlice, "slice", 2);
+  define_builtin_fn(g, BuiltinFnIdComptime, "comptime", 1);
+  define_builtin_fn(g, BuiltinFnIdIntrinsic, "intrinsic", -1);
+  define_builtin_fn(g, BuiltinFnIdAtomicLoad, "atomic_load", 2);
+  define_builtin_fn(g, BuiltinFnIdAtomicStore, "atomic_store", 3);
+  define_builtin_fn(g, BuiltinFnIdAtomicRmw, "atomic_rmw", 4);
+  define_builtin_fn(g, BuiltinFnIdCmpxchg, "cmpxchg", 5);
+  define_builtin_fn(g, BuiltinFnIdFence, "fence", 1);
+}
+
+static void init_target_machine(CodeGen *g) {
   char *native_triple = LLVMGetDefaultTargetTriple();
+  const char *triple = native_triple;
+  if (g->target_triple && !buf_eql_str(g->target_triple, native_triple)) {
+    triple = buf_ptr(g->target_triple);
+    g->is_native_target = false;
+  } else {
+    g->is_native_target = true;
+  }
 
-  LLVMTargetRef target_ref;
   char *err_msg = nullptr;
-  if (LLVMGetTargetFromTriple(native_triple, &target_ref, &err_msg)) {
+  if (LLVMJaneInitializeTarget(triple, &err_msg)) {
+    jane_panic("unable to initialize target `%s`: %s", triple, err_msg);
+  }
+  LLVMTargetRef target_ref;
+  if (LLVMGetTargetFromTriple(triple, &target_ref, &err_msg)) {
     jane_panic("unable to get target from triple: %s", err_msg);
   }
-  char *native_cpu = LLVMJaneGetHostCPUName();
-  char *native_features = LLVMJaneGetNativeFeatures();
+  char *target_cpu;
+  char *target_features;
+  if (g->is_native_target) {
+    target_cpu = LLVMJaneGetHostCPUName();
+    target_features = LLVMJaneGetNativeFeatures();
+  } else {
+    target_cpu = strdup("");
+    target_features = strdup("");
+  }
 
   LLVMCodeGenOptLevel opt_level = (g->build_type == CodeGenBuildTypeDebug)
                                       ? LLVMCodeGenLevelNone
                                       : LLVMCodeGenLevelAggressive;
   LLVMRelocMode reloc_mode = g->is_static ? LLVMRelocStatic : LLVMRelocPIC;
   g->target_machine = LLVMCreateTargetMachine(
-      target_ref, native_triple, native_cpu, native_features, opt_level,
-      reloc_mode, LLVMCodeModelDefault);
+      target_ref, triple, target_cpu, target_features, opt_level, reloc_mode,
+      LLVMCodeModelDefault);
+  LLVMJaneSetFunctionSections(g->target_machine, g->function_sections);
+  LLVMJaneSetDataSections(g->target_machine, g->data_sections);
+}
+
+static void init(CodeGen *g, Buf *source_path) {
+  if (g->cache && g->cache->target_machine) {
+    g->target_machine = g->cache->target_machine;
+    g->is_native_target = g->cache->is_native_target;
+  } else {
+    init_target_machine(g);
+    if (g->cache) {
+      g->cache->target_machine = g->target_machine;
+      g->cache->is_native_target = g->is_native_target;
+    }
+  }
+  add_time_event(g, "target_init");
   g->target_data_ref = LLVMGetTargetMachineData(g->target_machine);
   g->module = LLVMModuleCreateWithName("JaneModule");
   g->pointer_size_bytes = LLVMPointerSize(g->target_data_ref);
   define_primitive_types(g);
+  define_builtin_fns(g);
+  LLVMJaneTBAANode *tbaa_root = LLVMJaneCreateTBAARoot("jane tbaa");
+  g->tbaa_byte_node = LLVMJaneCreateTBAAScalarType(tbaa_root, "byte");
 
   Buf *producer = buf_sprintf("jane %s", JANE_VERSION_STRING);
   bool is_optimized = g->build_type == CodeGenBuildTypeRelease;
   const char *flags = "";
   unsigned runtime_version = 0;
+  unsigned emission_kind = 0;
+  switch (g->debug_info) {
+  case CodeGenDebugInfoFull:
+    emission_kind = LLVMJaneEmissionKind_FullDebug();
+    break;
+  case CodeGenDebugInfoLineTablesOnly:
+    emission_kind = LLVMJaneEmissionKind_LineTablesOnly();
+    break;
+  case CodeGenDebugInfoNone:
+    emission_kind = LLVMJaneEmissionKind_NoDebug();
+    break;
+  }
+  // with split dwarf llvm fills in the dwo name and id when emitting
   g->compile_unit = LLVMJaneCreateCompileUnit(
       g->dbuilder, LLVMJaneLang_DW_LANG_C99(), buf_ptr(source_path),
       buf_ptr(g->root_source_dir), buf_ptr(producer), is_optimized, flags,
-      runtime_version, "", 0, !g->strip_debug_symbols);
+      runtime_version, "", 0, emission_kind,
+      g->debug_info != CodeGenDebugInfoNone);
+  add_time_event(g, "init");
 }
 
-static void codegen_add_code(CodeGen *g, Buf *source_path, Buf *source_code) {
-  Buf full_path = BUF_INIT;
-  os_path_join(g->root_source_dir, source_path, &full_path);
-  Buf dirname = BUF_INIT;
-  Buf basename = BUF_INIT;
-  os_path_split(&full_path, &dirname, &basename);
-
+static AstNode *parse_file(CodeGen *g, ImportTableEntry *import_entry,
+                           Buf *source_path, Buf *source_code) {
   if (g->verbose) {
     fprintf(stderr, "\noriginal source [`%s`]:\n", buf_ptr(source_path));
     fprintf(stderr, "----\n");
@@ -618,7 +1926,7 @@ static void codegen_add_code(CodeGen *g, Buf *source_path, Buf *source_code) {
     fprintf(stderr, "\ntokens:\n");
     fprintf(stderr, "----\n");
   }
-  JaneList<Token> *tokens = tokenize(source_code);
+  JaneList<Token> *tokens = tokenize(source_code, source_path, &g->errors);
 
   if (g->verbose) {
     print_tokens(source_code, tokens);
@@ -626,18 +1934,92 @@ static void codegen_add_code(CodeGen *g, Buf *source_path, Buf *source_code) {
     fprintf(stderr, "----\n");
   }
 
-  ImportTableEntry *import_entry = allocate<ImportTableEntry>(1);
-  import_entry->fn_table.init(32);
-  import_entry->root = ast_parse(source_code, tokens);
-  assert(import_entry->root);
+  AstNode *root = ast_parse(source_code, tokens, import_entry, source_path,
+                            &g->errors);
+  assert(root);
   if (g->verbose) {
-    ast_print(import_entry->root, 0);
+    ast_print(root, 0);
+  }
+  return root;
+}
+
+// named after the source so that files with the same name in different
+// directories do not collide
+static Buf *get_interface_path(CodeGen *g, Buf *full_path) {
+  Buf dirname = BUF_INIT;
+  Buf basename = BUF_INIT;
+  os_path_split(full_path, &dirname, &basename);
+  return buf_sprintf("%s/%s-%08x.jni", buf_ptr(g->interface_dir),
+                     buf_ptr(&basename), buf_hash(full_path));
+}
+
+static AstNode *parse_import(CodeGen *g, ImportTableEntry *import_entry,
+                             Buf *source_path, Buf *full_path) {
+  OsFileStamp stamp;
+  Buf *interface_path = nullptr;
+  if (g->interface_dir && !os_file_stamp(full_path, &stamp)) {
+    interface_path = get_interface_path(g, full_path);
+    AstNode *root = interface_read(interface_path, &stamp, import_entry);
+    if (root) {
+      if (g->verbose) {
+        fprintf(stderr, "\nloaded `%s` from %s\n", buf_ptr(source_path),
+                buf_ptr(interface_path));
+      }
+      return root;
+    }
+  }
+  Buf source_code = BUF_INIT;
+  os_fetch_file_path(full_path, &source_code);
+  int error_count = g->errors.msgs.length;
+  AstNode *root = parse_file(g, import_entry, source_path, &source_code);
+  if (interface_path && g->errors.msgs.length == error_count) {
+    // only a cache, so failing to write it is not an error
+    if (interface_write(interface_path, &stamp, root) && g->verbose) {
+      fprintf(stderr, "unable to write %s: %s\n", buf_ptr(interface_path),
+              strerror(errno));
+    }
   }
+  return root;
+}
 
+// `source_code` is null for imports, which are read here unless another root
+// of the batch already parsed them
+static void codegen_add_code(CodeGen *g, Buf *source_path, Buf *source_code) {
+  Buf full_path = BUF_INIT;
+  os_path_join(g->root_source_dir, source_path, &full_path);
+  Buf dirname = BUF_INIT;
+  Buf basename = BUF_INIT;
+  os_path_split(&full_path, &dirname, &basename);
+
+  ImportTableEntry *import_entry = allocate<ImportTableEntry>(1);
+  import_entry->fn_table.init(32);
   import_entry->path = source_path;
+  auto cached = g->cache ? g->cache->parsed_files.maybe_get(&full_path)
+                         : nullptr;
+  if (cached) {
+    import_entry->root = cached->value;
+  } else {
+    int error_count = g->errors.msgs.length;
+    if (source_code) {
+      import_entry->root =
+          parse_file(g, import_entry, source_path, source_code);
+    } else {
+      import_entry->root =
+          parse_import(g, import_entry, source_path, &full_path);
+    }
+    // a tree with errors is incomplete; the next root reports them again
+    if (g->cache && g->errors.msgs.length == error_count) {
+      g->cache->parsed_files.put(
+          buf_create_from_mem(buf_ptr(&full_path), buf_len(&full_path)),
+          import_entry->root);
+    }
+  }
+
   import_entry->di_file =
       LLVMJaneCreateFile(g->dbuilder, buf_ptr(&basename), buf_ptr(&dirname));
+  import_entry->import_index = g->import_list.length;
   g->import_table.put(source_path, import_entry);
+  g->import_list.append(import_entry);
 
   assert(import_entry->root->type == NodeTypeRoot);
   for (int decl_i = 0;
@@ -648,38 +2030,51 @@ static void codegen_add_code(CodeGen *g, Buf *source_path, Buf *source_code) {
     if (top_level_decl->type != NodeTypeUse) {
       continue;
     }
+    if (err_list_full(&g->errors)) {
+      return;
+    }
     auto entry = g->import_table.maybe_get(&top_level_decl->data.use.path);
     if (!entry) {
-      Buf full_path = BUF_INIT;
-      os_path_join(g->root_source_dir, &top_level_decl->data.use.path,
-                   &full_path);
-      Buf import_code = BUF_INIT;
-      os_fetch_file_path(&full_path, &import_code);
-      codegen_add_code(g, &top_level_decl->data.use.path, &import_code);
+      codegen_add_code(g, &top_level_decl->data.use.path, nullptr);
     }
   }
 }
 
-void codegen_add_root_code(CodeGen *g, Buf *source_path, Buf *source_code) {
+bool codegen_parse_root(CodeGen *g, Buf *source_path, Buf *source_code) {
+  add_time_event(g, "start");
   init(g, source_path);
   codegen_add_code(g, source_path, source_code);
+  add_time_event(g, "parse");
+  // the tree leaves out whatever failed to parse, so analyzing it would only
+  // add follow-on errors
+  if (g->errors.msgs.length > 0) {
+    err_list_print(&g->errors);
+    return false;
+  }
+  return true;
+}
 
+void codegen_add_root_code(CodeGen *g, Buf *source_path, Buf *source_code) {
+  if (!codegen_parse_root(g, source_path, source_code)) {
+    exit(1);
+  }
+  codegen_gen_root(g);
+}
+
+void codegen_gen_root(CodeGen *g) {
   if (g->verbose) {
     fprintf(stderr, "\nsemantic analysis\n");
     fprintf(stderr, "----\n");
   }
   semantic_analyze(g);
+  add_time_event(g, "semantic_analysis");
 
-  if (g->errors.length == 0) {
+  if (g->errors.msgs.length == 0) {
     if (g->verbose) {
       fprintf(stderr, "nice one\n");
     }
   } else {
-    for (int i = 0; i < g->errors.length; i += 1) {
-      ErrorMsg *err = &g->errors.at(i);
-      fprintf(stderr, "error: line %d column %d: %s\n", err->line_start + 1,
-              err->column_start + 1, buf_ptr(err->msg));
-    }
+    err_list_print(&g->errors);
     exit(1);
   }
   if (g->verbose) {
@@ -687,6 +2082,54 @@ void codegen_add_root_code(CodeGen *g, Buf *source_path, Buf *source_code) {
     fprintf(stderr, "---\n");
   }
   do_code_gen(g);
+  add_time_event(g, "code_generation");
+}
+
+static Buf *to_c_type_entry(CodeGen *g, TypeTableEntry *type_entry) {
+  switch (type_entry->id) {
+  case TypeTableEntryIdVoid:
+  case TypeTableEntryIdUnreachable:
+    return buf_create_from_str("void");
+  case TypeTableEntryIdBool:
+    g->c_stdbool_used = true;
+    return buf_create_from_str("bool");
+  case TypeTableEntryIdInt:
+    g->c_stdint_used = true;
+    if (type_entry == g->builtin_types.entry_isize) {
+      return buf_create_from_str("intptr_t");
+    } else if (type_entry == g->builtin_types.entry_usize) {
+      return buf_create_from_str("uintptr_t");
+    }
+    return buf_sprintf("%sint%d_t", type_entry->is_signed ? "" : "u",
+                       (int)type_entry->size_in_bits);
+  case TypeTableEntryIdFloat:
+    return buf_create_from_str(type_entry->size_in_bits == 32 ? "float"
+                                                              : "double");
+  case TypeTableEntryIdPointer: {
+    // C points at the first element of an array
+    TypeTableEntry *child_type = type_entry->pointer_child;
+    while (child_type->id == TypeTableEntryIdArray) {
+      child_type = child_type->array_child;
+    }
+    Buf *child = to_c_type_entry(g, child_type);
+    return buf_sprintf("%s%s *", type_entry->pointer_is_const ? "const " : "",
+                       buf_ptr(child));
+  }
+  case TypeTableEntryIdVector:
+  case TypeTableEntryIdSlice:
+    // rejected by analysis
+    jane_unreachable();
+  case TypeTableEntryIdArray:
+    // rejected by value by analysis and unwrapped behind a pointer
+    jane_unreachable();
+  case TypeTableEntryIdStruct:
+    // only reachable through a pointer; the header forward declares it
+    type_entry->struct_used_in_c_header = true;
+    return buf_sprintf("struct %s", buf_ptr(&type_entry->name));
+  case TypeTableEntryIdInvalid:
+    jane_unreachable();
+  }
+  jane_unreachable();
 }
 
 static Buf *to_c_type(CodeGen *g, AstNode *type_node) {
@@ -696,15 +2139,7 @@ static Buf *to_c_type(CodeGen *g, AstNode *type_node) {
   TypeTableEntry *type_entry = type_node->codegen_node->data.type_node.entry;
   assert(type_entry);
 
-  if (type_entry == g->builtin_types.entry_u8) {
-    g->c_stdint_used = true;
-    return buf_create_from_str("uint8_t");
-  } else if (type_entry == g->builtin_types.entry_i32) {
-    g->c_stdint_used = true;
-    return buf_create_from_str("int32_t");
-  } else {
-    jane_panic("TODO: still working on it");
-  }
+  return to_c_type_entry(g, type_entry);
 }
 
 static void generate_h_file(CodeGen *g) {
@@ -738,7 +2173,7 @@ static void generate_h_file(CodeGen *g) {
         AstNode *param_type = param_decl_node->data.param_decl.type;
         buf_appendf(&h_buf, "%s %s", buf_ptr(to_c_type(g, param_type)),
                     buf_ptr(&param_decl_node->data.param_decl.name));
-        if (param_i < fn_proto->params.length + 1) {
+        if (param_i < fn_proto->params.length - 1) {
           buf_appendf(&h_buf, ", ");
         }
       }
@@ -755,7 +2190,16 @@ static void generate_h_file(CodeGen *g) {
   if (g->c_stdint_used) {
     fprintf(out_h, "#include <stdint.h>\n");
   }
+  if (g->c_stdbool_used) {
+    fprintf(out_h, "#include <stdbool.h>\n");
+  }
   fprintf(out_h, "\n");
+  for (int i = 0; i < g->struct_types.length; i += 1) {
+    TypeTableEntry *struct_type = g->struct_types.at(i);
+    if (struct_type->struct_used_in_c_header) {
+      fprintf(out_h, "struct %s;\n", buf_ptr(&struct_type->name));
+    }
+  }
   fprintf(out_h, "#ifdef __cplusplus\n");
   fprintf(out_h, "#define %s extern \"C\n", buf_ptr(extern_c_macro));
   fprintf(out_h, "#else\n");
@@ -777,6 +2221,88 @@ static void generate_h_file(CodeGen *g) {
   }
 }
 
+// the full path the import was read from; null for a root read from stdin
+static Buf *get_dep_path(CodeGen *g, ImportTableEntry *import) {
+  if (buf_len(import->path) == 0) {
+    return nullptr;
+  }
+  Buf *full_path = buf_alloc();
+  os_path_join(g->root_source_dir, import->path, full_path);
+  return full_path;
+}
+
+static void append_make_path(Buf *out, const char *path) {
+  for (const char *c = path; *c; c += 1) {
+    if (*c == ' ' || *c == '#') {
+      buf_append_char(out, '\\');
+    } else if (*c == '$') {
+      buf_append_char(out, '$');
+    }
+    buf_append_char(out, *c);
+  }
+}
+
+static void write_dep_file(CodeGen *g, const char *target) {
+  if (!g->dep_file_path) {
+    return;
+  }
+  Buf contents = BUF_INIT;
+  buf_resize(&contents, 0);
+  append_make_path(&contents, target);
+  buf_append_char(&contents, ':');
+  for (int i = 0; i < g->import_list.length; i += 1) {
+    Buf *dep_path = get_dep_path(g, g->import_list.at(i));
+    if (dep_path) {
+      buf_append_str(&contents, " \\\n  ");
+      append_make_path(&contents, buf_ptr(dep_path));
+    }
+  }
+  buf_append_char(&contents, '\n');
+  os_write_file(g->dep_file_path, &contents);
+}
+
+// symbols missing from the module are skipped, since a profile also names
+// functions from other objects and libraries
+static void apply_symbol_order(CodeGen *g) {
+  Buf contents = BUF_INIT;
+  os_fetch_file_path(g->symbol_order_file, &contents);
+  JaneList<LLVMValueRef> order = {0};
+  HashMap<Buf *, bool, buf_hash, buf_eql_buf> seen = {};
+  seen.init(64);
+  int line_start = 0;
+  for (int i = 0; i <= buf_len(&contents); i += 1) {
+    if (i < buf_len(&contents) && buf_ptr(&contents)[i] != '\n') {
+      continue;
+    }
+    int line_end = i;
+    while (line_end > line_start &&
+           isspace((unsigned char)buf_ptr(&contents)[line_end - 1])) {
+      line_end -= 1;
+    }
+    while (line_start < line_end &&
+           isspace((unsigned char)buf_ptr(&contents)[line_start])) {
+      line_start += 1;
+    }
+    Buf *name = buf_create_from_mem(buf_ptr(&contents) + line_start,
+                                    line_end - line_start);
+    line_start = i + 1;
+    if (buf_len(name) == 0 || buf_ptr(name)[0] == '#') {
+      continue;
+    }
+    LLVMValueRef fn = LLVMGetNamedFunction(g->module, buf_ptr(name));
+    if (!fn || LLVMIsDeclaration(fn) || seen.maybe_get(name)) {
+      continue;
+    }
+    seen.put(name, true);
+    order.append(fn);
+  }
+  seen.deinit();
+  for (int i = order.length - 1; i >= 0; i -= 1) {
+    LLVMJaneMoveFunctionToFront(order.at(i));
+  }
+  order.deinit();
+}
+
 void codegen_link(CodeGen *g, const char *out_file) {
   bool is_optimized = (g->build_type == CodeGenBuildTypeRelease);
   if (is_optimized) {
@@ -788,6 +2314,10 @@ void codegen_link(CodeGen *g, const char *out_file) {
     if (g->verbose) {
       LLVMDumpModule(g->module);
     }
+    add_time_event(g, "optimization");
+  }
+  if (g->symbol_order_file) {
+    apply_symbol_order(g);
   }
   if (g->verbose) {
     fprintf(stderr, "\nlink:\n");
@@ -802,13 +2332,25 @@ void codegen_link(CodeGen *g, const char *out_file) {
   if (g->out_type != OutTypeObj) {
     buf_append_str(&out_file_o, ".o");
   }
+  // `foo.o` splits into `foo.dwo`, `foo` into `foo.dwo`
+  Buf *out_file_dwo = nullptr;
+  if (g->split_dwarf && g->debug_info != CodeGenDebugInfoNone) {
+    int len = buf_len(&out_file_o);
+    if (len > 2 && memcmp(buf_ptr(&out_file_o) + len - 2, ".o", 2) == 0) {
+      len -= 2;
+    }
+    out_file_dwo = buf_create_from_mem(buf_ptr(&out_file_o), len);
+    buf_append_str(out_file_dwo, ".dwo");
+  }
   char *err_msg = nullptr;
-  if (LLVMTargetMachineEmitToFile(g->target_machine, g->module,
-                                  buf_ptr(&out_file_o), LLVMObjectFile,
-                                  &err_msg)) {
+  if (LLVMJaneTargetMachineEmitToFile(
+          g->target_machine, g->module, buf_ptr(&out_file_o),
+          out_file_dwo ? buf_ptr(out_file_dwo) : nullptr, &err_msg)) {
     jane_panic("unable to write object file: %s", err_msg);
   }
+  add_time_event(g, "emit_object");
   if (g->out_type == OutTypeObj) {
+    write_dep_file(g, buf_ptr(&out_file_o));
     return;
   }
   if (g->out_type == OutTypeLib && g->is_static) {
@@ -819,6 +2361,9 @@ void codegen_link(CodeGen *g, const char *out_file) {
   if (g->is_static) {
     args.append("-static");
   }
+  if (g->gc_sections) {
+    args.append("--gc-sections");
+  }
   char *JANE_NATIVE_DYNAMIC_LINKER = getenv("JANE_NATIVE_DYNAMIC_LINKER");
   if (g->is_native_target && JANE_NATIVE_DYNAMIC_LINKER) {
     if (JANE_NATIVE_DYNAMIC_LINKER[0] != 0) {
@@ -844,16 +2389,12 @@ void codegen_link(CodeGen *g, const char *out_file) {
   args.append("-o");
   args.append(out_file);
   args.append((const char *)buf_ptr(&out_file_o));
-  auto it = g->link_table.entry_iterator();
-  for (;;) {
-    auto *entry = it.next();
-    if (!entry) {
-      break;
-    }
-    Buf *arg = buf_sprintf("-l%s", buf_ptr(entry->key));
+  for (int i = 0; i < g->link_libs.length; i += 1) {
+    Buf *arg = buf_sprintf("-l%s", buf_ptr(g->link_libs.at(i)));
     args.append(buf_ptr(arg));
   }
   os_spawn_process("ld", args, false);
+  write_dep_file(g, out_file);
   if (g->out_type == OutTypeLib) {
     generate_h_file(g);
   }
@@ -861,4 +2402,50 @@ void codegen_link(CodeGen *g, const char *out_file) {
   if (g->verbose) {
     fprintf(stderr, "nice one\n");
   }
+}
+
+// stats are written as a single json object so the benchmark harness can
+// compare phases across runs. `target_init` is the fixed startup cost that
+// dominates short compiles. `deps` lists the same files as `-MF`. builds with
+// JANE_ENABLE_MEM_PROFILE add `memory`: the bytes and allocations of each
+// category, and the peak rss, which also covers llvm.
+void codegen_print_stats(CodeGen *g) {
+  Buf out = BUF_INIT;
+  buf_resize(&out, 0);
+  buf_appendf(&out, "{\"timing\":{");
+  for (int i = 1; i < g->timing_events.length; i += 1) {
+    TimeEvent *prev = &g->timing_events.at(i - 1);
+    TimeEvent *event = &g->timing_events.at(i);
+    buf_appendf(&out, "%s\"%s\":%.6f", (i == 1) ? "" : ",", event->name,
+                event->time - prev->time);
+  }
+  double total = 0.0;
+  if (g->timing_events.length > 0) {
+    total = g->timing_events.last().time - g->timing_events.at(0).time;
+  }
+  buf_appendf(&out, "},\"total\":%.6f,\"deps\":[", total);
+  bool first_dep = true;
+  for (int i = 0; i < g->import_list.length; i += 1) {
+    Buf *dep_path = get_dep_path(g, g->import_list.at(i));
+    if (dep_path) {
+      buf_append_str(&out, first_dep ? "" : ",");
+      buf_append_json_string(&out, buf_ptr(dep_path));
+      first_dep = false;
+    }
+  }
+  buf_append_str(&out, "]");
+#ifdef JANE_ENABLE_MEM_PROFILE
+  buf_append_str(&out, ",\"memory\":{");
+  for (int i = 0; i < MemCategoryCount; i += 1) {
+    MemCategoryStats *stats = &mem_category_stats[i];
+    buf_appendf(&out,
+                "\"%s\":{\"live\":%zu,\"peak\":%zu,\"live_count\":%zu,"
+                "\"count\":%zu},",
+                mem_category_name((MemCategory)i), stats->live_bytes,
+                stats->peak_bytes, stats->live_count, stats->total_count);
+  }
+  buf_appendf(&out, "\"max_rss\":%lld}", (long long)os_max_rss());
+#endif
+  buf_append_str(&out, "}\n");
+  fwrite(buf_ptr(&out), 1, buf_len(&out), stderr);
 }
\ No newline at end of file
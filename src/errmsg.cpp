@@ -0,0 +1,86 @@
+#include "include/errmsg.hpp"
+#include "include/util.hpp"
+
+#include <stdio.h>
+
+void err_list_add(ErrorList *errors, ErrorCode code, Buf *path,
+                  int line_start, int column_start, int line_end,
+                  int column_end, Buf *msg) {
+  if (errors->limit_reached) {
+    return;
+  }
+  ErrorMsg *last_msg = &errors->msgs.add_one();
+  last_msg->code = code;
+  last_msg->path = path;
+  last_msg->line_start = line_start;
+  last_msg->column_start = column_start;
+  last_msg->line_end = line_end;
+  last_msg->column_end = column_end;
+  last_msg->msg = msg;
+  errors->limit_reached =
+      errors->max_errors > 0 && errors->msgs.length >= errors->max_errors;
+}
+
+const char *err_code_str(ErrorCode code) {
+  switch (code) {
+  case ErrorCodeLexical:
+    return "lexical";
+  case ErrorCodeSyntax:
+    return "syntax";
+  case ErrorCodeSemantic:
+    return "semantic";
+  case ErrorCodeComptime:
+    return "comptime";
+  }
+  jane_unreachable();
+}
+
+static void append_json_error(Buf *out, ErrorMsg *err) {
+  buf_appendf(out, "{\"severity\":\"error\",\"code\":\"%s\",\"path\":",
+              err_code_str(err->code));
+  buf_append_json_string(out, buf_ptr(err->path));
+  buf_appendf(out,
+              ",\"line_start\":%d,\"column_start\":%d,\"line_end\":%d,"
+              "\"column_end\":%d,\"message\":",
+              err->line_start + 1, err->column_start + 1, err->line_end + 1,
+              err->column_end + 1);
+  buf_append_json_string(out, buf_ptr(err->msg));
+  buf_append_str(out, "}\n");
+}
+
+void err_list_print(ErrorList *errors) {
+  // formatted up front so that errors from concurrent builds sharing the
+  // terminal do not interleave
+  Buf out = BUF_INIT;
+  buf_resize(&out, 0);
+  for (int i = 0; i < errors->msgs.length; i += 1) {
+    ErrorMsg *err = &errors->msgs.at(i);
+    switch (errors->format) {
+    case DiagFormatText:
+      buf_appendf(&out, "%s:%d:%d: error: %s\n", buf_ptr(err->path),
+                  err->line_start + 1, err->column_start + 1,
+                  buf_ptr(err->msg));
+      break;
+    case DiagFormatJson:
+      append_json_error(&out, err);
+      break;
+    }
+  }
+  if (errors->limit_reached) {
+    switch (errors->format) {
+    case DiagFormatText:
+      buf_appendf(&out, "error: stopping after %d errors (--max-errors)\n",
+                  errors->max_errors);
+      break;
+    case DiagFormatJson:
+      buf_appendf(&out,
+                  "{\"severity\":\"note\",\"code\":\"max-errors\","
+                  "\"message\":\"stopping after %d errors\"}\n",
+                  errors->max_errors);
+      break;
+    }
+  }
+  fwrite(buf_ptr(&out), 1, buf_len(&out), stderr);
+  fflush(stderr);
+  out.list.deinit();
+}
\ No newline at end of file
@@ -0,0 +1,915 @@
+#include "include/eval.hpp"
+#include "include/analyze.hpp"
+#include "include/parser.hpp"
+#include "include/semantic_info.hpp"
+#include "include/util.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+
+// runaway evaluation becomes an error instead of hanging the compiler
+static const int max_call_depth = 1000;
+static const uint64_t max_backward_branches = 1000000;
+
+enum EvalResult {
+  EvalResultOk,
+  EvalResultReturn,
+  EvalResultBreak,
+  EvalResultContinue,
+  EvalResultError,
+};
+
+struct EvalVar {
+  LocalVariableTableEntry *variable;
+  ConstExprValue *value;
+};
+
+struct EvalContext {
+  CodeGen *g;
+  // variables of the function being evaluated, innermost scope last
+  JaneList<EvalVar> *vars;
+  ConstExprValue *return_value;
+  int call_depth;
+  uint64_t backward_branches;
+};
+
+bool type_has_const_value(TypeTableEntry *type) {
+  switch (type->id) {
+  case TypeTableEntryIdBool:
+  case TypeTableEntryIdFloat:
+    return true;
+  case TypeTableEntryIdInt:
+    return type->size_in_bits <= 64;
+  case TypeTableEntryIdArray:
+    return type_has_const_value(type->array_child);
+  case TypeTableEntryIdStruct:
+    if (!type->struct_complete || type->struct_is_invalid) {
+      return false;
+    }
+    for (int i = 0; i < type->struct_field_count; i += 1) {
+      if (!type_has_const_value(type->struct_fields[i].type_entry)) {
+        return false;
+      }
+    }
+    return true;
+  case TypeTableEntryIdInvalid:
+  case TypeTableEntryIdVoid:
+  case TypeTableEntryIdUnreachable:
+  case TypeTableEntryIdPointer:
+  case TypeTableEntryIdVector:
+  case TypeTableEntryIdSlice:
+    return false;
+  }
+  jane_unreachable();
+}
+
+static int get_element_count(TypeTableEntry *type) {
+  if (type->id == TypeTableEntryIdArray) {
+    return (int)type->array_len;
+  } else if (type->id == TypeTableEntryIdStruct) {
+    return type->struct_field_count;
+  }
+  return 0;
+}
+
+static TypeTableEntry *get_element_type(TypeTableEntry *type, int index) {
+  if (type->id == TypeTableEntryIdArray) {
+    return type->array_child;
+  }
+  return type->struct_fields[index].type_entry;
+}
+
+// zero initialized
+static void init_const_val(ConstExprValue *val, TypeTableEntry *type) {
+  val->type = type;
+  int count = get_element_count(type);
+  if (count > 0) {
+    val->elements = allocate<ConstExprValue>(count);
+    for (int i = 0; i < count; i += 1) {
+      init_const_val(&val->elements[i], get_element_type(type, i));
+    }
+  }
+}
+
+static ConstExprValue *create_const_val(TypeTableEntry *type) {
+  ConstExprValue *val = allocate<ConstExprValue>(1);
+  init_const_val(val, type);
+  return val;
+}
+
+// aggregates are copied element by element, so values never share storage
+static void copy_const_val(ConstExprValue *dest, ConstExprValue *src) {
+  assert(dest->type == src->type);
+  dest->x_int = src->x_int;
+  dest->x_float = src->x_float;
+  dest->x_bool = src->x_bool;
+  int count = get_element_count(src->type);
+  for (int i = 0; i < count; i += 1) {
+    copy_const_val(&dest->elements[i], &src->elements[i]);
+  }
+}
+
+static ConstExprValue *clone_const_val(ConstExprValue *src) {
+  ConstExprValue *val = create_const_val(src->type);
+  copy_const_val(val, src);
+  return val;
+}
+
+static uint64_t wrap_int(TypeTableEntry *type, uint64_t x) {
+  unsigned bits = (unsigned)type->size_in_bits;
+  if (bits >= 64) {
+    return x;
+  }
+  uint64_t mask = (1ULL << bits) - 1;
+  x &= mask;
+  if (type->is_signed && ((x >> (bits - 1)) & 1)) {
+    x |= ~mask;
+  }
+  return x;
+}
+
+static double round_float(TypeTableEntry *type, double x) {
+  return type->size_in_bits == 32 ? (double)(float)x : x;
+}
+
+static EvalResult eval_error(EvalContext *ctx, AstNode *node, Buf *msg) {
+  add_node_error_code(ctx->g, node, ErrorCodeComptime, msg);
+  return EvalResultError;
+}
+
+static EvalResult eval_expr(EvalContext *ctx, AstNode *node,
+                            ConstExprValue **out);
+
+static ConstExprValue *find_variable_value(EvalContext *ctx,
+                                           AstNode *symbol_node) {
+  BlockContext *context = symbol_node->codegen_node->expr_node.block_context;
+  LocalVariableTableEntry *variable =
+      find_local_variable(context, &symbol_node->data.symbol);
+  if (!variable) {
+    return nullptr;
+  }
+  for (int i = ctx->vars->length - 1; i >= 0; i -= 1) {
+    if (ctx->vars->at(i).variable == variable) {
+      return ctx->vars->at(i).value;
+    }
+  }
+  return nullptr;
+}
+
+static EvalResult eval_index(EvalContext *ctx, AstNode *subscript,
+                             TypeTableEntry *array_type, int *index) {
+  ConstExprValue *index_val;
+  EvalResult result = eval_expr(ctx, subscript, &index_val);
+  if (result != EvalResultOk) {
+    return result;
+  }
+  uint64_t x = index_val->x_int;
+  if ((index_val->type->is_signed && (int64_t)x < 0) ||
+      x >= array_type->array_len) {
+    return eval_error(ctx, subscript,
+                      buf_sprintf("index %lld is out of bounds for `%s`",
+                                  (long long)x, buf_ptr(&array_type->name)));
+  }
+  *index = (int)x;
+  return EvalResultOk;
+}
+
+// the storage named by an assignment target
+static EvalResult eval_lvalue(EvalContext *ctx, AstNode *node,
+                              ConstExprValue **out) {
+  switch (node->type) {
+  case NodeTypeSymbol: {
+    ConstExprValue *val = find_variable_value(ctx, node);
+    if (!val) {
+      return eval_error(ctx, node,
+                        buf_sprintf("unable to evaluate `%s` at compile time",
+                                    buf_ptr(&node->data.symbol)));
+    }
+    *out = val;
+    return EvalResultOk;
+  }
+  case NodeTypeFieldAccessExpr: {
+    AstNode *struct_expr = node->data.field_access_expr.struct_expr;
+    TypeTableEntry *struct_type =
+        struct_expr->codegen_node->expr_node.type_entry;
+    TypeStructField *field = node->codegen_node->data.field_access_node.field;
+    if (struct_type->id != TypeTableEntryIdStruct) {
+      break;
+    }
+    ConstExprValue *base;
+    EvalResult result = eval_lvalue(ctx, struct_expr, &base);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    *out = &base->elements[field - struct_type->struct_fields];
+    return EvalResultOk;
+  }
+  case NodeTypeArrayAccessExpr: {
+    AstNode *array_ref_expr = node->data.array_access_expr.array_ref_expr;
+    TypeTableEntry *array_type =
+        array_ref_expr->codegen_node->expr_node.type_entry;
+    if (array_type->id != TypeTableEntryIdArray) {
+      break;
+    }
+    ConstExprValue *base;
+    EvalResult result = eval_lvalue(ctx, array_ref_expr, &base);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    int index;
+    result = eval_index(ctx, node->data.array_access_expr.subscript,
+                        array_type, &index);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    *out = &base->elements[index];
+    return EvalResultOk;
+  }
+  default:
+    break;
+  }
+  return eval_error(ctx, node,
+                    buf_sprintf("unable to assign through this expression at "
+                                "compile time"));
+}
+
+static bool eval_cmp(BinOpType bin_op, ConstExprValue *op1,
+                     ConstExprValue *op2) {
+  TypeTableEntry *type = op1->type;
+  if (type->id == TypeTableEntryIdFloat) {
+    // C comparisons have the same NaN behavior as the generated code
+    double x = op1->x_float;
+    double y = op2->x_float;
+    switch (bin_op) {
+    case BinOpTypeCmpEq:
+      return x == y;
+    case BinOpTypeCmpNotEq:
+      return x != y;
+    case BinOpTypeCmpLessThan:
+      return x < y;
+    case BinOpTypeCmpGreaterThan:
+      return x > y;
+    case BinOpTypeCmpLessOrEq:
+      return x <= y;
+    case BinOpTypeCmpGreaterOrEq:
+      return x >= y;
+    default:
+      jane_unreachable();
+    }
+  }
+  int order;
+  if (type->id == TypeTableEntryIdBool) {
+    order = (int)op1->x_bool - (int)op2->x_bool;
+  } else if (type->is_signed) {
+    int64_t x = (int64_t)op1->x_int;
+    int64_t y = (int64_t)op2->x_int;
+    order = x < y ? -1 : (x > y ? 1 : 0);
+  } else {
+    uint64_t x = op1->x_int;
+    uint64_t y = op2->x_int;
+    order = x < y ? -1 : (x > y ? 1 : 0);
+  }
+  switch (bin_op) {
+  case BinOpTypeCmpEq:
+    return order == 0;
+  case BinOpTypeCmpNotEq:
+    return order != 0;
+  case BinOpTypeCmpLessThan:
+    return order < 0;
+  case BinOpTypeCmpGreaterThan:
+    return order > 0;
+  case BinOpTypeCmpLessOrEq:
+    return order <= 0;
+  case BinOpTypeCmpGreaterOrEq:
+    return order >= 0;
+  default:
+    jane_unreachable();
+  }
+}
+
+// operations that would be undefined in the generated code are errors
+static EvalResult eval_int_arithmetic(EvalContext *ctx, AstNode *node,
+                                      TypeTableEntry *type, uint64_t x,
+                                      uint64_t y, uint64_t *out) {
+  BinOpType bin_op = node->data.bin_op_expr.bin_op;
+  unsigned bits = (unsigned)type->size_in_bits;
+  uint64_t result;
+  switch (bin_op) {
+  case BinOpTypeAdd:
+    result = x + y;
+    break;
+  case BinOpTypeSub:
+    result = x - y;
+    break;
+  case BinOpTypeMult:
+    result = x * y;
+    break;
+  case BinOpTypeDiv:
+  case BinOpTypeMod:
+    if (y == 0) {
+      return eval_error(ctx, node, buf_sprintf("division by zero"));
+    }
+    if (type->is_signed) {
+      uint64_t min_value = wrap_int(type, 1ULL << (bits - 1));
+      if (x == min_value && y == (uint64_t)-1) {
+        return eval_error(ctx, node, buf_sprintf("integer overflow"));
+      }
+      result = bin_op == BinOpTypeDiv ? (uint64_t)((int64_t)x / (int64_t)y)
+                                      : (uint64_t)((int64_t)x % (int64_t)y);
+    } else {
+      result = bin_op == BinOpTypeDiv ? x / y : x % y;
+    }
+    break;
+  case BinOpTypeBinOr:
+    result = x | y;
+    break;
+  case BinOpTypeBinXor:
+    result = x ^ y;
+    break;
+  case BinOpTypeBinAnd:
+    result = x & y;
+    break;
+  case BinOpTypeBitShiftLeft:
+  case BinOpTypeBitShiftRight:
+    if (y >= bits) {
+      return eval_error(ctx, node,
+                        buf_sprintf("shift amount %lld is too large for `%s`",
+                                    (long long)y, buf_ptr(&type->name)));
+    }
+    if (bin_op == BinOpTypeBitShiftLeft) {
+      result = x << y;
+    } else if (type->is_signed) {
+      result = (uint64_t)((int64_t)x >> y);
+    } else {
+      result = x >> y;
+    }
+    break;
+  default:
+    jane_unreachable();
+  }
+  *out = wrap_int(type, result);
+  return EvalResultOk;
+}
+
+static double eval_float_arithmetic(BinOpType bin_op, TypeTableEntry *type,
+                                    double x, double y) {
+  double result;
+  switch (bin_op) {
+  case BinOpTypeAdd:
+    result = x + y;
+    break;
+  case BinOpTypeSub:
+    result = x - y;
+    break;
+  case BinOpTypeMult:
+    result = x * y;
+    break;
+  case BinOpTypeDiv:
+    result = x / y;
+    break;
+  case BinOpTypeMod:
+    result = fmod(x, y);
+    break;
+  default:
+    jane_unreachable();
+  }
+  return round_float(type, result);
+}
+
+static EvalResult eval_bin_op_expr(EvalContext *ctx, AstNode *node,
+                                   ConstExprValue **out) {
+  BinOpType bin_op = node->data.bin_op_expr.bin_op;
+  TypeTableEntry *type = node->codegen_node->expr_node.type_entry;
+  ConstExprValue *op1;
+  ConstExprValue *op2;
+  EvalResult result;
+  if (bin_op == BinOpTypeAssign) {
+    result = eval_expr(ctx, node->data.bin_op_expr.op2, &op2);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    result = eval_lvalue(ctx, node->data.bin_op_expr.op1, &op1);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    copy_const_val(op1, op2);
+    *out = create_const_val(type);
+    return EvalResultOk;
+  }
+  result = eval_expr(ctx, node->data.bin_op_expr.op1, &op1);
+  if (result != EvalResultOk) {
+    return result;
+  }
+  ConstExprValue *val = create_const_val(type);
+  *out = val;
+  if ((bin_op == BinOpTypeBoolAnd && !op1->x_bool) ||
+      (bin_op == BinOpTypeBoolOr && op1->x_bool)) {
+    val->x_bool = op1->x_bool;
+    return EvalResultOk;
+  }
+  result = eval_expr(ctx, node->data.bin_op_expr.op2, &op2);
+  if (result != EvalResultOk) {
+    return result;
+  }
+  switch (bin_op) {
+  case BinOpTypeBoolAnd:
+  case BinOpTypeBoolOr:
+    val->x_bool = op2->x_bool;
+    return EvalResultOk;
+  case BinOpTypeCmpEq:
+  case BinOpTypeCmpNotEq:
+  case BinOpTypeCmpLessThan:
+  case BinOpTypeCmpGreaterThan:
+  case BinOpTypeCmpLessOrEq:
+  case BinOpTypeCmpGreaterOrEq:
+    val->x_bool = eval_cmp(bin_op, op1, op2);
+    return EvalResultOk;
+  case BinOpTypeBinOr:
+  case BinOpTypeBinXor:
+  case BinOpTypeBinAnd:
+  case BinOpTypeBitShiftLeft:
+  case BinOpTypeBitShiftRight:
+  case BinOpTypeAdd:
+  case BinOpTypeSub:
+  case BinOpTypeMult:
+  case BinOpTypeDiv:
+  case BinOpTypeMod:
+    if (type->id == TypeTableEntryIdBool) {
+      bool x = op1->x_bool;
+      bool y = op2->x_bool;
+      val->x_bool = bin_op == BinOpTypeBinOr    ? (x || y)
+                    : bin_op == BinOpTypeBinXor ? (x != y)
+                                                : (x && y);
+      return EvalResultOk;
+    } else if (type->id == TypeTableEntryIdFloat) {
+      val->x_float =
+          eval_float_arithmetic(bin_op, type, op1->x_float, op2->x_float);
+      return EvalResultOk;
+    }
+    return eval_int_arithmetic(ctx, node, type, op1->x_int, op2->x_int,
+                               &val->x_int);
+  case BinOpTypeAssign:
+  case BinOpTypeInvalid:
+    jane_unreachable();
+  }
+  jane_unreachable();
+}
+
+static EvalResult eval_cast_expr(EvalContext *ctx, AstNode *node,
+                                 ConstExprValue **out) {
+  ConstExprValue *src;
+  EvalResult result = eval_expr(ctx, node->data.cast_expr.prefix_op_expr, &src);
+  if (result != EvalResultOk) {
+    return result;
+  }
+  TypeTableEntry *dest_type = node->codegen_node->expr_node.type_entry;
+  TypeTableEntry *src_type = src->type;
+  if (src_type == dest_type) {
+    *out = src;
+    return EvalResultOk;
+  }
+  ConstExprValue *val = create_const_val(dest_type);
+  *out = val;
+  if (dest_type->id == TypeTableEntryIdFloat) {
+    if (src_type->id == TypeTableEntryIdFloat) {
+      val->x_float = src->x_float;
+    } else if (src_type->is_signed) {
+      val->x_float = (double)(int64_t)src->x_int;
+    } else {
+      val->x_float = (double)src->x_int;
+    }
+    val->x_float = round_float(dest_type, val->x_float);
+    return EvalResultOk;
+  }
+  assert(dest_type->id == TypeTableEntryIdInt);
+  if (src_type->id == TypeTableEntryIdBool) {
+    val->x_int = src->x_bool;
+  } else if (src_type->id == TypeTableEntryIdInt) {
+    val->x_int = wrap_int(dest_type, src->x_int);
+  } else {
+    assert(src_type->id == TypeTableEntryIdFloat);
+    double truncated = trunc(src->x_float);
+    int bits = (int)dest_type->size_in_bits;
+    double min_value = dest_type->is_signed ? -ldexp(1.0, bits - 1) : 0.0;
+    double max_value = ldexp(1.0, dest_type->is_signed ? bits - 1 : bits);
+    if (!(truncated >= min_value && truncated < max_value)) {
+      return eval_error(ctx, node,
+                        buf_sprintf("float value %g does not fit in `%s`",
+                                    src->x_float, buf_ptr(&dest_type->name)));
+    }
+    val->x_int = dest_type->is_signed ? (uint64_t)(int64_t)truncated
+                                      : (uint64_t)truncated;
+  }
+  return EvalResultOk;
+}
+
+static EvalResult eval_prefix_op_expr(EvalContext *ctx, AstNode *node,
+                                      ConstExprValue **out) {
+  ConstExprValue *operand;
+  EvalResult result =
+      eval_expr(ctx, node->data.prefix_op_expr.primary_expr, &operand);
+  if (result != EvalResultOk) {
+    return result;
+  }
+  TypeTableEntry *type = node->codegen_node->expr_node.type_entry;
+  ConstExprValue *val = create_const_val(type);
+  *out = val;
+  switch (node->data.prefix_op_expr.prefix_op) {
+  case PrefixOpNegation:
+    if (type->id == TypeTableEntryIdFloat) {
+      val->x_float = -operand->x_float;
+    } else {
+      val->x_int = wrap_int(type, 0 - operand->x_int);
+    }
+    return EvalResultOk;
+  case PrefixOpBoolNot:
+    val->x_bool = !operand->x_bool;
+    return EvalResultOk;
+  case PrefixOpBinNot:
+    val->x_int = wrap_int(type, ~operand->x_int);
+    return EvalResultOk;
+  case PrefixOpAddressOf:
+  case PrefixOpDereference:
+  case PrefixOpInvalid:
+    // pointer typed, rejected before evaluating the operand
+    jane_unreachable();
+  }
+  jane_unreachable();
+}
+
+static EvalResult eval_fn_call_expr(EvalContext *ctx, AstNode *node,
+                                    ConstExprValue **out) {
+  CodeGen *g = ctx->g;
+  JaneList<AstNode *> *params = &node->data.fn_call_expr.params;
+  if (node->data.fn_call_expr.is_builtin) {
+    BuiltinFnEntry *builtin_fn =
+        node->codegen_node->data.fn_call_node.builtin_fn;
+    if (builtin_fn->id == BuiltinFnIdComptime) {
+      return eval_expr(ctx, params->at(0), out);
+    }
+    return eval_error(ctx, node,
+                      buf_sprintf("`@%s` cannot be evaluated at compile time",
+                                  buf_ptr(&builtin_fn->name)));
+  }
+  FnTableEntry *fn_table_entry = node->codegen_node->data.fn_call_node.fn_entry;
+  Buf *name = &fn_table_entry->proto_node->data.fn_proto.name;
+  if (fn_table_entry->is_extern) {
+    return eval_error(ctx, node,
+                      buf_sprintf("cannot call extern function `%s` at "
+                                  "compile time",
+                                  buf_ptr(name)));
+  }
+  analyze_fn_body(g, fn_table_entry);
+  if (!fn_table_entry->body_analyzed) {
+    return eval_error(ctx, node,
+                      buf_sprintf("`%s` is called at compile time while it is "
+                                  "being analyzed",
+                                  buf_ptr(name)));
+  }
+  if (ctx->call_depth >= max_call_depth) {
+    return eval_error(ctx, node,
+                      buf_sprintf("compile time evaluation exceeded %d nested "
+                                  "calls",
+                                  max_call_depth));
+  }
+  ConstExprValue **args = allocate<ConstExprValue *>(params->length);
+  for (int i = 0; i < params->length; i += 1) {
+    EvalResult result = eval_expr(ctx, params->at(i), &args[i]);
+    if (result != EvalResultOk) {
+      deallocate(args, params->length);
+      return result;
+    }
+    args[i] = clone_const_val(args[i]);
+  }
+
+  AstNode *fn_def_node = fn_table_entry->fn_def_node;
+  FnDefNode *fn_def = &fn_def_node->codegen_node->data.fn_def_node;
+  JaneList<EvalVar> vars = {0};
+  for (int i = 0; i < fn_def->variable_list.length; i += 1) {
+    LocalVariableTableEntry *variable = fn_def->variable_list.at(i);
+    if (variable->arg_index >= 0) {
+      vars.append({variable, args[variable->arg_index]});
+    }
+  }
+  deallocate(args, params->length);
+  JaneList<EvalVar> *caller_vars = ctx->vars;
+  ctx->vars = &vars;
+  ctx->call_depth += 1;
+  ConstExprValue *body_val;
+  EvalResult result = eval_expr(ctx, fn_def_node->data.fn_def.body, &body_val);
+  ctx->call_depth -= 1;
+  ctx->vars = caller_vars;
+  vars.deinit();
+
+  if (result == EvalResultReturn) {
+    *out = ctx->return_value;
+    ctx->return_value = nullptr;
+    return EvalResultOk;
+  } else if (result == EvalResultOk) {
+    // fell off the end of a void function
+    *out = create_const_val(node->codegen_node->expr_node.type_entry);
+    return EvalResultOk;
+  }
+  assert(result == EvalResultError);
+  return result;
+}
+
+static EvalResult count_backward_branch(EvalContext *ctx, AstNode *node) {
+  ctx->backward_branches += 1;
+  if (ctx->backward_branches > max_backward_branches) {
+    return eval_error(ctx, node,
+                      buf_sprintf("compile time evaluation exceeded %llu loop "
+                                  "iterations",
+                                  (unsigned long long)max_backward_branches));
+  }
+  return EvalResultOk;
+}
+
+static EvalResult eval_condition(EvalContext *ctx, AstNode *node,
+                                 bool *value) {
+  ConstExprValue *val;
+  EvalResult result = eval_expr(ctx, node, &val);
+  if (result == EvalResultOk) {
+    *value = val->x_bool;
+  }
+  return result;
+}
+
+static EvalResult eval_loop(EvalContext *ctx, AstNode *node,
+                            AstNode *condition, AstNode *body, AstNode *step) {
+  for (;;) {
+    bool keep_going = true;
+    EvalResult result;
+    if (condition) {
+      result = eval_condition(ctx, condition, &keep_going);
+      if (result != EvalResultOk) {
+        return result;
+      }
+    }
+    if (!keep_going) {
+      return EvalResultOk;
+    }
+    ConstExprValue *ignored;
+    result = eval_expr(ctx, body, &ignored);
+    if (result == EvalResultBreak) {
+      return EvalResultOk;
+    } else if (result != EvalResultOk && result != EvalResultContinue) {
+      return result;
+    }
+    if (step) {
+      result = eval_expr(ctx, step, &ignored);
+      if (result != EvalResultOk) {
+        return result;
+      }
+    }
+    result = count_backward_branch(ctx, node);
+    if (result != EvalResultOk) {
+      return result;
+    }
+  }
+}
+
+static EvalResult eval_expr(EvalContext *ctx, AstNode *node,
+                            ConstExprValue **out) {
+  CodeGen *g = ctx->g;
+  TypeTableEntry *type =
+      node->codegen_node ? node->codegen_node->expr_node.type_entry : nullptr;
+  if (!type || type->id == TypeTableEntryIdInvalid) {
+    // analysis already reported an error
+    return EvalResultError;
+  } else if (type->id == TypeTableEntryIdPointer ||
+             type->id == TypeTableEntryIdSlice ||
+             type->id == TypeTableEntryIdVector ||
+             (type->id == TypeTableEntryIdInt && type->size_in_bits > 64)) {
+    return eval_error(ctx, node,
+                      buf_sprintf("values of type `%s` cannot be computed at "
+                                  "compile time",
+                                  buf_ptr(&type->name)));
+  }
+  switch (node->type) {
+  case NodeTypeNumberLiteral: {
+    ConstExprValue *val = create_const_val(type);
+    const char *text = buf_ptr(&node->data.number);
+    if (type->id == TypeTableEntryIdFloat) {
+      val->x_float = round_float(type, strtod(text, nullptr));
+    } else {
+      val->x_int = wrap_int(type, strtoull(text, nullptr, 10));
+    }
+    *out = val;
+    return EvalResultOk;
+  }
+  case NodeTypeBoolLiteral: {
+    ConstExprValue *val = create_const_val(type);
+    val->x_bool = node->data.bool_literal;
+    *out = val;
+    return EvalResultOk;
+  }
+  case NodeTypeSymbol: {
+    GlobalConstEntry *global_const =
+        node->codegen_node->data.symbol_node.global_const;
+    ConstExprValue *val = global_const ? eval_global_const(g, global_const)
+                                       : find_variable_value(ctx, node);
+    if (global_const && !val) {
+      return EvalResultError;
+    } else if (!val) {
+      return eval_error(ctx, node,
+                        buf_sprintf("unable to evaluate `%s` at compile time",
+                                    buf_ptr(&node->data.symbol)));
+    }
+    *out = val;
+    return EvalResultOk;
+  }
+  case NodeTypeBlock: {
+    int var_count = ctx->vars->length;
+    EvalResult result = EvalResultOk;
+    for (int i = 0; i < node->data.block.statements.length; i += 1) {
+      ConstExprValue *ignored;
+      result = eval_expr(ctx, node->data.block.statements.at(i), &ignored);
+      if (result != EvalResultOk) {
+        break;
+      }
+    }
+    ctx->vars->resize(var_count);
+    *out = create_const_val(type);
+    return result;
+  }
+  case NodeTypeVariableDeclaration: {
+    LocalVariableTableEntry *variable =
+        node->codegen_node->data.var_decl_node.variable;
+    ConstExprValue *val = create_const_val(variable->type);
+    AstNode *expr = node->data.variable_declaration.expr;
+    if (expr) {
+      ConstExprValue *init_val;
+      EvalResult result = eval_expr(ctx, expr, &init_val);
+      if (result != EvalResultOk) {
+        return result;
+      }
+      copy_const_val(val, init_val);
+    }
+    ctx->vars->append({variable, val});
+    *out = create_const_val(type);
+    return EvalResultOk;
+  }
+  case NodeTypeBinOpExpr:
+    return eval_bin_op_expr(ctx, node, out);
+  case NodeTypeCastExpr:
+    return eval_cast_expr(ctx, node, out);
+  case NodeTypePrefixOpExpr:
+    return eval_prefix_op_expr(ctx, node, out);
+  case NodeTypeFnCallExpr:
+    return eval_fn_call_expr(ctx, node, out);
+  case NodeTypeFieldAccessExpr: {
+    AstNode *struct_expr = node->data.field_access_expr.struct_expr;
+    TypeTableEntry *struct_type =
+        struct_expr->codegen_node->expr_node.type_entry;
+    TypeStructField *field = node->codegen_node->data.field_access_node.field;
+    if (!field) {
+      // the length of an array, known without evaluating the array
+      TypeTableEntry *array_type = struct_type->id == TypeTableEntryIdPointer
+                                       ? struct_type->pointer_child
+                                       : struct_type;
+      ConstExprValue *val = create_const_val(type);
+      val->x_int = array_type->array_len;
+      *out = val;
+      return EvalResultOk;
+    }
+    ConstExprValue *base;
+    EvalResult result = eval_expr(ctx, struct_expr, &base);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    *out = &base->elements[field - struct_type->struct_fields];
+    return EvalResultOk;
+  }
+  case NodeTypeArrayAccessExpr: {
+    AstNode *array_ref_expr = node->data.array_access_expr.array_ref_expr;
+    ConstExprValue *base;
+    EvalResult result = eval_expr(ctx, array_ref_expr, &base);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    int index;
+    result = eval_index(ctx, node->data.array_access_expr.subscript,
+                        base->type, &index);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    *out = &base->elements[index];
+    return EvalResultOk;
+  }
+  case NodeTypeIfExpr: {
+    bool condition;
+    EvalResult result =
+        eval_condition(ctx, node->data.if_expr.condition, &condition);
+    if (result != EvalResultOk) {
+      return result;
+    }
+    *out = create_const_val(type);
+    ConstExprValue *ignored;
+    if (condition) {
+      return eval_expr(ctx, node->data.if_expr.then_block, &ignored);
+    } else if (node->data.if_expr.else_node) {
+      return eval_expr(ctx, node->data.if_expr.else_node, &ignored);
+    }
+    return EvalResultOk;
+  }
+  case NodeTypeWhileExpr:
+    *out = create_const_val(type);
+    return eval_loop(ctx, node, node->data.while_expr.condition,
+                     node->data.while_expr.body, nullptr);
+  case NodeTypeForExpr: {
+    AstNodeForExpr *for_expr = &node->data.for_expr;
+    int var_count = ctx->vars->length;
+    EvalResult result = EvalResultOk;
+    if (for_expr->init) {
+      ConstExprValue *ignored;
+      result = eval_expr(ctx, for_expr->init, &ignored);
+    }
+    if (result == EvalResultOk) {
+      result = eval_loop(ctx, node, for_expr->condition, for_expr->body,
+                         for_expr->step);
+    }
+    ctx->vars->resize(var_count);
+    *out = create_const_val(type);
+    return result;
+  }
+  case NodeTypeReturnExpr: {
+    AstNode *expr = node->data.return_expr.expression;
+    if (!expr) {
+      ctx->return_value = create_const_val(g->builtin_types.entry_void);
+      return EvalResultReturn;
+    }
+    EvalResult result = eval_expr(ctx, expr, &ctx->return_value);
+    return result == EvalResultOk ? EvalResultReturn : result;
+  }
+  case NodeTypeBreak:
+    return EvalResultBreak;
+  case NodeTypeContinue:
+    return EvalResultContinue;
+  case NodeTypeUnreachable:
+    return eval_error(ctx, node,
+                      buf_sprintf("reached unreachable code at compile time"));
+  case NodeTypeAsmExpr:
+    return eval_error(ctx, node,
+                      buf_sprintf("inline assembly cannot be evaluated at "
+                                  "compile time"));
+  case NodeTypeStringLiteral:
+    // pointer or slice typed
+    jane_unreachable();
+  case NodeTypeRoot:
+  case NodeTypeRootExportDecl:
+  case NodeTypeFnProto:
+  case NodeTypeFnDef:
+  case NodeTypeFnDecl:
+  case NodeTypeParamDecl:
+  case NodeTypeType:
+  case NodeTypeExternBlock:
+  case NodeTypeDirective:
+  case NodeTypeUse:
+  case NodeTypeStructDecl:
+  case NodeTypeStructField:
+    jane_unreachable();
+  }
+  jane_unreachable();
+}
+
+ConstExprValue *eval_const_expr(CodeGen *g, AstNode *node) {
+  JaneList<EvalVar> vars = {0};
+  EvalContext ctx = {0};
+  ctx.g = g;
+  ctx.vars = &vars;
+  ConstExprValue *val;
+  EvalResult result = eval_expr(&ctx, node, &val);
+  vars.deinit();
+  // a stray return, break or continue was reported during analysis
+  return result == EvalResultOk ? val : nullptr;
+}
+
+ConstExprValue *eval_global_const(CodeGen *g, GlobalConstEntry *global_const) {
+  if (global_const->value || global_const->eval_failed) {
+    return global_const->value;
+  }
+  resolve_global_const(g, global_const);
+  if (global_const->type->id == TypeTableEntryIdInvalid) {
+    global_const->eval_failed = true;
+    return nullptr;
+  }
+  AstNode *decl_node = global_const->decl_node;
+  if (global_const->evaluating) {
+    add_node_error(g, decl_node,
+                   buf_sprintf("constant `%s` depends on itself",
+                               buf_ptr(global_const->name)));
+    global_const->eval_failed = true;
+    return nullptr;
+  }
+  global_const->evaluating = true;
+  ConstExprValue *val =
+      eval_const_expr(g, decl_node->data.variable_declaration.expr);
+  global_const->evaluating = false;
+  if (!val) {
+    global_const->eval_failed = true;
+    return nullptr;
+  }
+  global_const->value = val;
+  return val;
+}
\ No newline at end of file
@@ -4,7 +4,16 @@
 #include "semantic_info.hpp"
 
 struct CodeGen;
-struct ImportTableEntry;
 void semantic_analyze(CodeGen *g);
 
+void add_node_error(CodeGen *g, AstNode *node, Buf *msg);
+void add_node_error_code(CodeGen *g, AstNode *node, ErrorCode code,
+                         Buf *msg);
+void analyze_fn_body(CodeGen *g, FnTableEntry *fn_table_entry);
+void resolve_global_const(CodeGen *g, GlobalConstEntry *global_const);
+unsigned get_type_alignment(CodeGen *g, TypeTableEntry *type);
+
+BlockContext *new_block_context(AstNode *node, BlockContext *parent);
+LocalVariableTableEntry *find_local_variable(BlockContext *context, Buf *name);
+
 #endif // JANE_ANALYZE
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "list.hpp"
 #include <assert.h>
 #include <ctype.h>
+#include <stdarg.h>
 #include <stdint.h>
 
 #define BUF_INIT                                                               \
@@ -15,6 +16,9 @@
 struct Buf {
   JaneList<char> list;
 };
+template <> struct MemCategoryOf<Buf> {
+  static const MemCategory value = MemCategoryBuf;
+};
 
 /**
  * @brief format string and return dynamically allocated buffer
@@ -23,6 +27,15 @@ struct Buf {
  */
 Buf *buf_sprintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
 
+/**
+ * @brief buf_sprintf taking a va_list, for other formatting functions
+ * @param format formatted string
+ * @param ap format arguments
+ * @return dynamically allocated buffer with the formatted string
+ */
+Buf *buf_vprintf(const char *format, va_list ap)
+    __attribute__((format(printf, 1, 0)));
+
 /**
  * @brief return the length of the buffer
  * @param buf the buffer
@@ -185,6 +198,13 @@ static inline void buf_append_char(Buf *buf, uint8_t c) {
   buf_append_mem(buf, (const char *)&c, 1);
 }
 
+/**
+ * @brief appends `str` as a quoted json string
+ * @param buf the buffer
+ * @param str the string to escape
+ */
+void buf_append_json_string(Buf *buf, const char *str);
+
 /**
  * @brief format a string and appends it to the end of the buffer
  * @param buf the buffer
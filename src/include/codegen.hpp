@@ -1,6 +1,7 @@
 #ifndef JANE_CODEGEN
 #define JANE_CODEGEN
 
+#include "errmsg.hpp"
 #include "parser.hpp"
 
 struct CodeGen;
@@ -11,14 +12,6 @@ enum OutType {
   OutTypeLib,
   OutTypeObj,
 };
-struct ErrorMsg {
-  int line_start;
-  int column_start;
-  int line_end;
-  int column_end;
-  Buf *msg;
-};
-
 CodeGen *codegen_create(Buf *root_source_dir);
 
 enum CodeGenBuildType {
@@ -28,12 +21,50 @@ enum CodeGenBuildType {
 
 void codegen_set_build_type(CodeGen *codegen, CodeGenBuildType build_type);
 void codegen_set_is_static(CodeGen *codegen, bool is_static);
-void codegen_set_strip(CodeGen *codegen, bool strip);
+
+enum CodeGenDebugInfo {
+  CodeGenDebugInfoFull,
+  // locations only, enough to symbolize profiles and backtraces
+  CodeGenDebugInfoLineTablesOnly,
+  CodeGenDebugInfoNone,
+};
+
+void codegen_set_debug_info(CodeGen *codegen, CodeGenDebugInfo debug_info);
+// move the debug info out of the object into a `.dwo` file next to it
+void codegen_set_split_dwarf(CodeGen *codegen, bool split_dwarf);
 void codegen_set_verbose(CodeGen *codegen, bool verbose);
 void codegen_set_out_type(CodeGen *codegen, OutType out_type);
 void codegen_set_out_name(CodeGen *codegen, Buf *out_name);
+void codegen_set_target_triple(CodeGen *codegen, Buf *triple);
+void codegen_set_max_errors(CodeGen *codegen, int max_errors);
+void codegen_set_diag_format(CodeGen *codegen, DiagFormat format);
+// a makefile rule making the output depend on every source file read
+void codegen_set_dep_file(CodeGen *codegen, Buf *dep_file_path);
+// imports are loaded from and saved to precompiled `.jni` files in this
+// directory
+void codegen_set_interface_dir(CodeGen *codegen, Buf *interface_dir);
+void codegen_set_function_sections(CodeGen *codegen, bool function_sections);
+void codegen_set_data_sections(CodeGen *codegen, bool data_sections);
+// let the linker drop sections nothing refers to
+void codegen_set_gc_sections(CodeGen *codegen, bool gc_sections);
+// a list of symbols, one per line, such as the hot functions from a profile.
+// they are emitted first and in that order; other functions keep theirs.
+void codegen_set_symbol_order_file(CodeGen *codegen, Buf *path);
+
+// shared by the roots of a batch build, which must all use the same target
+// and build options: the target machine is created once and a file imported
+// by several roots is parsed once
+struct CodeGenCache;
+CodeGenCache *codegen_cache_create(void);
+void codegen_set_cache(CodeGen *codegen, CodeGenCache *cache);
 
 void codegen_add_root_code(CodeGen *g, Buf *source_path, Buf *source_code);
+// the two halves of codegen_add_root_code. parsing prints the errors and
+// returns false instead of exiting; a batch build parses every root before
+// generating any of them.
+bool codegen_parse_root(CodeGen *g, Buf *source_path, Buf *source_code);
+void codegen_gen_root(CodeGen *g);
 void codegen_link(CodeGen *g, const char *out_file);
+void codegen_print_stats(CodeGen *g);
 
 #endif // JANE_CODEGEN
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef JANE_ERRMSG
+#define JANE_ERRMSG
+
+#include "buffer.hpp"
+#include "list.hpp"
+
+// the phase that found the error
+enum ErrorCode {
+  ErrorCodeLexical,
+  ErrorCodeSyntax,
+  ErrorCodeSemantic,
+  ErrorCodeComptime,
+};
+
+enum DiagFormat {
+  DiagFormatText,
+  // one json object per line
+  DiagFormatJson,
+};
+
+struct ErrorMsg {
+  ErrorCode code;
+  // as given to `use`, relative to the root source directory
+  Buf *path;
+  // zero based; the end is exclusive
+  int line_start;
+  int column_start;
+  int line_end;
+  int column_end;
+  Buf *msg;
+};
+
+// the errors of one build. the tokenizer, parser and semantic analysis all
+// report here and keep going, so one run shows every error it can find.
+struct ErrorList {
+  JaneList<ErrorMsg> msgs;
+  // 0 for no limit. once it is reached further errors are dropped and every
+  // phase stops at its next recovery point.
+  int max_errors;
+  bool limit_reached;
+  DiagFormat format;
+};
+
+void err_list_add(ErrorList *errors, ErrorCode code, Buf *path,
+                  int line_start, int column_start, int line_end,
+                  int column_end, Buf *msg);
+
+static inline bool err_list_full(ErrorList *errors) {
+  return errors->limit_reached;
+}
+
+const char *err_code_str(ErrorCode code);
+
+// writes every error to stderr with a single write
+void err_list_print(ErrorList *errors);
+
+#endif // JANE_ERRMSG
\ No newline at end of file
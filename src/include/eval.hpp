@@ -0,0 +1,17 @@
+#ifndef JANE_EVAL
+#define JANE_EVAL
+
+#include "semantic_info.hpp"
+
+// whether values of the type can be computed at compile time and baked into
+// the binary: integers, floats, bools, and arrays and structs of those
+bool type_has_const_value(TypeTableEntry *type);
+
+// evaluates an analyzed expression by walking its ast. reports an error at
+// the offending node and returns null when that is not possible.
+ConstExprValue *eval_const_expr(CodeGen *g, AstNode *node);
+
+// evaluates the initializer of a global constant once and caches the result
+ConstExprValue *eval_global_const(CodeGen *g, GlobalConstEntry *global_const);
+
+#endif // JANE_EVAL
\ No newline at end of file
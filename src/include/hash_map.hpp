@@ -17,7 +17,7 @@ public:
   };
 
   void init(int capacity) { init_capacity(capacity); }
-  void deinit(void) { free(_entries); }
+  void deinit(void) { deallocate(_entries, _capacity, MemCategoryHashMap); }
   void clear() {
     for (int i = 0; i < _capacity; i += 1) {
       _entries[i].used = false;
@@ -41,7 +41,7 @@ public:
           internal_put(old_entry->key, old_entry->value);
         }
       }
-      free(old_entries);
+      deallocate(old_entries, old_capacity, MemCategoryHashMap);
     }
   }
 
@@ -127,7 +127,7 @@ private:
 
   void init_capacity(int capacity) {
     _capacity = capacity;
-    _entries = allocate<Entry>(_capacity);
+    _entries = allocate<Entry>(_capacity, MemCategoryHashMap);
     _size = 0;
     _max_distance_from_start_index = 0;
     for (int i = 0; i < _capacity; i += 1) {
@@ -0,0 +1,20 @@
+#ifndef JANE_INTERFACE
+#define JANE_INTERFACE
+
+#include "os.hpp"
+#include "parser.hpp"
+
+// `.jni` files hold the parsed tree of an imported file so later builds can
+// skip tokenizing and parsing it. the tree is rebuilt straight from the
+// mapped file; strings are stored once and referenced by index.
+
+// null if the file is missing, corrupt, written by another version of the
+// compiler or older than `source_stamp`
+AstNode *interface_read(Buf *interface_path, OsFileStamp *source_stamp,
+                        ImportTableEntry *owner);
+// only for trees that parsed without errors. returns -1 if the file could
+// not be written.
+int interface_write(Buf *interface_path, OsFileStamp *source_stamp,
+                    AstNode *root);
+
+#endif // JANE_INTERFACE
\ No newline at end of file
@@ -23,16 +23,41 @@ struct LLVMJaneDIFile;
 struct LLVMJaneDILexicalBlock;
 struct LLVMJaneDISubprogram;
 struct LLVMJaneDISubroutineType;
+struct LLVMJaneDILocalVariable;
+struct LLVMJaneTBAANode;
 
 void LLVMJaneInitializeLoopStrengthReducePass(LLVMPassRegistryRef R);
 void LLVMJaneInitializeLowerIntrinsicsPass(LLVMPassRegistryRef R);
 void LLVMJaneInitializeUnreachableBlockElimPass(LLVMPassRegistryRef R);
 
+bool LLVMJaneInitializeTarget(const char *triple, char **error_message);
+
 char *LLVMJaneGetHostCPUName(void);
 char *LLVMJaneGetNativeFeatures(void);
+// one section per function or global, so the linker can drop or reorder them
+void LLVMJaneSetFunctionSections(LLVMTargetMachineRef targ_machine_ref,
+                                 bool enable);
+void LLVMJaneSetDataSections(LLVMTargetMachineRef targ_machine_ref,
+                             bool enable);
 
 void LLVMJaneOptimizeModule(LLVMTargetMachineRef targ_machine_ref,
                             LLVMModuleRef module_ref);
+// `dwo_filename` is null unless debug info is split out of the object
+bool LLVMJaneTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref,
+                                     LLVMModuleRef module_ref,
+                                     const char *filename,
+                                     const char *dwo_filename,
+                                     char **error_message);
+
+void LLVMJaneAddFunctionAttr(LLVMValueRef fn_ref, const char *attr_name);
+// functions are emitted in module order
+void LLVMJaneMoveFunctionToFront(LLVMValueRef fn_ref);
+// param_index is 0 based
+void LLVMJaneAddDereferenceableOrNullAttr(LLVMValueRef fn_ref,
+                                          unsigned param_index,
+                                          uint64_t bytes);
+void LLVMJaneAddParamAttr(LLVMValueRef fn_ref, unsigned param_index,
+                          const char *attr_name);
 
 LLVMValueRef LLVMJaneBuildCall(LLVMBuilderRef B, LLVMValueRef Fn,
                                LLVMValueRef *Args, unsigned NumArgs,
@@ -56,6 +81,40 @@ LLVMJaneDIType *LLVMJaneCreateDebugBasicType(LLVMJaneDIBuilder *dibuilder,
                                              uint64_t align_in_bits,
                                              unsigned encoding);
 
+LLVMJaneDIType *LLVMJaneCreateDebugVectorType(LLVMJaneDIBuilder *dibuilder,
+                                              uint64_t size_in_bits,
+                                              uint64_t align_in_bits,
+                                              LLVMJaneDIType *elem_type,
+                                              int elem_count);
+
+LLVMJaneDIType *LLVMJaneCreateReplaceableCompositeType(
+    LLVMJaneDIBuilder *dibuilder, unsigned tag, const char *name,
+    LLVMJaneDIScope *scope, LLVMJaneDIFile *file, unsigned line);
+
+LLVMJaneDIType *LLVMJaneCreateDebugMemberType(
+    LLVMJaneDIBuilder *dibuilder, LLVMJaneDIScope *scope, const char *name,
+    LLVMJaneDIFile *file, unsigned line, uint64_t size_in_bits,
+    uint64_t align_in_bits, uint64_t offset_in_bits, unsigned flags,
+    LLVMJaneDIType *type);
+
+LLVMJaneDIType *LLVMJaneCreateDebugStructType(
+    LLVMJaneDIBuilder *dibuilder, LLVMJaneDIScope *scope, const char *name,
+    LLVMJaneDIFile *file, unsigned line, uint64_t size_in_bits,
+    uint64_t align_in_bits, unsigned flags, LLVMJaneDIType **types_array,
+    int types_array_len);
+
+void LLVMJaneReplaceTemporary(LLVMJaneDIBuilder *dibuilder,
+                              LLVMJaneDIType *type,
+                              LLVMJaneDIType *replacement);
+
+LLVMJaneDIScope *LLVMJaneTypeToScope(LLVMJaneDIType *type);
+
+LLVMJaneDIType *LLVMJaneCreateDebugArrayType(LLVMJaneDIBuilder *dibuilder,
+                                             uint64_t size_in_bits,
+                                             uint64_t align_in_bits,
+                                             LLVMJaneDIType *elem_type,
+                                             int elem_count);
+
 LLVMJaneDISubroutineType *
 LLVMJaneCreateSubroutineType(LLVMJaneDIBuilder *dibuilder_wrapped,
                              LLVMJaneDIFile *file, LLVMJaneDIType **types_array,
@@ -63,7 +122,13 @@ LLVMJaneCreateSubroutineType(LLVMJaneDIBuilder *dibuilder_wrapped,
 
 unsigned LLVMJaneEncoding_DW_ATE_unsigned(void);
 unsigned LLVMJaneEncoding_DW_ATE_signed(void);
+unsigned LLVMJaneEncoding_DW_ATE_boolean(void);
+unsigned LLVMJaneEncoding_DW_ATE_float(void);
 unsigned LLVMJaneLang_DW_LANG_C99(void);
+unsigned LLVMJaneTag_DW_structure_type(void);
+unsigned LLVMJaneEmissionKind_NoDebug(void);
+unsigned LLVMJaneEmissionKind_LineTablesOnly(void);
+unsigned LLVMJaneEmissionKind_FullDebug(void);
 
 LLVMJaneDIBuilder *LLVMJaneCreateDIBuilder(LLVMModuleRef module,
                                            bool allow_unresolved);
@@ -87,7 +152,7 @@ LLVMJaneDICompileUnit *LLVMJaneCreateCompileUnit(
     LLVMJaneDIBuilder *dibuilder, unsigned lang, const char *file,
     const char *dir, const char *producer, bool is_optimized, const char *flags,
     unsigned runtime_version, const char *split_name, uint64_t dwo_id,
-    bool emit_debug_info);
+    unsigned emission_kind, bool emit_debug_info);
 
 LLVMJaneDIFile *LLVMJaneCreateFile(LLVMJaneDIBuilder *dibuilder,
                                    const char *filename, const char *directory);
@@ -100,8 +165,40 @@ LLVMJaneCreateFunction(LLVMJaneDIBuilder *dibuilder, LLVMJaneDIScope *scope,
                        bool is_definition, unsigned scope_line, unsigned flags,
                        bool is_optimized, LLVMValueRef function);
 
+LLVMJaneDILocalVariable *
+LLVMJaneCreateAutoVariable(LLVMJaneDIBuilder *dbuilder, LLVMJaneDIScope *scope,
+                           const char *name, LLVMJaneDIFile *file,
+                           unsigned line_no, LLVMJaneDIType *type,
+                           bool always_preserve, unsigned flags);
+
+void LLVMJaneInsertDeclareAtEnd(LLVMJaneDIBuilder *dibuilder,
+                                LLVMValueRef storage,
+                                LLVMJaneDILocalVariable *var_info,
+                                unsigned line, unsigned col,
+                                LLVMJaneDIScope *scope,
+                                LLVMBasicBlockRef insert_at_end);
+
 void LLVMJaneDIBuilderFinalize(LLVMJaneDIBuilder *dibuilder);
 
+// lets a floating point reduction be evaluated in any order
+void LLVMJaneSetAllowReassoc(LLVMValueRef instruction);
+
+// attaches !range [low, high) to an integer load
+void LLVMJaneSetRangeMetadata(LLVMValueRef load, uint64_t low, uint64_t high);
+
+// marks a call `musttail`; it must be followed directly by a ret
+void LLVMJaneSetMustTail(LLVMValueRef call);
+
+// attaches !prof branch_weights to a conditional branch
+void LLVMJaneSetBranchWeights(LLVMValueRef branch, uint32_t true_weight,
+                              uint32_t false_weight);
+
+LLVMJaneTBAANode *LLVMJaneCreateTBAARoot(const char *name);
+LLVMJaneTBAANode *LLVMJaneCreateTBAAScalarType(LLVMJaneTBAANode *parent,
+                                               const char *name);
+// attaches !tbaa to a load or store of a value of type `scalar_type`
+void LLVMJaneSetTBAA(LLVMValueRef instruction, LLVMJaneTBAANode *scalar_type);
+
 Buf *get_dynamic_linker(LLVMTargetMachineRef target_machine);
 
 #endif // JANE_LLVM
\ No newline at end of file
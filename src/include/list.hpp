@@ -14,7 +14,7 @@ template <typename T> struct JaneList {
   int capacity; // capacity of the list (alocated size of the items array)
 
   // destructor to deinitialize list and deallocate memory
-  void deinit() { free(items); }
+  void deinit() { deallocate(items, capacity, mem_category()); }
 
   /**
    * @brief append an item to the end of the list
@@ -53,10 +53,14 @@ template <typename T> struct JaneList {
     return items[--length];
   }
   /**
-   * @brief add one item to the list and return it
+   * @brief add one zero initialized item to the list and return it
    * @return the added item
    */
-  void add_one() { return resize(length + 1); }
+  T &add_one() {
+    resize(length + 1);
+    memset(&items[length - 1], 0, sizeof(T));
+    return items[length - 1];
+  }
 
   const T &last() const {
     assert(length >= 1);
@@ -81,6 +85,31 @@ template <typename T> struct JaneList {
   }
   // clear the list
   void clear() { length = 0; }
+  /**
+   * @brief grow the capacity to exactly the specified number of items, for
+   *          lists whose final length is known up front
+   * @param new_capacity the desired capacity of the list
+   */
+  void reserve(int new_capacity) {
+    if (new_capacity > capacity) {
+      items = reallocate_nonzero(items, capacity, new_capacity,
+                                 mem_category());
+      capacity = new_capacity;
+    }
+  }
+  // give back the capacity beyond the length, once the list is complete
+  void shrink_to_fit() {
+    if (capacity == length) {
+      return;
+    }
+    if (length == 0) {
+      deallocate(items, capacity, mem_category());
+      items = nullptr;
+    } else {
+      items = reallocate_nonzero(items, capacity, length, mem_category());
+    }
+    capacity = length;
+  }
   /**
    * @brief ensure that the list has the capacity to hold at least the
    specified
@@ -88,13 +117,79 @@ template <typename T> struct JaneList {
    * @param new_capacity the deisred capacity of the list
    */
   void ensure_capacity(int new_capacity) {
-    int better_capacity = max(capacity, 16);
+    if (new_capacity <= capacity) {
+      // a reserved capacity is kept, however small
+      return;
+    }
+    int better_capacity = capacity == 0 ? initial_capacity() : capacity;
     while (better_capacity < new_capacity)
       better_capacity = better_capacity * 2;
-    if (better_capacity != capacity) {
-      items = reallocate_nonzero(items, better_capacity);
-      capacity = better_capacity;
+    items = reallocate_nonzero(items, capacity, better_capacity,
+                               mem_category());
+    capacity = better_capacity;
+  }
+  // the first allocation is about 64 bytes, at least 4 and at most 16 items
+  static int initial_capacity() {
+    return clamp<int>(4, (int)(64 / sizeof(T)), 16);
+  }
+  // items of a type with no category of its own count as list memory
+  static MemCategory mem_category() {
+    return MemCategoryOf<T>::value == MemCategoryOther
+               ? MemCategoryList
+               : MemCategoryOf<T>::value;
+  }
+};
+
+/**
+ * @brief list that keeps its first N items inline, as scratch space for
+ *          building short lists; move_to hands the result to a JaneList
+ * @tparam T type of items stored in the list
+ * @tparam N number of items stored without allocating
+ */
+template <typename T, int N> struct JaneSmallList {
+  T inline_items[N];
+  // holds every item once there are more than N
+  JaneList<T> heap;
+  int length;
+
+  void append(T item) {
+    if (length < N) {
+      inline_items[length++] = item;
+      return;
+    }
+    if (length == N) {
+      heap.reserve(N * 2);
+      for (int i = 0; i < N; i += 1) {
+        heap.append(inline_items[i]);
+      }
+    }
+    heap.append(item);
+    length += 1;
+  }
+  T &at(int index) {
+    assert(index >= 0);
+    assert(index < length);
+    return length <= N ? inline_items[index] : heap.at(index);
+  }
+  /**
+   * @brief move the items to an empty list with an allocation of exactly
+   *          their size, leaving this list empty
+   * @param dest the list that receives the items
+   */
+  void move_to(JaneList<T> *dest) {
+    assert(dest->length == 0);
+    if (length > N) {
+      dest->deinit();
+      *dest = heap;
+      dest->shrink_to_fit();
+      heap = {};
+    } else {
+      dest->reserve(length);
+      for (int i = 0; i < length; i += 1) {
+        dest->append(inline_items[i]);
+      }
     }
+    length = 0;
   }
 };
 
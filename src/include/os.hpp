@@ -4,8 +4,15 @@
 #include "buffer.hpp"
 #include "list.hpp"
 
+#include <stdint.h>
 #include <stdio.h>
 
+// enough to tell whether a file changed since it was last read
+struct OsFileStamp {
+  int64_t mtime_ns;
+  int64_t size;
+};
+
 void os_spawn_process(const char *exe, JaneList<const char *> &args,
                       bool detached);
 void os_path_split(Buf *full_path, Buf *out_dirname, Buf *out_basename);
@@ -16,5 +23,22 @@ void os_write_file(Buf *full_path, Buf *contents);
 int os_fetch_file(FILE *file_buf, Buf *out_contents);
 int os_fetch_file_path(Buf *full_path, Buf *out_contents);
 int os_get_cwd(Buf *out_cwd);
+double os_get_time(void);
+// these return -1 and leave errno set on failure instead of panicking; the
+// callers treat the files involved as caches
+int os_file_stamp(Buf *full_path, OsFileStamp *out_stamp);
+// read only; null if the file cannot be mapped
+const void *os_map_file(Buf *full_path, size_t *out_size);
+void os_unmap_file(const void *ptr, size_t size);
+// writes a temporary file and renames it over `full_path`, so readers never
+// see it half written
+int os_replace_file(Buf *full_path, Buf *contents);
+int os_cpu_count(void);
+// peak resident set size of the process in bytes
+int64_t os_max_rss(void);
+// runs `worker(context, i)` for every i below `count` in a forked process,
+// at most `max_jobs` at a time. returns how many workers failed.
+int os_run_workers(int count, int max_jobs,
+                   void (*worker)(void *context, int index), void *context);
 
 #endif // JANE_OS
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 struct AstNode;
 struct CodeGenNode;
+struct ImportTableEntry;
 
 enum NodeType {
   NodeTypeRoot,
@@ -29,6 +30,18 @@ enum NodeType {
   NodeTypePrefixOpExpr,
   NodeTypeFnCallExpr,
   NodeTypeUse,
+  NodeTypeVariableDeclaration,
+  NodeTypeBoolLiteral,
+  NodeTypeIfExpr,
+  NodeTypeWhileExpr,
+  NodeTypeForExpr,
+  NodeTypeBreak,
+  NodeTypeContinue,
+  NodeTypeStructDecl,
+  NodeTypeStructField,
+  NodeTypeFieldAccessExpr,
+  NodeTypeArrayAccessExpr,
+  NodeTypeAsmExpr,
 };
 
 struct AstNodeRoot {
@@ -45,6 +58,8 @@ struct AstNodeFnProto {
   JaneList<AstNode *> *directives;
   FnProtoVisibMod visib_mod;
   Buf name;
+  // `fn name<T, U>(...)`; symbols naming the type parameters
+  JaneList<AstNode *> generic_params;
   JaneList<AstNode *> params;
   AstNode *return_type;
 };
@@ -61,18 +76,26 @@ struct AstNodeFnDecl {
 struct AstNodeParamDecl {
   Buf name;
   AstNode *type;
+  // no other pointer reachable in the function aliases this one
+  bool is_noalias;
 };
 
 enum AstNodeTypeType {
   AstNodeTypeTypePrimitive,
   AstNodeTypeTypePointer,
+  AstNodeTypeTypeVector,
+  AstNodeTypeTypeArray,
+  AstNodeTypeTypeSlice,
 };
 
 struct AstNodeType {
   AstNodeTypeType type;
   Buf primitive_name;
   AstNode *child_type;
+  // pointers and slices
   bool is_const;
+  // element count of `vector(N, T)` and `[N]T`
+  AstNode *len;
 };
 struct AstNodeBlock {
   JaneList<AstNode *> statements;
@@ -80,10 +103,13 @@ struct AstNodeBlock {
 
 struct AstNodeReturnExpr {
   AstNode *expression;
+  // `return tail f(...)`, which must compile to a tail call
+  bool is_tail;
 };
 
 enum BinOpType {
   BinOpTypeInvalid,
+  BinOpTypeAssign,
   BinOpTypeBoolOr,
   BinOpTypeBoolAnd,
   BinOpTypeCmpEq,
@@ -104,6 +130,15 @@ enum BinOpType {
   BinOpTypeMod,
 };
 
+struct AstNodeVariableDeclaration {
+  Buf symbol;
+  bool is_const;
+  // null if the type is inferred from the initializer
+  AstNode *type;
+  // null for a zero initialized `mut` with an explicit type
+  AstNode *expr;
+};
+
 struct AstNodeBinOpExpr {
   AstNode *op1;
   BinOpType bin_op;
@@ -113,6 +148,8 @@ struct AstNodeBinOpExpr {
 struct AstNodeFnCallExpr {
   AstNode *fn_ref_expr;
   JaneList<AstNode *> params;
+  // `@name(...)`; fn_ref_expr is the symbol without the `@`
+  bool is_builtin;
 };
 
 struct AstNodeExternBlock {
@@ -141,6 +178,8 @@ enum PrefixOp {
   PrefixOpBoolNot,
   PrefixOpBinNot,
   PrefixOpNegation,
+  PrefixOpAddressOf,
+  PrefixOpDereference,
 };
 
 struct AstNodePrefixOpExpr {
@@ -148,6 +187,61 @@ struct AstNodePrefixOpExpr {
   AstNode *primary_expr;
 };
 
+struct AstNodeIfExpr {
+  AstNode *condition;
+  AstNode *then_block;
+  // null, a block, or another if expression for `else if`
+  AstNode *else_node;
+  JaneList<AstNode *> *directives;
+};
+
+struct AstNodeWhileExpr {
+  AstNode *condition;
+  AstNode *body;
+  JaneList<AstNode *> *directives;
+};
+
+struct AstNodeForExpr {
+  // init, condition and step are each optional
+  AstNode *init;
+  AstNode *condition;
+  AstNode *step;
+  AstNode *body;
+  JaneList<AstNode *> *directives;
+};
+
+struct AstNodeStructDecl {
+  Buf name;
+  JaneList<AstNode *> fields;
+  JaneList<AstNode *> *directives;
+};
+
+struct AstNodeStructField {
+  Buf name;
+  AstNode *type;
+};
+
+struct AstNodeFieldAccessExpr {
+  AstNode *struct_expr;
+  Buf field_name;
+};
+
+struct AstNodeArrayAccessExpr {
+  AstNode *array_ref_expr;
+  AstNode *subscript;
+};
+
+struct AstNodeAsmExpr {
+  bool is_volatile;
+  Buf asm_template;
+  // llvm constraint string: at most one `=` output, then one input per
+  // operand, then `~` clobbers
+  Buf constraints;
+  JaneList<AstNode *> operands;
+  // void when there is no output
+  AstNode *return_type;
+};
+
 struct AstNodeUse {
   Buf path;
   JaneList<AstNode *> *directive;
@@ -158,6 +252,11 @@ struct AstNode {
   AstNode *parent;
   int line;
   int column;
+  // exclusive end of the last token of the node and its children
+  int line_end;
+  int column_end;
+  // the file the node was parsed from
+  ImportTableEntry *owner;
   CodeGenNode *codegen_node;
   union {
     AstNodeRoot root;
@@ -176,16 +275,35 @@ struct AstNode {
     AstNodePrefixOpExpr prefix_op_expr;
     AstNodeFnCallExpr fn_call_expr;
     AstNodeUse use;
+    AstNodeVariableDeclaration variable_declaration;
+    AstNodeIfExpr if_expr;
+    AstNodeWhileExpr while_expr;
+    AstNodeForExpr for_expr;
+    AstNodeStructDecl struct_decl;
+    AstNodeStructField struct_field;
+    AstNodeFieldAccessExpr field_access_expr;
+    AstNodeArrayAccessExpr array_access_expr;
+    AstNodeAsmExpr asm_expr;
+    bool bool_literal;
     Buf number;
     Buf string;
     Buf symbol;
   } data;
 };
+template <> struct MemCategoryOf<AstNode> {
+  static const MemCategory value = MemCategoryAst;
+};
 __attribute__((format(printf, 2, 3))) void
 ast_token_error(Token *token, const char *format, ...);
 
-AstNode *ast_parse(Buf *buf, JaneList<Token> *tokens);
+// syntax errors are reported to `errors` against `path`. the declarations and
+// statements they occur in are left out of the tree.
+AstNode *ast_parse(Buf *buf, JaneList<Token> *tokens, ImportTableEntry *owner,
+                   Buf *path, ErrorList *errors);
 const char *node_type_str(NodeType node_type);
+const char *bin_op_str(BinOpType bin_op);
 void ast_print(AstNode *node, int indent);
+// deep copy of a function definition without any analysis attached
+AstNode *ast_clone_subtree(AstNode *node);
 
 #endif // JANE_PARSER
\ No newline at end of file
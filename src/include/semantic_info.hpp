@@ -7,9 +7,41 @@
 #include "parser.hpp"
 
 struct FnTableEntry;
+
+enum TypeTableEntryId {
+  TypeTableEntryIdInvalid,
+  TypeTableEntryIdVoid,
+  TypeTableEntryIdBool,
+  TypeTableEntryIdUnreachable,
+  TypeTableEntryIdInt,
+  TypeTableEntryIdFloat,
+  TypeTableEntryIdPointer,
+  TypeTableEntryIdVector,
+  TypeTableEntryIdStruct,
+  TypeTableEntryIdArray,
+  // {ptr, len}; the two fields are described by struct_fields
+  TypeTableEntryIdSlice,
+};
+
+struct TypeTableEntry;
+struct ImportTableEntry;
+
+struct TypeStructField {
+  Buf *name;
+  TypeTableEntry *type_entry;
+  // position in the llvm struct; differs from the declaration order with
+  // `#reorder`
+  int gen_index;
+  AstNode *decl_node;
+};
+
 struct TypeTableEntry {
+  TypeTableEntryId id;
   LLVMTypeRef type_ref;
   LLVMJaneDIType *di_type;
+  uint64_t size_in_bits;
+  // only meaningful for TypeTableEntryIdInt
+  bool is_signed;
 
   TypeTableEntry *pointer_child;
   bool pointer_is_const;
@@ -17,15 +49,40 @@ struct TypeTableEntry {
   Buf name;
   TypeTableEntry *pointer_const_parent;
   TypeTableEntry *pointer_mut_parent;
+  TypeTableEntry *vector_child;
+  int vector_len;
+  TypeTableEntry *array_child;
+  uint64_t array_len;
+
+  AstNode *struct_decl_node;
+  ImportTableEntry *struct_import;
+  // in declaration order
+  TypeStructField *struct_fields;
+  int struct_field_count;
+  bool struct_is_packed;
+  bool struct_complete;
+  bool struct_is_invalid;
+  // set while the fields are resolved, to catch a struct containing itself
+  bool struct_embedded_in_current;
+  bool struct_used_in_c_header;
+  // from `#align(N)`; 0 means the llvm abi alignment
+  uint64_t align_in_bits;
 };
 
 struct ImportTableEntry {
   AstNode *root;
+  int import_index;
   Buf *path;
   LLVMJaneDIFile *di_file;
   HashMap<Buf *, FnTableEntry *, buf_hash, buf_eql_buf> fn_table;
 };
 
+enum FnInline {
+  FnInlineAuto,
+  FnInlineAlways,
+  FnInlineNever,
+};
+
 struct FnTableEntry {
   LLVMValueRef fn_value;
   AstNode *proto_node;
@@ -34,22 +91,168 @@ struct FnTableEntry {
   bool internal_linkage;
   unsigned calling_convention;
   ImportTableEntry *import_entry;
+  // position in CodeGen::fn_protos, stable across runs
+  int fn_index;
+  // set from `#inline`, `#noinline`, `#hot`, `#cold`, `#optsize`, `#align(N)`
+  FnInline fn_inline;
+  bool is_hot;
+  bool is_cold;
+  bool is_optsize;
+  unsigned alignment;
+  // bodies are analyzed on demand when a constant needs to call them early
+  bool body_analyzed;
+  bool body_analyzing;
+  // generic functions are never generated themselves, only their instances
+  bool is_generic;
+  // for an instance, the type bound to each of the generic parameters
+  TypeTableEntry **generic_args;
+  // how many instances deep the call that requested this instance was
+  int instance_depth;
+};
+
+// identifies one instance of a generic function
+struct GenericFnKey {
+  FnTableEntry *fn_entry;
+  TypeTableEntry **type_args;
+  int type_arg_count;
+};
+
+uint32_t generic_fn_key_hash(GenericFnKey *key);
+bool generic_fn_key_eql(GenericFnKey *a, GenericFnKey *b);
+
+struct LocalVariableTableEntry {
+  Buf name;
+  TypeTableEntry *type;
+  bool is_const;
+  // stack slot for locals, the incoming llvm argument for parameters
+  LLVMValueRef value_ref;
+  AstNode *decl_node;
+  // -1 for locals
+  int arg_index;
+};
+
+// a value computed at compile time
+struct ConstExprValue {
+  TypeTableEntry *type;
+  // two's complement, sign extended to 64 bits for signed types
+  uint64_t x_int;
+  double x_float;
+  bool x_bool;
+  // array elements, or struct fields in declaration order
+  ConstExprValue *elements;
+};
+
+// `const NAME: T = expr;` at the top level
+struct GlobalConstEntry {
+  Buf *name;
+  AstNode *decl_node;
+  ImportTableEntry *import;
+  // null until the declaration is resolved
+  TypeTableEntry *type;
+  bool resolving;
+  // null until evaluated
+  ConstExprValue *value;
+  bool evaluating;
+  bool eval_failed;
+  // constant llvm global for aggregates, created the first time code takes
+  // the address of the value
+  LLVMValueRef global_ref;
+};
+
+struct BlockContext {
+  AstNode *node;
+  BlockContext *root;
+  BlockContext *parent;
+  // the function being analyzed, set on the root context only. null for the
+  // initializers of global constants.
+  FnTableEntry *fn_entry;
+  HashMap<Buf *, LocalVariableTableEntry *, buf_hash, buf_eql_buf>
+      variable_table;
+};
+
+enum BuiltinFnId {
+  BuiltinFnIdSplat,
+  BuiltinFnIdShuffle,
+  BuiltinFnIdVectorLoad,
+  BuiltinFnIdVectorStore,
+  BuiltinFnIdReduceAdd,
+  BuiltinFnIdReduceMul,
+  BuiltinFnIdReduceMin,
+  BuiltinFnIdReduceMax,
+  BuiltinFnIdReduceAnd,
+  BuiltinFnIdReduceOr,
+  BuiltinFnIdReduceXor,
+  BuiltinFnIdSlice,
+  BuiltinFnIdComptime,
+  BuiltinFnIdIntrinsic,
+  BuiltinFnIdAtomicLoad,
+  BuiltinFnIdAtomicStore,
+  BuiltinFnIdAtomicRmw,
+  BuiltinFnIdCmpxchg,
+  BuiltinFnIdFence,
+};
+
+struct BuiltinFnEntry {
+  BuiltinFnId id;
+  Buf name;
+  // -1 for variadic
+  int param_count;
+};
+
+struct CodeGenCache {
+  // null until the first root is initialized
+  LLVMTargetMachineRef target_machine;
+  bool is_native_target;
+  // by full path; only files that parsed without errors
+  HashMap<Buf *, AstNode *, buf_hash, buf_eql_buf> parsed_files;
+};
+
+struct TimeEvent {
+  double time;
+  const char *name;
 };
 
 struct CodeGen {
   LLVMModuleRef module;
-  JaneList<ErrorMsg> errors;
+  ErrorList errors;
   LLVMBuilderRef builder;
   LLVMJaneDIBuilder *dbuilder;
   LLVMJaneDICompileUnit *compile_unit;
   HashMap<Buf *, FnTableEntry *, buf_hash, buf_eql_buf> fn_table;
+  // string literal text to a pointer into the pool; filled by codegen
   HashMap<Buf *, LLVMValueRef, buf_hash, buf_eql_buf> str_table;
+  // distinct string literal texts in the order analysis found them
+  JaneList<Buf *> string_literals;
   HashMap<Buf *, TypeTableEntry *, buf_hash, buf_eql_buf> type_table;
   HashMap<Buf *, bool, buf_hash, buf_eql_buf> link_table;
   HashMap<Buf *, ImportTableEntry *, buf_hash, buf_eql_buf> import_table;
+  HashMap<Buf *, BuiltinFnEntry *, buf_hash, buf_eql_buf> builtin_fn_table;
+  HashMap<Buf *, GlobalConstEntry *, buf_hash, buf_eql_buf> global_const_table;
+  // in declaration order
+  JaneList<GlobalConstEntry *> global_consts;
+  // `@comptime(expr)` calls, evaluated once analysis is done
+  JaneList<AstNode *> comptime_calls;
+  HashMap<GenericFnKey *, FnTableEntry *, generic_fn_key_hash,
+          generic_fn_key_eql>
+      generic_instance_table;
+  // scalar type nodes for type based alias analysis, by name
+  HashMap<Buf *, LLVMJaneTBAANode *, buf_hash, buf_eql_buf> tbaa_table;
+  // parent of every tbaa type; byte accesses use it so they alias anything
+  LLVMJaneTBAANode *tbaa_byte_node;
   struct {
+    TypeTableEntry *entry_bool;
     TypeTableEntry *entry_u8;
+    TypeTableEntry *entry_u16;
+    TypeTableEntry *entry_u32;
+    TypeTableEntry *entry_u64;
+    TypeTableEntry *entry_i8;
+    TypeTableEntry *entry_i16;
     TypeTableEntry *entry_i32;
+    TypeTableEntry *entry_i64;
+    TypeTableEntry *entry_isize;
+    TypeTableEntry *entry_usize;
+    TypeTableEntry *entry_f32;
+    TypeTableEntry *entry_f64;
     TypeTableEntry *entry_void;
     TypeTableEntry *entry_unreachable;
     TypeTableEntry *entry_invalid;
@@ -58,22 +261,48 @@ struct CodeGen {
   LLVMTargetDataRef target_data_ref;
   unsigned pointer_size_bytes;
   bool is_static;
-  bool strip_debug_symbols;
+  CodeGenDebugInfo debug_info;
+  bool split_dwarf;
   CodeGenBuildType build_type;
   LLVMTargetMachineRef target_machine;
   bool is_native_target;
+  Buf *target_triple;
   Buf *root_source_dir;
   Buf *root_out_name;
   JaneList<LLVMJaneDIScope *> block_scopes;
+  // targets of `break` and `continue` for the innermost loop being generated
+  JaneList<LLVMBasicBlockRef> break_block_stack;
+  JaneList<LLVMBasicBlockRef> continue_block_stack;
   JaneList<FnTableEntry *> fn_defs;
+  // source-ordered views of fn_table, import_table and link_table. code
+  // generation iterates these instead of the hash tables so that emitted
+  // modules do not depend on hash layout.
+  JaneList<FnTableEntry *> fn_protos;
+  // in declaration order
+  JaneList<TypeTableEntry *> struct_types;
+  JaneList<ImportTableEntry *> import_list;
+  JaneList<Buf *> link_libs;
   OutType out_type;
   FnTableEntry *cur_fn;
   bool c_stdint_used;
+  bool c_stdbool_used;
   AstNode *root_export_decl;
   int version_major;
   int version_minor;
   int version_patch;
   bool verbose;
+  JaneList<TimeEvent> timing_events;
+  // null outside batch builds
+  CodeGenCache *cache;
+  // from `-MF`
+  Buf *dep_file_path;
+  // from `--interface-dir`
+  Buf *interface_dir;
+  bool function_sections;
+  bool data_sections;
+  bool gc_sections;
+  // from `--symbol-ordering-file`
+  Buf *symbol_order_file;
 };
 
 struct TypeNode {
@@ -84,18 +313,96 @@ struct FnDefNode {
   bool add_implicit_return;
   bool skip;
   LLVMValueRef *params;
+  // parameters followed by every local declared in the body, in declaration
+  // order. locals get an alloca in the entry block so mem2reg can promote them.
+  JaneList<LocalVariableTableEntry *> variable_list;
+};
+
+struct VarDeclNode {
+  LocalVariableTableEntry *variable;
+};
+
+enum BranchHint {
+  BranchHintNone,
+  BranchHintLikely,
+  BranchHintUnlikely,
+};
+
+// if, while and for
+struct BranchNode {
+  // from `#likely` / `#unlikely`, applies to the condition being true
+  BranchHint hint;
+  bool contains_break;
+};
+
+struct FnCallNode {
+  // the callee; an instance for calls to generic functions
+  FnTableEntry *fn_entry;
+  BuiltinFnEntry *builtin_fn;
+  // the llvm id of the `@intrinsic(...)` callee
+  unsigned intrinsic_id;
+  // for the atomic builtins; cmpxchg also has a failure ordering
+  LLVMAtomicOrdering atomic_order;
+  LLVMAtomicOrdering atomic_failure_order;
+  LLVMAtomicRMWBinOp atomic_rmw_op;
+  // the result of `@comptime(expr)`
+  ConstExprValue *const_val;
+  LLVMValueRef const_global_ref;
+};
+
+struct SymbolNode {
+  // null for locals and parameters
+  GlobalConstEntry *global_const;
+};
+
+struct FieldAccessNode {
+  // null for the `len` of an array, which is a constant
+  TypeStructField *field;
+};
+
+struct ExprNode {
+  TypeTableEntry *type_entry;
+  BlockContext *block_context;
 };
 
 struct CodeGenNode {
   union {
     TypeNode type_node;
     FnDefNode fn_def_node;
+    VarDeclNode var_decl_node;
+    BranchNode branch_node;
+    FnCallNode fn_call_node;
+    FieldAccessNode field_access_node;
+    SymbolNode symbol_node;
   } data;
+  ExprNode expr_node;
 };
 
+// the element type for vectors, the type itself otherwise. operators act on
+// vectors element-wise, so instruction selection looks at this type.
+static inline TypeTableEntry *get_scalar_type(TypeTableEntry *type) {
+  return type->id == TypeTableEntryIdVector ? type->vector_child : type;
+}
+
 static inline Buf *hack_get_fn_call_name(CodeGen *g, AstNode *node) {
   assert(node->type == NodeTypeSymbol);
   return &node->data.symbol;
 }
 
+template <> struct MemCategoryOf<TypeTableEntry> {
+  static const MemCategory value = MemCategorySemantic;
+};
+template <> struct MemCategoryOf<FnTableEntry> {
+  static const MemCategory value = MemCategorySemantic;
+};
+template <> struct MemCategoryOf<LocalVariableTableEntry> {
+  static const MemCategory value = MemCategorySemantic;
+};
+template <> struct MemCategoryOf<BlockContext> {
+  static const MemCategory value = MemCategorySemantic;
+};
+template <> struct MemCategoryOf<CodeGenNode> {
+  static const MemCategory value = MemCategorySemantic;
+};
+
 #endif // JANE_SEMANTIC_INFO
\ No newline at end of file
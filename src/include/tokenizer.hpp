@@ -2,6 +2,7 @@
 #define JANE_TOKENIZER
 
 #include "buffer.hpp"
+#include "errmsg.hpp"
 
 enum TokenId {
   TokenIdEof,
@@ -16,6 +17,18 @@ enum TokenId {
   TokenIdKeywordExport,
   TokenIdKeywordAs,
   TokenIdKeywordUse,
+  TokenIdKeywordIf,
+  TokenIdKeywordElse,
+  TokenIdKeywordWhile,
+  TokenIdKeywordFor,
+  TokenIdKeywordBreak,
+  TokenIdKeywordContinue,
+  TokenIdKeywordTrue,
+  TokenIdKeywordFalse,
+  TokenIdKeywordStruct,
+  TokenIdKeywordNoAlias,
+  TokenIdKeywordAsm,
+  TokenIdKeywordVolatile,
   TokenIdLParen,
   TokenIdRParen,
   TokenIdComma,
@@ -48,6 +61,10 @@ enum TokenId {
   TokenIdBitShiftRight,
   TokenIdSlash,
   TokenIdPercent,
+  TokenIdAtSign,
+  TokenIdDot,
+  TokenIdLBracket,
+  TokenIdRBracket,
 };
 
 struct Token {
@@ -56,9 +73,17 @@ struct Token {
   int end_position;
   int start_line;
   int start_column;
+  // exclusive; string literals can span lines
+  int end_line;
+  int end_column;
+};
+template <> struct MemCategoryOf<Token> {
+  static const MemCategory value = MemCategoryToken;
 };
 
-JaneList<Token> *tokenize(Buf *buf);
+// errors are reported to `errors` against `path`; the tokens are usable
+// regardless
+JaneList<Token> *tokenize(Buf *buf, Buf *path, ErrorList *errors);
 void print_tokens(Buf *buf, JaneList<Token> *tokens);
 
 #endif // JANE_TOKENIZER
\ No newline at end of file
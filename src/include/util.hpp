@@ -22,6 +22,51 @@ jane_unreachable(void) {
   jane_panic("unreahable");
 }
 
+// what an allocation is for. built with JANE_ENABLE_MEM_PROFILE, the live and
+// peak bytes of each category are tracked and printed by `--stats`;
+// otherwise the category is never looked at.
+enum MemCategory {
+  MemCategoryOther,
+  MemCategoryToken,
+  MemCategoryAst,
+  // char arrays, which back every Buf
+  MemCategoryBuf,
+  // JaneList items with no category of their own
+  MemCategoryList,
+  MemCategoryHashMap,
+  // types, functions, variables and scopes of the analysis
+  MemCategorySemantic,
+  MemCategoryCount,
+};
+
+/**
+ * @brief category of allocations of T, specialized next to the types that
+ *          have one
+ * @tparam T the type of the elements
+ */
+template <typename T> struct MemCategoryOf {
+  static const MemCategory value = MemCategoryOther;
+};
+template <> struct MemCategoryOf<char> {
+  static const MemCategory value = MemCategoryBuf;
+};
+
+const char *mem_category_name(MemCategory category);
+
+#ifdef JANE_ENABLE_MEM_PROFILE
+struct MemCategoryStats {
+  size_t live_bytes;
+  size_t peak_bytes;
+  size_t live_count;
+  size_t total_count;
+};
+
+extern MemCategoryStats mem_category_stats[MemCategoryCount];
+
+void mem_profile_alloc(MemCategory category, size_t bytes);
+void mem_profile_free(MemCategory category, size_t bytes);
+#endif
+
 /**
  * @brief allocate block memory for an array of element of type T without zero
  *          initialization
@@ -30,11 +75,16 @@ jane_unreachable(void) {
  * @return pointer to the allcoated memory block
  */
 template <typename T>
-__attribute__((malloc)) static inline T *allocate_nonzero(size_t count) {
+__attribute__((malloc)) static inline T *
+allocate_nonzero(size_t count,
+                 MemCategory category = MemCategoryOf<T>::value) {
   T *ptr = reinterpret_cast<T *>(malloc(count * sizeof(T)));
   if (!ptr) {
     jane_panic("allocation failed");
   }
+#ifdef JANE_ENABLE_MEM_PROFILE
+  mem_profile_alloc(category, count * sizeof(T));
+#endif
   return ptr;
 }
 
@@ -46,11 +96,15 @@ __attribute__((malloc)) static inline T *allocate_nonzero(size_t count) {
  * @return pointer to allocated memory block
  */
 template <typename T>
-__attribute__((malloc)) static inline T *allocate(size_t count) {
+__attribute__((malloc)) static inline T *
+allocate(size_t count, MemCategory category = MemCategoryOf<T>::value) {
   T *ptr = reinterpret_cast<T *>(std::calloc(count, sizeof(T)));
   if (!ptr) {
     jane_panic("allocation failed");
   }
+#ifdef JANE_ENABLE_MEM_PROFILE
+  mem_profile_alloc(category, count * sizeof(T));
+#endif
   return ptr;
 }
 
@@ -58,19 +112,45 @@ __attribute__((malloc)) static inline T *allocate(size_t count) {
  * @brief reallocate block of memory for an arary of element of type T without
  *          zero initialization
  * @tparam T type of the elements
- * @param old pointer to the previously allocated memory block
+ * @param old pointer to the previously allocated memory block, or null
+ * @param old_count number of elements in the previous block
  * @param new_count new number of element to allocate
  * @return pointer to the reallocated memory block
  */
 template <typename T>
-static inline T *reallocate_nonzero(T *old, size_t new_count) {
+static inline T *
+reallocate_nonzero(T *old, size_t old_count, size_t new_count,
+                   MemCategory category = MemCategoryOf<T>::value) {
   T *ptr = reinterpret_cast<T *>(std::realloc(old, new_count * sizeof(T)));
   if (!ptr) {
     jane_panic("allocation failed");
   }
+#ifdef JANE_ENABLE_MEM_PROFILE
+  if (old) {
+    mem_profile_free(category, old_count * sizeof(T));
+  }
+  mem_profile_alloc(category, new_count * sizeof(T));
+#endif
   return ptr;
 }
 
+/**
+ * @brief free a block of memory from one of the functions above
+ * @tparam T type of the elements
+ * @param ptr pointer to the memory block, or null
+ * @param count number of elements in the block
+ */
+template <typename T>
+static inline void deallocate(T *ptr, size_t count,
+                              MemCategory category = MemCategoryOf<T>::value) {
+#ifdef JANE_ENABLE_MEM_PROFILE
+  if (ptr) {
+    mem_profile_free(category, count * sizeof(T));
+  }
+#endif
+  free(ptr);
+}
+
 /**
  * @brief allocate and format a string using sprintf syntax
  * @param len pointer to integer that will store the length of the allocated
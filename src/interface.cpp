@@ -0,0 +1,551 @@
+#include "include/interface.hpp"
+#include "../config.h"
+#include "include/hash_map.hpp"
+#include "include/util.hpp"
+
+#include <stdint.h>
+
+// the file is a header, then `string_count` InterfaceStrings, then
+// `word_count` words encoding the tree in preorder, then the bytes of the
+// strings. everything is 4 byte aligned so the words can be read in place.
+static const uint32_t interface_magic = 0x31494e4a; // "JNI1"
+// bump whenever AstNode or the encoding below changes
+static const uint32_t interface_format_version = 1;
+// a null node, list or string
+static const uint32_t interface_none = 0xffffffff;
+
+struct InterfaceHeader {
+  uint32_t magic;
+  uint32_t format_version;
+  int64_t source_mtime_ns;
+  int64_t source_size;
+  uint32_t string_count;
+  uint32_t word_count;
+  uint32_t blob_size;
+  uint32_t padding;
+};
+
+struct InterfaceString {
+  uint32_t offset;
+  uint32_t len;
+};
+
+struct InterfaceWriter {
+  JaneList<uint32_t> words;
+  // string 0 is the compiler version
+  JaneList<Buf *> strings;
+  HashMap<Buf *, uint32_t, buf_hash, buf_eql_buf> string_table;
+};
+
+static void write_word(InterfaceWriter *w, uint32_t word) {
+  w->words.append(word);
+}
+
+static void write_buf(InterfaceWriter *w, Buf *buf) {
+  // some node kinds leave buffers uninitialized
+  if (!buf->list.length) {
+    write_word(w, interface_none);
+    return;
+  }
+  auto entry = w->string_table.maybe_get(buf);
+  if (entry) {
+    write_word(w, entry->value);
+    return;
+  }
+  uint32_t index = w->strings.length;
+  w->strings.append(buf);
+  w->string_table.put(buf, index);
+  write_word(w, index);
+}
+
+static void write_node(InterfaceWriter *w, AstNode *node);
+
+static void write_list(InterfaceWriter *w, JaneList<AstNode *> *list) {
+  write_word(w, list->length);
+  for (int i = 0; i < list->length; i += 1) {
+    write_node(w, list->at(i));
+  }
+}
+
+static void write_list_ptr(InterfaceWriter *w, JaneList<AstNode *> *list) {
+  if (list) {
+    write_list(w, list);
+  } else {
+    write_word(w, interface_none);
+  }
+}
+
+static void write_node(InterfaceWriter *w, AstNode *node) {
+  if (!node) {
+    write_word(w, interface_none);
+    return;
+  }
+  write_word(w, node->type);
+  write_word(w, node->line);
+  write_word(w, node->column);
+  write_word(w, node->line_end);
+  write_word(w, node->column_end);
+  switch (node->type) {
+  case NodeTypeRoot:
+    write_list(w, &node->data.root.top_level_decls);
+    break;
+  case NodeTypeRootExportDecl:
+    write_buf(w, &node->data.root_export_decl.type);
+    write_buf(w, &node->data.root_export_decl.name);
+    write_list_ptr(w, node->data.root_export_decl.directives);
+    break;
+  case NodeTypeFnProto:
+    write_list_ptr(w, node->data.fn_proto.directives);
+    write_word(w, node->data.fn_proto.visib_mod);
+    write_buf(w, &node->data.fn_proto.name);
+    write_list(w, &node->data.fn_proto.generic_params);
+    write_list(w, &node->data.fn_proto.params);
+    write_node(w, node->data.fn_proto.return_type);
+    break;
+  case NodeTypeFnDef:
+    write_node(w, node->data.fn_def.fn_proto);
+    write_node(w, node->data.fn_def.body);
+    break;
+  case NodeTypeFnDecl:
+    write_node(w, node->data.fn_decl.fn_proto);
+    break;
+  case NodeTypeParamDecl:
+    write_buf(w, &node->data.param_decl.name);
+    write_node(w, node->data.param_decl.type);
+    write_word(w, node->data.param_decl.is_noalias);
+    break;
+  case NodeTypeType:
+    write_word(w, node->data.type.type);
+    write_buf(w, &node->data.type.primitive_name);
+    write_node(w, node->data.type.child_type);
+    write_word(w, node->data.type.is_const);
+    write_node(w, node->data.type.len);
+    break;
+  case NodeTypeBlock:
+    write_list(w, &node->data.block.statements);
+    break;
+  case NodeTypeExternBlock:
+    write_list_ptr(w, node->data.extern_block.directives);
+    write_list(w, &node->data.extern_block.fn_decls);
+    break;
+  case NodeTypeDirective:
+    write_buf(w, &node->data.directive.name);
+    write_buf(w, &node->data.directive.param);
+    break;
+  case NodeTypeReturnExpr:
+    write_node(w, node->data.return_expr.expression);
+    write_word(w, node->data.return_expr.is_tail);
+    break;
+  case NodeTypeBinOpExpr:
+    write_node(w, node->data.bin_op_expr.op1);
+    write_word(w, node->data.bin_op_expr.bin_op);
+    write_node(w, node->data.bin_op_expr.op2);
+    break;
+  case NodeTypeCastExpr:
+    write_node(w, node->data.cast_expr.prefix_op_expr);
+    write_node(w, node->data.cast_expr.type);
+    break;
+  case NodeTypeNumberLiteral:
+    write_buf(w, &node->data.number);
+    break;
+  case NodeTypeStringLiteral:
+    write_buf(w, &node->data.string);
+    break;
+  case NodeTypeSymbol:
+    write_buf(w, &node->data.symbol);
+    break;
+  case NodeTypePrefixOpExpr:
+    write_word(w, node->data.prefix_op_expr.prefix_op);
+    write_node(w, node->data.prefix_op_expr.primary_expr);
+    break;
+  case NodeTypeFnCallExpr:
+    write_node(w, node->data.fn_call_expr.fn_ref_expr);
+    write_list(w, &node->data.fn_call_expr.params);
+    write_word(w, node->data.fn_call_expr.is_builtin);
+    break;
+  case NodeTypeUse:
+    write_buf(w, &node->data.use.path);
+    write_list_ptr(w, node->data.use.directive);
+    break;
+  case NodeTypeVariableDeclaration:
+    write_buf(w, &node->data.variable_declaration.symbol);
+    write_word(w, node->data.variable_declaration.is_const);
+    write_node(w, node->data.variable_declaration.type);
+    write_node(w, node->data.variable_declaration.expr);
+    break;
+  case NodeTypeBoolLiteral:
+    write_word(w, node->data.bool_literal);
+    break;
+  case NodeTypeIfExpr:
+    write_node(w, node->data.if_expr.condition);
+    write_node(w, node->data.if_expr.then_block);
+    write_node(w, node->data.if_expr.else_node);
+    write_list_ptr(w, node->data.if_expr.directives);
+    break;
+  case NodeTypeWhileExpr:
+    write_node(w, node->data.while_expr.condition);
+    write_node(w, node->data.while_expr.body);
+    write_list_ptr(w, node->data.while_expr.directives);
+    break;
+  case NodeTypeForExpr:
+    write_node(w, node->data.for_expr.init);
+    write_node(w, node->data.for_expr.condition);
+    write_node(w, node->data.for_expr.step);
+    write_node(w, node->data.for_expr.body);
+    write_list_ptr(w, node->data.for_expr.directives);
+    break;
+  case NodeTypeStructDecl:
+    write_buf(w, &node->data.struct_decl.name);
+    write_list(w, &node->data.struct_decl.fields);
+    write_list_ptr(w, node->data.struct_decl.directives);
+    break;
+  case NodeTypeStructField:
+    write_buf(w, &node->data.struct_field.name);
+    write_node(w, node->data.struct_field.type);
+    break;
+  case NodeTypeFieldAccessExpr:
+    write_node(w, node->data.field_access_expr.struct_expr);
+    write_buf(w, &node->data.field_access_expr.field_name);
+    break;
+  case NodeTypeArrayAccessExpr:
+    write_node(w, node->data.array_access_expr.array_ref_expr);
+    write_node(w, node->data.array_access_expr.subscript);
+    break;
+  case NodeTypeAsmExpr:
+    write_word(w, node->data.asm_expr.is_volatile);
+    write_buf(w, &node->data.asm_expr.asm_template);
+    write_buf(w, &node->data.asm_expr.constraints);
+    write_list(w, &node->data.asm_expr.operands);
+    write_node(w, node->data.asm_expr.return_type);
+    break;
+  case NodeTypeUnreachable:
+  case NodeTypeBreak:
+  case NodeTypeContinue:
+    break;
+  }
+}
+
+int interface_write(Buf *interface_path, OsFileStamp *source_stamp,
+                    AstNode *root) {
+  InterfaceWriter w = {0};
+  w.string_table.init(64);
+  w.strings.append(buf_create_from_str(JANE_VERSION_STRING));
+  write_node(&w, root);
+
+  InterfaceHeader header = {0};
+  header.magic = interface_magic;
+  header.format_version = interface_format_version;
+  header.source_mtime_ns = source_stamp->mtime_ns;
+  header.source_size = source_stamp->size;
+  header.string_count = w.strings.length;
+  header.word_count = w.words.length;
+
+  Buf contents = BUF_INIT;
+  buf_resize(&contents, 0);
+  buf_append_mem(&contents, (const char *)&header, sizeof(InterfaceHeader));
+  uint32_t offset = 0;
+  for (int i = 0; i < w.strings.length; i += 1) {
+    InterfaceString str = {offset, (uint32_t)buf_len(w.strings.at(i))};
+    buf_append_mem(&contents, (const char *)&str, sizeof(InterfaceString));
+    offset += str.len;
+  }
+  buf_append_mem(&contents, (const char *)w.words.items,
+                 header.word_count * sizeof(uint32_t));
+  for (int i = 0; i < w.strings.length; i += 1) {
+    buf_append_buf(&contents, w.strings.at(i));
+  }
+  // the header is written before the blob size is known
+  InterfaceHeader *written_header = (InterfaceHeader *)buf_ptr(&contents);
+  written_header->blob_size = offset;
+
+  int result = os_replace_file(interface_path, &contents);
+  contents.list.deinit();
+  w.words.deinit();
+  w.strings.deinit();
+  w.string_table.deinit();
+  return result;
+}
+
+struct InterfaceReader {
+  const uint32_t *words;
+  uint32_t word_count;
+  uint32_t pos;
+  const InterfaceString *strings;
+  uint32_t string_count;
+  const char *blob;
+  uint32_t blob_size;
+  ImportTableEntry *owner;
+  // once set, reads return zeroes and no more nodes are created
+  bool failed;
+};
+
+static uint32_t read_word(InterfaceReader *r) {
+  if (r->pos >= r->word_count) {
+    r->failed = true;
+    return 0;
+  }
+  uint32_t word = r->words[r->pos];
+  r->pos += 1;
+  return word;
+}
+
+static uint32_t read_enum(InterfaceReader *r, uint32_t max_value) {
+  uint32_t value = read_word(r);
+  if (value > max_value) {
+    r->failed = true;
+    return 0;
+  }
+  return value;
+}
+
+static const InterfaceString *get_string(InterfaceReader *r, uint32_t index) {
+  if (index >= r->string_count) {
+    r->failed = true;
+    return nullptr;
+  }
+  const InterfaceString *str = &r->strings[index];
+  if (str->offset > r->blob_size || str->len > r->blob_size - str->offset) {
+    r->failed = true;
+    return nullptr;
+  }
+  return str;
+}
+
+static void read_buf(InterfaceReader *r, Buf *buf) {
+  uint32_t index = read_word(r);
+  if (index == interface_none) {
+    return;
+  }
+  const InterfaceString *str = get_string(r, index);
+  if (str) {
+    buf_init_from_mem(buf, r->blob + str->offset, str->len);
+  }
+}
+
+static AstNode *read_node(InterfaceReader *r);
+
+static void read_list(InterfaceReader *r, JaneList<AstNode *> *list) {
+  uint32_t count = read_word(r);
+  // every node takes several words, which bounds the count of a sane file
+  if (count > r->word_count - r->pos) {
+    r->failed = true;
+    return;
+  }
+  list->reserve((int)count);
+  for (uint32_t i = 0; i < count && !r->failed; i += 1) {
+    list->append(read_node(r));
+  }
+}
+
+static JaneList<AstNode *> *read_list_ptr(InterfaceReader *r) {
+  if (r->pos < r->word_count && r->words[r->pos] == interface_none) {
+    r->pos += 1;
+    return nullptr;
+  }
+  JaneList<AstNode *> *list = allocate<JaneList<AstNode *>>(1);
+  read_list(r, list);
+  return list;
+}
+
+static AstNode *read_node(InterfaceReader *r) {
+  uint32_t type = read_word(r);
+  if (type == interface_none || r->failed) {
+    return nullptr;
+  }
+  if (type > NodeTypeAsmExpr) {
+    r->failed = true;
+    return nullptr;
+  }
+  AstNode *node = allocate<AstNode>(1);
+  node->type = (NodeType)type;
+  node->line = read_word(r);
+  node->column = read_word(r);
+  node->line_end = read_word(r);
+  node->column_end = read_word(r);
+  node->owner = r->owner;
+  switch (node->type) {
+  case NodeTypeRoot:
+    read_list(r, &node->data.root.top_level_decls);
+    break;
+  case NodeTypeRootExportDecl:
+    read_buf(r, &node->data.root_export_decl.type);
+    read_buf(r, &node->data.root_export_decl.name);
+    node->data.root_export_decl.directives = read_list_ptr(r);
+    break;
+  case NodeTypeFnProto:
+    node->data.fn_proto.directives = read_list_ptr(r);
+    node->data.fn_proto.visib_mod =
+        (FnProtoVisibMod)read_enum(r, FnProtoVisibModExport);
+    read_buf(r, &node->data.fn_proto.name);
+    read_list(r, &node->data.fn_proto.generic_params);
+    read_list(r, &node->data.fn_proto.params);
+    node->data.fn_proto.return_type = read_node(r);
+    break;
+  case NodeTypeFnDef:
+    node->data.fn_def.fn_proto = read_node(r);
+    node->data.fn_def.body = read_node(r);
+    break;
+  case NodeTypeFnDecl:
+    node->data.fn_decl.fn_proto = read_node(r);
+    break;
+  case NodeTypeParamDecl:
+    read_buf(r, &node->data.param_decl.name);
+    node->data.param_decl.type = read_node(r);
+    node->data.param_decl.is_noalias = read_word(r);
+    break;
+  case NodeTypeType:
+    node->data.type.type = (AstNodeTypeType)read_enum(r, AstNodeTypeTypeSlice);
+    read_buf(r, &node->data.type.primitive_name);
+    node->data.type.child_type = read_node(r);
+    node->data.type.is_const = read_word(r);
+    node->data.type.len = read_node(r);
+    break;
+  case NodeTypeBlock:
+    read_list(r, &node->data.block.statements);
+    break;
+  case NodeTypeExternBlock:
+    node->data.extern_block.directives = read_list_ptr(r);
+    read_list(r, &node->data.extern_block.fn_decls);
+    break;
+  case NodeTypeDirective:
+    read_buf(r, &node->data.directive.name);
+    read_buf(r, &node->data.directive.param);
+    break;
+  case NodeTypeReturnExpr:
+    node->data.return_expr.expression = read_node(r);
+    node->data.return_expr.is_tail = read_word(r);
+    break;
+  case NodeTypeBinOpExpr:
+    node->data.bin_op_expr.op1 = read_node(r);
+    node->data.bin_op_expr.bin_op = (BinOpType)read_enum(r, BinOpTypeMod);
+    node->data.bin_op_expr.op2 = read_node(r);
+    break;
+  case NodeTypeCastExpr:
+    node->data.cast_expr.prefix_op_expr = read_node(r);
+    node->data.cast_expr.type = read_node(r);
+    break;
+  case NodeTypeNumberLiteral:
+    read_buf(r, &node->data.number);
+    break;
+  case NodeTypeStringLiteral:
+    read_buf(r, &node->data.string);
+    break;
+  case NodeTypeSymbol:
+    read_buf(r, &node->data.symbol);
+    break;
+  case NodeTypePrefixOpExpr:
+    node->data.prefix_op_expr.prefix_op =
+        (PrefixOp)read_enum(r, PrefixOpDereference);
+    node->data.prefix_op_expr.primary_expr = read_node(r);
+    break;
+  case NodeTypeFnCallExpr:
+    node->data.fn_call_expr.fn_ref_expr = read_node(r);
+    read_list(r, &node->data.fn_call_expr.params);
+    node->data.fn_call_expr.is_builtin = read_word(r);
+    break;
+  case NodeTypeUse:
+    read_buf(r, &node->data.use.path);
+    node->data.use.directive = read_list_ptr(r);
+    break;
+  case NodeTypeVariableDeclaration:
+    read_buf(r, &node->data.variable_declaration.symbol);
+    node->data.variable_declaration.is_const = read_word(r);
+    node->data.variable_declaration.type = read_node(r);
+    node->data.variable_declaration.expr = read_node(r);
+    break;
+  case NodeTypeBoolLiteral:
+    node->data.bool_literal = read_word(r);
+    break;
+  case NodeTypeIfExpr:
+    node->data.if_expr.condition = read_node(r);
+    node->data.if_expr.then_block = read_node(r);
+    node->data.if_expr.else_node = read_node(r);
+    node->data.if_expr.directives = read_list_ptr(r);
+    break;
+  case NodeTypeWhileExpr:
+    node->data.while_expr.condition = read_node(r);
+    node->data.while_expr.body = read_node(r);
+    node->data.while_expr.directives = read_list_ptr(r);
+    break;
+  case NodeTypeForExpr:
+    node->data.for_expr.init = read_node(r);
+    node->data.for_expr.condition = read_node(r);
+    node->data.for_expr.step = read_node(r);
+    node->data.for_expr.body = read_node(r);
+    node->data.for_expr.directives = read_list_ptr(r);
+    break;
+  case NodeTypeStructDecl:
+    read_buf(r, &node->data.struct_decl.name);
+    read_list(r, &node->data.struct_decl.fields);
+    node->data.struct_decl.directives = read_list_ptr(r);
+    break;
+  case NodeTypeStructField:
+    read_buf(r, &node->data.struct_field.name);
+    node->data.struct_field.type = read_node(r);
+    break;
+  case NodeTypeFieldAccessExpr:
+    node->data.field_access_expr.struct_expr = read_node(r);
+    read_buf(r, &node->data.field_access_expr.field_name);
+    break;
+  case NodeTypeArrayAccessExpr:
+    node->data.array_access_expr.array_ref_expr = read_node(r);
+    node->data.array_access_expr.subscript = read_node(r);
+    break;
+  case NodeTypeAsmExpr:
+    node->data.asm_expr.is_volatile = read_word(r);
+    read_buf(r, &node->data.asm_expr.asm_template);
+    read_buf(r, &node->data.asm_expr.constraints);
+    read_list(r, &node->data.asm_expr.operands);
+    node->data.asm_expr.return_type = read_node(r);
+    break;
+  case NodeTypeUnreachable:
+  case NodeTypeBreak:
+  case NodeTypeContinue:
+    break;
+  }
+  return node;
+}
+
+static bool is_current_version(InterfaceReader *r) {
+  const InterfaceString *str = get_string(r, 0);
+  const char *version = JANE_VERSION_STRING;
+  return str && str->len == strlen(version) &&
+         memcmp(r->blob + str->offset, version, str->len) == 0;
+}
+
+AstNode *interface_read(Buf *interface_path, OsFileStamp *source_stamp,
+                        ImportTableEntry *owner) {
+  size_t size;
+  const void *mapped = os_map_file(interface_path, &size);
+  if (!mapped) {
+    return nullptr;
+  }
+  const InterfaceHeader *header = (const InterfaceHeader *)mapped;
+  AstNode *root = nullptr;
+  if (size >= sizeof(InterfaceHeader) && header->magic == interface_magic &&
+      header->format_version == interface_format_version &&
+      header->source_mtime_ns == source_stamp->mtime_ns &&
+      header->source_size == source_stamp->size &&
+      size == sizeof(InterfaceHeader) +
+                  (uint64_t)header->string_count * sizeof(InterfaceString) +
+                  (uint64_t)header->word_count * sizeof(uint32_t) +
+                  header->blob_size) {
+    InterfaceReader r = {0};
+    r.strings = (const InterfaceString *)(header + 1);
+    r.string_count = header->string_count;
+    r.words = (const uint32_t *)(r.strings + r.string_count);
+    r.word_count = header->word_count;
+    r.blob = (const char *)(r.words + r.word_count);
+    r.blob_size = header->blob_size;
+    r.owner = owner;
+    if (is_current_version(&r)) {
+      root = read_node(&r);
+      if (r.failed || r.pos != r.word_count || !root ||
+          root->type != NodeTypeRoot) {
+        root = nullptr;
+      }
+    }
+  }
+  os_unmap_file(mapped, size);
+  return root;
+}
\ No newline at end of file
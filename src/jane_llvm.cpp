@@ -9,11 +9,13 @@
 #include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Metadata.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/InitializePasses.h>
+#include <llvm/MC/TargetRegistry.h>
 #include <llvm/MC/SubtargetFeature.h>
 #include <llvm/PassRegistry.h>
 #include <llvm/Support/FileSystem.h>
@@ -26,6 +28,8 @@
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 #include <llvm/Transforms/Scalar.h>
 
+#include <llvm/ADT/DenseMap.h>
+
 using namespace llvm;
 
 void LLVMJaneInitializeLoopStrengthReducePass(LLVMPassRegistryRef R) {
@@ -40,6 +44,102 @@ void LLVMJaneInitializeUnreachableBlockElimPass(LLVMPassRegistryRef R) {
   initializeUnreachableMachineBlockElimPass(*unwrap(R));
 }
 
+struct JaneTargetInitializer {
+  const char *name;
+  void (*init_target_info)(void);
+  void (*init_target)(void);
+  void (*init_target_mc)(void);
+};
+
+struct JaneTargetAsmInitializer {
+  const char *name;
+  void (*init)(void);
+};
+
+static const JaneTargetInitializer jane_target_initializers[] = {
+#define LLVM_TARGET(TargetName)                                                \
+  {#TargetName, LLVMInitialize##TargetName##TargetInfo,                        \
+   LLVMInitialize##TargetName##Target, LLVMInitialize##TargetName##TargetMC},
+#include <llvm/Config/Targets.def>
+};
+
+static const JaneTargetAsmInitializer jane_asm_printer_initializers[] = {
+#define LLVM_ASM_PRINTER(TargetName)                                           \
+  {#TargetName, LLVMInitialize##TargetName##AsmPrinter},
+#include <llvm/Config/AsmPrinters.def>
+};
+
+static const JaneTargetAsmInitializer jane_asm_parser_initializers[] = {
+#define LLVM_ASM_PARSER(TargetName)                                            \
+  {#TargetName, LLVMInitialize##TargetName##AsmParser},
+#include <llvm/Config/AsmParsers.def>
+};
+
+static void init_target_asm(const JaneTargetAsmInitializer *initializers,
+                            size_t initializers_len, const char *name) {
+  for (size_t i = 0; i < initializers_len; i += 1) {
+    if (strcmp(initializers[i].name, name) == 0) {
+      initializers[i].init();
+      return;
+    }
+  }
+}
+
+// registering the target info of every backend only records names and
+// triples, which is cheap. the expensive part (code generator, MC layer, asm
+// printer and parser) is only initialized for the backend that owns `triple`,
+// and only once per process.
+bool LLVMJaneInitializeTarget(const char *triple, char **error_message) {
+  static const size_t target_count = array_length(jane_target_initializers);
+  static DenseMap<const Target *, size_t> target_owner;
+  static bool target_infos_registered = false;
+  static bool target_initialized[target_count];
+
+  if (!target_infos_registered) {
+    for (size_t i = 0; i < target_count; i += 1) {
+      auto targets = TargetRegistry::targets();
+      const Target *prev_first =
+          targets.begin() == targets.end() ? nullptr : &*targets.begin();
+      jane_target_initializers[i].init_target_info();
+      // newly registered targets are prepended to the registry
+      for (const Target &target : TargetRegistry::targets()) {
+        if (&target == prev_first) {
+          break;
+        }
+        target_owner[&target] = i;
+      }
+    }
+    target_infos_registered = true;
+  }
+
+  std::string err;
+  const Target *target = TargetRegistry::lookupTarget(triple, err);
+  if (!target) {
+    *error_message = strdup(err.c_str());
+    return true;
+  }
+  auto owner = target_owner.find(target);
+  if (owner == target_owner.end()) {
+    *error_message = strdup("target is not owned by any configured backend");
+    return true;
+  }
+  size_t index = owner->second;
+  if (!target_initialized[index]) {
+    const JaneTargetInitializer *initializer =
+        &jane_target_initializers[index];
+    initializer->init_target();
+    initializer->init_target_mc();
+    init_target_asm(jane_asm_printer_initializers,
+                    array_length(jane_asm_printer_initializers),
+                    initializer->name);
+    init_target_asm(jane_asm_parser_initializers,
+                    array_length(jane_asm_parser_initializers),
+                    initializer->name);
+    target_initialized[index] = true;
+  }
+  return false;
+}
+
 char *LLVMJaneGetHostCPUName(void) {
   std::string str = LLVMGetHostCPUName();
   return strdup(str.c_str());
@@ -56,6 +156,20 @@ char *LLVMJaneGetNativeFeatures(void) {
   return strdup(features.getString().c_str());
 }
 
+void LLVMJaneSetFunctionSections(LLVMTargetMachineRef targ_machine_ref,
+                                 bool enable) {
+  TargetMachine *target_machine =
+      reinterpret_cast<TargetMachine *>(targ_machine_ref);
+  target_machine->Options.FunctionSections = enable;
+}
+
+void LLVMJaneSetDataSections(LLVMTargetMachineRef targ_machine_ref,
+                             bool enable) {
+  TargetMachine *target_machine =
+      reinterpret_cast<TargetMachine *>(targ_machine_ref);
+  target_machine->Options.DataSections = enable;
+}
+
 static void addAddDiscriminatorsPass(const PassManagerBuilder &builder,
                                      legacy::PassManagerBase &PM) {
   PM.add(createAddDiscriminatorsPass());
@@ -121,6 +235,75 @@ void LLVMJaneOptimizeModule(LLVMTargetMachineRef targ_machine_ref,
   MPM->run(*module);
 }
 
+// the c api cannot emit split dwarf. with `dwo_filename` set, the debug info
+// goes to that file and the object keeps a skeleton pointing at it.
+bool LLVMJaneTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref,
+                                     LLVMModuleRef module_ref,
+                                     const char *filename,
+                                     const char *dwo_filename,
+                                     char **error_message) {
+  TargetMachine *target_machine =
+      reinterpret_cast<TargetMachine *>(targ_machine_ref);
+  Module *module = unwrap(module_ref);
+  std::error_code ec;
+  raw_fd_ostream dest(filename, ec, sys::fs::OF_None);
+  if (ec) {
+    *error_message = strdup(ec.message().c_str());
+    return true;
+  }
+  std::unique_ptr<raw_fd_ostream> dwo_dest;
+  if (dwo_filename) {
+    dwo_dest.reset(new raw_fd_ostream(dwo_filename, ec, sys::fs::OF_None));
+    if (ec) {
+      *error_message = strdup(ec.message().c_str());
+      return true;
+    }
+  }
+  // the target machine is shared by the roots of a batch build
+  target_machine->Options.MCOptions.SplitDwarfFile =
+      dwo_filename ? dwo_filename : "";
+  legacy::PassManager pass_manager;
+  if (target_machine->addPassesToEmitFile(pass_manager, dest, dwo_dest.get(),
+                                          CGFT_ObjectFile)) {
+    *error_message = strdup("target machine cannot emit object files");
+    return true;
+  }
+  pass_manager.run(*module);
+  dest.flush();
+  if (dwo_dest) {
+    dwo_dest->flush();
+  }
+  return false;
+}
+
+void LLVMJaneAddFunctionAttr(LLVMValueRef fn_ref, const char *attr_name) {
+  Function *func = unwrap<Function>(fn_ref);
+  Attribute::AttrKind attr_kind = Attribute::getAttrKindFromName(attr_name);
+  assert(attr_kind != Attribute::None);
+  func->addFnAttr(attr_kind);
+}
+
+void LLVMJaneMoveFunctionToFront(LLVMValueRef fn_ref) {
+  Function *func = unwrap<Function>(fn_ref);
+  Module::FunctionListType &list = func->getParent()->getFunctionList();
+  list.splice(list.begin(), list, func->getIterator());
+}
+
+void LLVMJaneAddDereferenceableOrNullAttr(LLVMValueRef fn_ref,
+                                          unsigned param_index,
+                                          uint64_t bytes) {
+  Function *func = unwrap<Function>(fn_ref);
+  func->addDereferenceableOrNullParamAttr(param_index, bytes);
+}
+
+void LLVMJaneAddParamAttr(LLVMValueRef fn_ref, unsigned param_index,
+                          const char *attr_name) {
+  Function *func = unwrap<Function>(fn_ref);
+  Attribute::AttrKind attr_kind = Attribute::getAttrKindFromName(attr_name);
+  assert(attr_kind != Attribute::None);
+  func->addParamAttr(param_index, attr_kind);
+}
+
 LLVMValueRef LLVMJaneBuildCall(LLVMBuilderRef B, LLVMValueRef Fn,
                                LLVMValueRef *Args, unsigned NumArgs,
                                unsigned CC, const char *Name) {
@@ -151,6 +334,88 @@ LLVMJaneDIType *LLVMJaneCreateDebugBasicType(LLVMJaneDIBuilder *dibuilder,
   return reinterpret_cast<LLVMJaneDIType *>(di_type);
 }
 
+LLVMJaneDIType *LLVMJaneCreateDebugVectorType(LLVMJaneDIBuilder *dibuilder,
+                                              uint64_t size_in_bits,
+                                              uint64_t align_in_bits,
+                                              LLVMJaneDIType *elem_type,
+                                              int elem_count) {
+  DIBuilder *dbuilder = reinterpret_cast<DIBuilder *>(dibuilder);
+  SmallVector<Metadata *, 1> subscripts;
+  subscripts.push_back(dbuilder->getOrCreateSubrange(0, elem_count));
+  DIType *di_type = dbuilder->createVectorType(
+      size_in_bits, align_in_bits, reinterpret_cast<DIType *>(elem_type),
+      dbuilder->getOrCreateArray(subscripts));
+  return reinterpret_cast<LLVMJaneDIType *>(di_type);
+}
+
+LLVMJaneDIType *LLVMJaneCreateReplaceableCompositeType(
+    LLVMJaneDIBuilder *dibuilder, unsigned tag, const char *name,
+    LLVMJaneDIScope *scope, LLVMJaneDIFile *file, unsigned line) {
+  DIType *di_type =
+      reinterpret_cast<DIBuilder *>(dibuilder)->createReplaceableCompositeType(
+          tag, name, reinterpret_cast<DIScope *>(scope),
+          reinterpret_cast<DIFile *>(file), line);
+  return reinterpret_cast<LLVMJaneDIType *>(di_type);
+}
+
+LLVMJaneDIType *LLVMJaneCreateDebugMemberType(
+    LLVMJaneDIBuilder *dibuilder, LLVMJaneDIScope *scope, const char *name,
+    LLVMJaneDIFile *file, unsigned line, uint64_t size_in_bits,
+    uint64_t align_in_bits, uint64_t offset_in_bits, unsigned flags,
+    LLVMJaneDIType *type) {
+  DIType *di_type = reinterpret_cast<DIBuilder *>(dibuilder)->createMemberType(
+      reinterpret_cast<DIScope *>(scope), name,
+      reinterpret_cast<DIFile *>(file), line, size_in_bits, align_in_bits,
+      offset_in_bits, static_cast<DINode::DIFlags>(flags),
+      reinterpret_cast<DIType *>(type));
+  return reinterpret_cast<LLVMJaneDIType *>(di_type);
+}
+
+LLVMJaneDIType *LLVMJaneCreateDebugStructType(
+    LLVMJaneDIBuilder *dibuilder, LLVMJaneDIScope *scope, const char *name,
+    LLVMJaneDIFile *file, unsigned line, uint64_t size_in_bits,
+    uint64_t align_in_bits, unsigned flags, LLVMJaneDIType **types_array,
+    int types_array_len) {
+  DIBuilder *dbuilder = reinterpret_cast<DIBuilder *>(dibuilder);
+  SmallVector<Metadata *, 8> fields;
+  for (int i = 0; i < types_array_len; i += 1) {
+    fields.push_back(reinterpret_cast<DIType *>(types_array[i]));
+  }
+  DIType *di_type = dbuilder->createStructType(
+      reinterpret_cast<DIScope *>(scope), name,
+      reinterpret_cast<DIFile *>(file), line, size_in_bits, align_in_bits,
+      static_cast<DINode::DIFlags>(flags), nullptr,
+      dbuilder->getOrCreateArray(fields));
+  return reinterpret_cast<LLVMJaneDIType *>(di_type);
+}
+
+void LLVMJaneReplaceTemporary(LLVMJaneDIBuilder *dibuilder,
+                              LLVMJaneDIType *type,
+                              LLVMJaneDIType *replacement) {
+  reinterpret_cast<DIBuilder *>(dibuilder)->replaceTemporary(
+      TempDIType(reinterpret_cast<DIType *>(type)),
+      reinterpret_cast<DIType *>(replacement));
+}
+
+LLVMJaneDIScope *LLVMJaneTypeToScope(LLVMJaneDIType *type) {
+  DIScope *scope = reinterpret_cast<DIType *>(type);
+  return reinterpret_cast<LLVMJaneDIScope *>(scope);
+}
+
+LLVMJaneDIType *LLVMJaneCreateDebugArrayType(LLVMJaneDIBuilder *dibuilder,
+                                             uint64_t size_in_bits,
+                                             uint64_t align_in_bits,
+                                             LLVMJaneDIType *elem_type,
+                                             int elem_count) {
+  DIBuilder *dbuilder = reinterpret_cast<DIBuilder *>(dibuilder);
+  SmallVector<Metadata *, 1> subscripts;
+  subscripts.push_back(dbuilder->getOrCreateSubrange(0, elem_count));
+  DIType *di_type = dbuilder->createArrayType(
+      size_in_bits, align_in_bits, reinterpret_cast<DIType *>(elem_type),
+      dbuilder->getOrCreateArray(subscripts));
+  return reinterpret_cast<LLVMJaneDIType *>(di_type);
+}
+
 LLVMJaneDISubroutineType *
 LLVMJaneCreateSubroutineType(LLVMJaneDIBuilder *dibuilder_wrapped,
                              LLVMJaneDIFile *file, LLVMJaneDIType **types_array,
@@ -173,8 +438,28 @@ unsigned LLVMJaneEncoding_DW_ATE_unsigned(void) {
 
 unsigned LLVMJaneEncoding_DW_ATE_signed(void) { return dwarf::DW_ATE_signed; }
 
+unsigned LLVMJaneEncoding_DW_ATE_boolean(void) {
+  return dwarf::DW_ATE_boolean;
+}
+
+unsigned LLVMJaneEncoding_DW_ATE_float(void) { return dwarf::DW_ATE_float; }
+
 unsigned LLVMJaneLang_DW_LANG_C99(void) { return dwarf::DW_LANG_C99; }
 
+unsigned LLVMJaneTag_DW_structure_type(void) {
+  return dwarf::DW_TAG_structure_type;
+}
+
+unsigned LLVMJaneEmissionKind_NoDebug(void) { return DICompileUnit::NoDebug; }
+
+unsigned LLVMJaneEmissionKind_LineTablesOnly(void) {
+  return DICompileUnit::LineTablesOnly;
+}
+
+unsigned LLVMJaneEmissionKind_FullDebug(void) {
+  return DICompileUnit::FullDebug;
+}
+
 LLVMJaneDIBuilder *LLVMJaneCreateDIBuilder(LLVMModuleRef module,
                                            bool allow_unresolved) {
   DIBuilder *di_builder = new DIBuilder(*unwrap(module), allow_unresolved);
@@ -223,11 +508,12 @@ LLVMJaneDICompileUnit *LLVMJaneCreateCompileUnit(
     LLVMJaneDIBuilder *dibuilder, unsigned lang, const char *file,
     const char *dir, const char *producer, bool is_optimized, const char *flags,
     unsigned runtime_version, const char *split_name, uint64_t dwo_id,
-    bool emit_debug_info) {
+    unsigned emission_kind, bool emit_debug_info) {
   DICompileUnit *result =
       reinterpret_cast<DIBuilder *>(dibuilder)->createCompileUnit(
           lang, file, dir, producer, is_optimized, flags, runtime_version,
-          split_name, DIBuilder::FullDebug, dwo_id, emit_debug_info);
+          split_name, (DICompileUnit::DebugEmissionKind)emission_kind, dwo_id,
+          emit_debug_info);
   return reinterpret_cast<LLVMJaneDICompileUnit *>(result);
 }
 
@@ -256,6 +542,36 @@ LLVMJaneCreateFunction(LLVMJaneDIBuilder *dibuilder, LLVMJaneDIScope *scope,
   return reinterpret_cast<LLVMJaneDISubprogram *>(result);
 }
 
+LLVMJaneDILocalVariable *
+LLVMJaneCreateAutoVariable(LLVMJaneDIBuilder *dbuilder, LLVMJaneDIScope *scope,
+                           const char *name, LLVMJaneDIFile *file,
+                           unsigned line_no, LLVMJaneDIType *type,
+                           bool always_preserve, unsigned flags) {
+  DILocalVariable *result =
+      reinterpret_cast<DIBuilder *>(dbuilder)->createAutoVariable(
+          reinterpret_cast<DIScope *>(scope), name,
+          reinterpret_cast<DIFile *>(file), line_no,
+          reinterpret_cast<DIType *>(type), always_preserve,
+          (DINode::DIFlags)flags);
+  return reinterpret_cast<LLVMJaneDILocalVariable *>(result);
+}
+
+void LLVMJaneInsertDeclareAtEnd(LLVMJaneDIBuilder *dibuilder,
+                                LLVMValueRef storage,
+                                LLVMJaneDILocalVariable *var_info,
+                                unsigned line, unsigned col,
+                                LLVMJaneDIScope *scope,
+                                LLVMBasicBlockRef insert_at_end) {
+  DIBuilder *dbuilder = reinterpret_cast<DIBuilder *>(dibuilder);
+  DIScope *di_scope = reinterpret_cast<DIScope *>(scope);
+  DILocation *di_location =
+      DILocation::get(di_scope->getContext(), line, col, di_scope);
+  dbuilder->insertDeclare(unwrap(storage),
+                          reinterpret_cast<DILocalVariable *>(var_info),
+                          dbuilder->createExpression(), di_location,
+                          unwrap(insert_at_end));
+}
+
 void LLVMJaneDIBuilderFinalize(LLVMJaneDIBuilder *dibuilder) {
   reinterpret_cast<DIBuilder *>(dibuilder)->finalize();
 }
@@ -312,6 +628,55 @@ static FloatAbi get_float_abi(const Triple &triple) {
   }
 }
 
+void LLVMJaneSetAllowReassoc(LLVMValueRef instruction) {
+  unwrap<Instruction>(instruction)->setHasAllowReassoc(true);
+}
+
+void LLVMJaneSetRangeMetadata(LLVMValueRef load, uint64_t low, uint64_t high) {
+  Instruction *instruction = unwrap<Instruction>(load);
+  MDBuilder md_builder(instruction->getContext());
+  unsigned bits = instruction->getType()->getIntegerBitWidth();
+  instruction->setMetadata(
+      LLVMContext::MD_range,
+      md_builder.createRange(APInt(bits, low), APInt(bits, high)));
+}
+
+void LLVMJaneSetMustTail(LLVMValueRef call) {
+  unwrap<CallInst>(call)->setTailCallKind(CallInst::TCK_MustTail);
+}
+
+void LLVMJaneSetBranchWeights(LLVMValueRef branch, uint32_t true_weight,
+                              uint32_t false_weight) {
+  Instruction *instruction = unwrap<Instruction>(branch);
+  MDBuilder md_builder(instruction->getContext());
+  instruction->setMetadata(
+      LLVMContext::MD_prof,
+      md_builder.createBranchWeights(true_weight, false_weight));
+}
+
+LLVMJaneTBAANode *LLVMJaneCreateTBAARoot(const char *name) {
+  MDBuilder md_builder(*unwrap(LLVMGetGlobalContext()));
+  MDNode *root = md_builder.createTBAARoot(name);
+  return reinterpret_cast<LLVMJaneTBAANode *>(root);
+}
+
+LLVMJaneTBAANode *LLVMJaneCreateTBAAScalarType(LLVMJaneTBAANode *parent,
+                                               const char *name) {
+  MDBuilder md_builder(*unwrap(LLVMGetGlobalContext()));
+  MDNode *type_node = md_builder.createTBAAScalarTypeNode(
+      name, reinterpret_cast<MDNode *>(parent));
+  return reinterpret_cast<LLVMJaneTBAANode *>(type_node);
+}
+
+void LLVMJaneSetTBAA(LLVMValueRef instruction, LLVMJaneTBAANode *scalar_type) {
+  Instruction *inst = unwrap<Instruction>(instruction);
+  MDBuilder md_builder(inst->getContext());
+  MDNode *type_node = reinterpret_cast<MDNode *>(scalar_type);
+  inst->setMetadata(LLVMContext::MD_tbaa,
+                    md_builder.createTBAAStructTagNode(type_node, type_node,
+                                                       0));
+}
+
 Buf *get_dynamic_linker(LLVMTargetMachineRef target_machine_ref) {
   TargetMachine *target_machine =
       reinterpret_cast<TargetMachine *>(target_machine_ref);
@@ -15,8 +15,23 @@ static int usage(const char *arg0) {
           "--output (file)   [output file]\n"
           "--version  [display version of jane language]\n"
           "--release  [build with optimization on]\n"
-          "--strip    [exclude debug symbol]\n"
+          "--strip    [exclude debug symbol, same as -g0]\n"
+          "-g         [full debug info, the default]\n"
+          "-gline-tables-only [debug info for locations only]\n"
+          "-g0        [no debug info]\n"
+          "-gsplit-dwarf [write the debug info to a `.dwo` file]\n"
           "--static   [build a static executable]\n"
+          "--stats    [print phase timing as json to stderr]\n"
+          "--target (triple) [cross compile for target triple]\n"
+          "--max-errors (n) [stop after n errors, 0 for no limit]\n"
+          "--diag-format (text | json) [json prints one error per line]\n"
+          "--jobs (n) [roots built at once with several files, 0 for cpus]\n"
+          "-MF (file) [write a makefile rule listing the source files]\n"
+          "--interface-dir (dir) [reuse parsed imports across builds]\n"
+          "-ffunction-sections [put each function in its own section]\n"
+          "-fdata-sections [put each global in its own section]\n"
+          "--gc-sections [link without unreferenced sections]\n"
+          "--symbol-ordering-file (file) [emit these functions first]\n"
           "-Ipath     [add path to haeder include path]\n"
           "--export (exe | lib | obj) override output type\n",
           arg0);
@@ -33,22 +48,126 @@ static int version(void) {
 }
 
 struct Build {
-  const char *input_file;
+  JaneList<const char *> input_files;
   const char *output_file;
   bool release;
-  bool strip;
+  CodeGenDebugInfo debug_info;
+  bool split_dwarf;
   bool is_static;
   OutType out_type;
   const char *output_name;
+  const char *target_triple;
+  int max_errors;
+  DiagFormat diag_format;
+  int jobs;
+  const char *dep_file;
+  const char *interface_dir;
+  bool function_sections;
+  bool data_sections;
+  bool gc_sections;
+  const char *symbol_order_file;
   bool verbose;
+  bool stats;
 };
 
+static CodeGen *create_codegen(Build *b, Buf *root_source_dir) {
+  CodeGen *g = codegen_create(root_source_dir);
+  codegen_set_build_type(g, b->release ? CodeGenBuildTypeRelease
+                                       : CodeGenBuildTypeDebug);
+  codegen_set_debug_info(g, b->debug_info);
+  codegen_set_split_dwarf(g, b->split_dwarf);
+  codegen_set_is_static(g, b->is_static);
+  if (b->target_triple) {
+    codegen_set_target_triple(g, buf_create_from_str(b->target_triple));
+  }
+  codegen_set_max_errors(g, b->max_errors);
+  codegen_set_diag_format(g, b->diag_format);
+  if (b->dep_file) {
+    codegen_set_dep_file(g, buf_create_from_str(b->dep_file));
+  }
+  if (b->interface_dir) {
+    codegen_set_interface_dir(g, buf_create_from_str(b->interface_dir));
+  }
+  codegen_set_function_sections(g, b->function_sections);
+  codegen_set_data_sections(g, b->data_sections);
+  codegen_set_gc_sections(g, b->gc_sections);
+  if (b->symbol_order_file) {
+    codegen_set_symbol_order_file(g,
+                                  buf_create_from_str(b->symbol_order_file));
+  }
+  if (b->out_type != OutTypeUnknown) {
+    codegen_set_out_type(g, b->out_type);
+  }
+  if (b->out_type) {
+    codegen_set_out_name(g, buf_create_from_str(b->output_name));
+  }
+  codegen_set_verbose(g, buf_create_from_str(b->output_name));
+  return g;
+}
+
+struct BatchBuild {
+  Build *b;
+  JaneList<CodeGen *> roots;
+};
+
+static void build_batch_root(void *context, int index) {
+  BatchBuild *batch = (BatchBuild *)context;
+  CodeGen *g = batch->roots.at(index);
+  codegen_gen_root(g);
+  codegen_link(g, nullptr);
+  if (batch->b->stats) {
+    codegen_print_stats(g);
+  }
+}
+
+// every root is parsed first, sharing the target machine and the files they
+// have in common. the rest runs in forked workers: llvm types live in the
+// global context, which is not safe to use from several threads.
+static int build_batch(const char *arg0, Build *b) {
+  // each root is named by its `export` declaration, and gets no depfile since
+  // `-MF` names a single file
+  if (b->output_file || b->output_name || b->dep_file) {
+    return usage(arg0);
+  }
+  CodeGenCache *cache = codegen_cache_create();
+  BatchBuild batch = {0};
+  batch.b = b;
+  int failed = 0;
+  for (int i = 0; i < b->input_files.length; i += 1) {
+    const char *input_file = b->input_files.at(i);
+    if (strcmp(input_file, "-") == 0) {
+      return usage(arg0);
+    }
+    Buf *in_file_buf = buf_create_from_str(input_file);
+    Buf *root_source_dir = buf_alloc();
+    Buf *root_source_name = buf_alloc();
+    Buf *root_source_code = buf_alloc();
+    os_path_split(in_file_buf, root_source_dir, root_source_name);
+    os_fetch_file_path(in_file_buf, root_source_code);
+
+    CodeGen *g = create_codegen(b, root_source_dir);
+    codegen_set_cache(g, cache);
+    if (codegen_parse_root(g, root_source_name, root_source_code)) {
+      batch.roots.append(g);
+    } else {
+      failed += 1;
+    }
+  }
+  int jobs = b->jobs > 0 ? b->jobs : os_cpu_count();
+  failed += os_run_workers(batch.roots.length, jobs, build_batch_root, &batch);
+  return failed ? EXIT_FAILURE : 0;
+}
+
 static int build(const char *arg0, Build *b) {
-  if (!b->input_file) {
+  if (b->input_files.length == 0) {
     return usage(arg0);
   }
+  if (b->input_files.length > 1) {
+    return build_batch(arg0, b);
+  }
+  const char *input_file = b->input_files.at(0);
   Buf in_file_buf = BUF_INIT;
-  buf_init_from_str(&in_file_buf, b->input_file);
+  buf_init_from_str(&in_file_buf, input_file);
 
   Buf root_source_dir = BUF_INIT;
   Buf root_source_code = BUF_INIT;
@@ -59,26 +178,29 @@ static int build(const char *arg0, Build *b) {
     buf_init_from_str(&root_source_name, "");
   } else {
     os_path_split(&in_file_buf, &root_source_dir, &root_source_name);
-    os_fetch_file_path(buf_create_from_str(b->input_file), &root_source_code);
+    os_fetch_file_path(buf_create_from_str(input_file), &root_source_code);
   }
 
-  CodeGen *g = codegen_create(&root_source_dir);
-  codegen_set_build_type(g, b->release ? CodeGenBuildTypeRelease
-                                       : CodeGenBuildTypeDebug);
-  codegen_set_strip(g, b->strip);
-  codegen_set_is_static(g, b->is_static);
-  if (b->out_type != OutTypeUnknown) {
-    codegen_set_out_type(g, b->out_type);
-  }
-  if (b->out_type) {
-    codegen_set_out_name(g, buf_create_from_str(b->output_name));
-  }
-  codegen_set_verbose(g, buf_create_from_str(b->output_name));
-  codegen_add_root_code(g, &root_source_code, &root_source_code);
+  CodeGen *g = create_codegen(b, &root_source_dir);
+  codegen_add_root_code(g, &root_source_name, &root_source_code);
   codegen_link(g, b->output_file);
+  if (b->stats) {
+    codegen_print_stats(g);
+  }
   return 0;
 }
 
+static bool parse_diag_format(const char *str, DiagFormat *format) {
+  if (strcmp(str, "text") == 0) {
+    *format = DiagFormatText;
+  } else if (strcmp(str, "json") == 0) {
+    *format = DiagFormatJson;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 enum Cmd {
   CmdNone,
   CmdBuild,
@@ -96,9 +218,17 @@ int main(int argc, char **argv) {
       if (strcmp(arg, "--release") == 0) {
         b.release = true;
       } else if (strcmp(arg, "--strip") == 0) {
-        b.strip = true;
+        b.debug_info = CodeGenDebugInfoNone;
       } else if (strcmp(arg, "--static") == 0) {
         b.is_static = true;
+      } else if (strcmp(arg, "--stats") == 0) {
+        b.stats = true;
+      } else if (strcmp(arg, "--gc-sections") == 0) {
+        b.gc_sections = true;
+      } else if (strncmp(arg, "--diag-format=", 14) == 0) {
+        if (!parse_diag_format(arg + 14, &b.diag_format)) {
+          return usage(arg0);
+        }
       } else if (i + 1 >= argc) {
         return usage(arg0);
       } else {
@@ -117,10 +247,52 @@ int main(int argc, char **argv) {
           }
         } else if (strcmp(arg, "--name") == 0) {
           b.output_name = argv[i];
+        } else if (strcmp(arg, "--target") == 0) {
+          b.target_triple = argv[i];
+        } else if (strcmp(arg, "--max-errors") == 0) {
+          char *end = nullptr;
+          long max_errors = strtol(argv[i], &end, 10);
+          if (*end != 0 || max_errors < 0) {
+            return usage(arg0);
+          }
+          b.max_errors = (int)max_errors;
+        } else if (strcmp(arg, "--interface-dir") == 0) {
+          b.interface_dir = argv[i];
+        } else if (strcmp(arg, "--symbol-ordering-file") == 0) {
+          b.symbol_order_file = argv[i];
+        } else if (strcmp(arg, "--jobs") == 0) {
+          char *end = nullptr;
+          long jobs = strtol(argv[i], &end, 10);
+          if (*end != 0 || jobs < 0) {
+            return usage(arg0);
+          }
+          b.jobs = (int)jobs;
+        } else if (strcmp(arg, "--diag-format") == 0) {
+          if (!parse_diag_format(argv[i], &b.diag_format)) {
+            return usage(arg0);
+          }
         } else {
           return usage(arg0);
         }
       }
+    } else if (strcmp(arg, "-MF") == 0) {
+      if (i + 1 >= argc) {
+        return usage(arg0);
+      }
+      i += 1;
+      b.dep_file = argv[i];
+    } else if (strcmp(arg, "-g") == 0) {
+      b.debug_info = CodeGenDebugInfoFull;
+    } else if (strcmp(arg, "-gline-tables-only") == 0) {
+      b.debug_info = CodeGenDebugInfoLineTablesOnly;
+    } else if (strcmp(arg, "-g0") == 0) {
+      b.debug_info = CodeGenDebugInfoNone;
+    } else if (strcmp(arg, "-gsplit-dwarf") == 0) {
+      b.split_dwarf = true;
+    } else if (strcmp(arg, "-ffunction-sections") == 0) {
+      b.function_sections = true;
+    } else if (strcmp(arg, "-fdata-sections") == 0) {
+      b.data_sections = true;
     } else if (cmd == CmdNone) {
       if (strcmp(arg, "build") == 0) {
         cmd = CmdBuild;
@@ -135,11 +307,7 @@ int main(int argc, char **argv) {
       case CmdNone:
         jane_unreachable();
       case CmdBuild:
-        if (!b.input_file) {
-          b.input_file = arg;
-        } else {
-          return usage(arg0);
-        }
+        b.input_files.append(arg);
         break;
       case CmdVersion:
         return usage(arg0);
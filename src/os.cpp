@@ -4,9 +4,12 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 void os_spawn_process(const char *exe, JaneList<const char *> &args,
@@ -179,4 +182,113 @@ int os_get_cwd(Buf *out_cwd) {
     jane_panic("unable to get cwd: %s", strerror(err));
   }
   return 0;
+}
+
+double os_get_time(void) {
+  struct timespec tms;
+  if (clock_gettime(CLOCK_MONOTONIC, &tms) == -1) {
+    jane_panic("unable to read monotonic clock: %s", strerror(errno));
+  }
+  return (double)tms.tv_sec + (double)tms.tv_nsec / 1000000000.0;
+}
+
+int os_file_stamp(Buf *full_path, OsFileStamp *out_stamp) {
+  struct stat st;
+  if (stat(buf_ptr(full_path), &st)) {
+    return -1;
+  }
+  out_stamp->mtime_ns =
+      (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+  out_stamp->size = st.st_size;
+  return 0;
+}
+
+const void *os_map_file(Buf *full_path, size_t *out_size) {
+  int fd = open(buf_ptr(full_path), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (ptr == MAP_FAILED) {
+    return nullptr;
+  }
+  *out_size = st.st_size;
+  return ptr;
+}
+
+void os_unmap_file(const void *ptr, size_t size) {
+  munmap(const_cast<void *>(ptr), size);
+}
+
+int os_replace_file(Buf *full_path, Buf *contents) {
+  Buf *tmp_path = buf_sprintf("%s.%d.tmp", buf_ptr(full_path), (int)getpid());
+  int fd = open(buf_ptr(tmp_path), O_CREAT | O_CLOEXEC | O_WRONLY | O_TRUNC,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd == -1) {
+    return -1;
+  }
+  ssize_t amt_written = write(fd, buf_ptr(contents), buf_len(contents));
+  if (close(fd) || amt_written != buf_len(contents) ||
+      rename(buf_ptr(tmp_path), buf_ptr(full_path))) {
+    unlink(buf_ptr(tmp_path));
+    return -1;
+  }
+  return 0;
+}
+
+int64_t os_max_rss(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    jane_panic("unable to get resource usage: %s", strerror(errno));
+  }
+  // kilobytes on linux
+  return (int64_t)usage.ru_maxrss * 1024;
+}
+
+int os_cpu_count(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count < 1 ? 1 : (int)count;
+}
+
+int os_run_workers(int count, int max_jobs,
+                   void (*worker)(void *context, int index), void *context) {
+  int next = 0;
+  int running = 0;
+  int failed = 0;
+  while (next < count || running > 0) {
+    if (next < count && running < max_jobs) {
+      // buffered output would otherwise be written by the child as well
+      fflush(stdout);
+      fflush(stderr);
+      pid_t pid = fork();
+      if (pid == -1) {
+        jane_panic("fork failed: %s", strerror(errno));
+      }
+      if (pid == 0) {
+        worker(context, next);
+        exit(0);
+      }
+      next += 1;
+      running += 1;
+      continue;
+    }
+    int status;
+    if (waitpid(-1, &status, 0) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      jane_panic("waitpid failed: %s", strerror(errno));
+    }
+    running -= 1;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failed += 1;
+    }
+  }
+  return failed;
 }
\ No newline at end of file
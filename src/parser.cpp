@@ -3,13 +3,16 @@
 #include "include/util.hpp"
 
 #include <llvm-c/Core.h>
+#include <setjmp.h>
 #include <stdarg.h>
 #include <stdio.h>
 
-static const char *bin_op_str(BinOpType bin_op) {
+const char *bin_op_str(BinOpType bin_op) {
   switch (bin_op) {
   case BinOpTypeInvalid:
     return "(invalid)";
+  case BinOpTypeAssign:
+    return "=";
   case BinOpTypeBoolOr:
     return "||";
   case BinOpTypeBoolAnd:
@@ -60,23 +63,14 @@ static const char *prefix_op_str(PrefixOp prefix_op) {
     return "!";
   case PrefixOpBinNot:
     return "~";
+  case PrefixOpAddressOf:
+    return "&";
+  case PrefixOpDereference:
+    return "*";
   }
   jane_unreachable();
 }
 
-__attribute__((format(printf, 2, 3))) __attribute__((noreturn)) static void
-ast_error(Token *token, const char *format, ...) {
-  int line = token->start_line + 1;
-  int column = token->start_column + 1;
-  va_list ap;
-  va_start(ap, format);
-  fprintf(stderr, "Error: Line %d, column %d: ", line, column);
-  vfprintf(stderr, format, ap);
-  fprintf(stderr, "\n");
-  va_end(ap);
-  exit(EXIT_FAILURE);
-}
-
 const char *node_type_str(NodeType node_type) {
   switch (node_type) {
   case NodeTypeRoot:
@@ -119,6 +113,30 @@ const char *node_type_str(NodeType node_type) {
     return "PrefixOpExpr";
   case NodeTypeUse:
     return "use";
+  case NodeTypeVariableDeclaration:
+    return "VariableDeclaration";
+  case NodeTypeBoolLiteral:
+    return "BoolLiteral";
+  case NodeTypeIfExpr:
+    return "IfExpr";
+  case NodeTypeWhileExpr:
+    return "WhileExpr";
+  case NodeTypeForExpr:
+    return "ForExpr";
+  case NodeTypeBreak:
+    return "Break";
+  case NodeTypeContinue:
+    return "Continue";
+  case NodeTypeStructDecl:
+    return "StructDecl";
+  case NodeTypeStructField:
+    return "StructField";
+  case NodeTypeFieldAccessExpr:
+    return "FieldAccessExpr";
+  case NodeTypeArrayAccessExpr:
+    return "ArrayAccessExpr";
+  case NodeTypeAsmExpr:
+    return "AsmExpr";
   }
   jane_unreachable();
 }
@@ -152,6 +170,10 @@ void ast_print(AstNode *node, int indent) {
     Buf *name_buf = &node->data.fn_proto.name;
     fprintf(stderr, "%s '%s'\n", node_type_str(node->type), buf_ptr(name_buf));
 
+    for (int i = 0; i < node->data.fn_proto.generic_params.length; i += 1) {
+      AstNode *child = node->data.fn_proto.generic_params.at(i);
+      ast_print(child, indent + 2);
+    }
     for (int i = 0; i < node->data.fn_proto.params.length; i += 1) {
       AstNode *child = node->data.fn_proto.params.at(i);
       ast_print(child, indent + 2);
@@ -171,7 +193,9 @@ void ast_print(AstNode *node, int indent) {
   }
   case NodeTypeParamDecl: {
     Buf *name_buf = &node->data.param_decl.name;
-    fprintf(stderr, "%s '%s'\n", node_type_str(node->type), buf_ptr(name_buf));
+    fprintf(stderr, "%s%s '%s'\n", node_type_str(node->type),
+            node->data.param_decl.is_noalias ? " noalias" : "",
+            buf_ptr(name_buf));
 
     ast_print(node->data.param_decl.type, indent + 2);
 
@@ -192,10 +216,30 @@ void ast_print(AstNode *node, int indent) {
       ast_print(node->data.type.child_type, indent + 2);
       break;
     }
+    case AstNodeTypeTypeVector:
+      fprintf(stderr, "VectorType %s\n",
+              buf_ptr(&node->data.type.len->data.number));
+      ast_print(node->data.type.child_type, indent + 2);
+      break;
+    case AstNodeTypeTypeArray: {
+      AstNode *len_node = node->data.type.len;
+      fprintf(stderr, "ArrayType %s\n",
+              buf_ptr(len_node->type == NodeTypeSymbol
+                          ? &len_node->data.symbol
+                          : &len_node->data.number));
+      ast_print(node->data.type.child_type, indent + 2);
+      break;
+    }
+    case AstNodeTypeTypeSlice:
+      fprintf(stderr, "'%s' SliceType\n",
+              node->data.type.is_const ? "const" : "mut");
+      ast_print(node->data.type.child_type, indent + 2);
+      break;
     }
     break;
   case NodeTypeReturnExpr:
-    fprintf(stderr, "%s\n", node_type_str(node->type));
+    fprintf(stderr, "%s%s\n", node_type_str(node->type),
+            node->data.return_expr.is_tail ? " tail" : "");
     if (node->data.return_expr.expression)
       ast_print(node->data.return_expr.expression, indent + 2);
     break;
@@ -218,7 +262,8 @@ void ast_print(AstNode *node, int indent) {
     ast_print(node->data.bin_op_expr.op2, indent + 2);
     break;
   case NodeTypeFnCallExpr:
-    fprintf(stderr, "%s\n", node_type_str(node->type));
+    fprintf(stderr, "%s%s\n", node_type_str(node->type),
+            node->data.fn_call_expr.is_builtin ? " builtin" : "");
     ast_print(node->data.fn_call_expr.fn_ref_expr, indent + 2);
     for (int i = 0; i < node->data.fn_call_expr.params.length; i += 1) {
       AstNode *child = node->data.fn_call_expr.params.at(i);
@@ -226,7 +271,9 @@ void ast_print(AstNode *node, int indent) {
     }
     break;
   case NodeTypeDirective:
-    fprintf(stderr, "%s\n", node_type_str(node->type));
+    fprintf(stderr, "%s '%s' '%s'\n", node_type_str(node->type),
+            buf_ptr(&node->data.directive.name),
+            buf_ptr(&node->data.directive.param));
     break;
   case NodeTypeCastExpr:
     fprintf(stderr, "%s\n", node_type_str(node->type));
@@ -255,6 +302,78 @@ void ast_print(AstNode *node, int indent) {
     fprintf(stderr, "%s `%s`\n", node_type_str(node->type),
             buf_ptr(&node->data.use.path));
     break;
+  case NodeTypeVariableDeclaration:
+    fprintf(stderr, "%s %s '%s'\n", node_type_str(node->type),
+            node->data.variable_declaration.is_const ? "const" : "mut",
+            buf_ptr(&node->data.variable_declaration.symbol));
+    if (node->data.variable_declaration.type)
+      ast_print(node->data.variable_declaration.type, indent + 2);
+    if (node->data.variable_declaration.expr)
+      ast_print(node->data.variable_declaration.expr, indent + 2);
+    break;
+  case NodeTypeBoolLiteral:
+    fprintf(stderr, "%s %s\n", node_type_str(node->type),
+            node->data.bool_literal ? "true" : "false");
+    break;
+  case NodeTypeIfExpr:
+    fprintf(stderr, "%s\n", node_type_str(node->type));
+    ast_print(node->data.if_expr.condition, indent + 2);
+    ast_print(node->data.if_expr.then_block, indent + 2);
+    if (node->data.if_expr.else_node)
+      ast_print(node->data.if_expr.else_node, indent + 2);
+    break;
+  case NodeTypeWhileExpr:
+    fprintf(stderr, "%s\n", node_type_str(node->type));
+    ast_print(node->data.while_expr.condition, indent + 2);
+    ast_print(node->data.while_expr.body, indent + 2);
+    break;
+  case NodeTypeForExpr:
+    fprintf(stderr, "%s\n", node_type_str(node->type));
+    if (node->data.for_expr.init)
+      ast_print(node->data.for_expr.init, indent + 2);
+    if (node->data.for_expr.condition)
+      ast_print(node->data.for_expr.condition, indent + 2);
+    if (node->data.for_expr.step)
+      ast_print(node->data.for_expr.step, indent + 2);
+    ast_print(node->data.for_expr.body, indent + 2);
+    break;
+  case NodeTypeBreak:
+  case NodeTypeContinue:
+    fprintf(stderr, "%s\n", node_type_str(node->type));
+    break;
+  case NodeTypeStructDecl:
+    fprintf(stderr, "%s '%s'\n", node_type_str(node->type),
+            buf_ptr(&node->data.struct_decl.name));
+    for (int i = 0; i < node->data.struct_decl.fields.length; i += 1) {
+      AstNode *child = node->data.struct_decl.fields.at(i);
+      ast_print(child, indent + 2);
+    }
+    break;
+  case NodeTypeStructField:
+    fprintf(stderr, "%s '%s'\n", node_type_str(node->type),
+            buf_ptr(&node->data.struct_field.name));
+    ast_print(node->data.struct_field.type, indent + 2);
+    break;
+  case NodeTypeFieldAccessExpr:
+    fprintf(stderr, "%s '%s'\n", node_type_str(node->type),
+            buf_ptr(&node->data.field_access_expr.field_name));
+    ast_print(node->data.field_access_expr.struct_expr, indent + 2);
+    break;
+  case NodeTypeArrayAccessExpr:
+    fprintf(stderr, "%s\n", node_type_str(node->type));
+    ast_print(node->data.array_access_expr.array_ref_expr, indent + 2);
+    ast_print(node->data.array_access_expr.subscript, indent + 2);
+    break;
+  case NodeTypeAsmExpr:
+    fprintf(stderr, "%s%s '%s' '%s'\n", node_type_str(node->type),
+            node->data.asm_expr.is_volatile ? " volatile" : "",
+            buf_ptr(&node->data.asm_expr.asm_template),
+            buf_ptr(&node->data.asm_expr.constraints));
+    for (int i = 0; i < node->data.asm_expr.operands.length; i += 1) {
+      ast_print(node->data.asm_expr.operands.at(i), indent + 2);
+    }
+    ast_print(node->data.asm_expr.return_type, indent + 2);
+    break;
   }
 }
 
@@ -263,8 +382,30 @@ struct ParseContext {
   AstNode *root;
   JaneList<Token> *tokens;
   JaneList<AstNode *> *directive_list;
+  ImportTableEntry *owner;
+  Buf *path;
+  ErrorList *errors;
+  // where parsing resumes after an error: the innermost block being parsed,
+  // or the top level. nothing in the parser owns memory that unwinding past
+  // it would leak worse than the ast already does.
+  jmp_buf *recover;
+  // the token the last error was reported at; recovery skips from there
+  int error_token_index;
 };
 
+// reports the error and abandons the statement or declaration being parsed
+__attribute__((format(printf, 3, 4))) __attribute__((noreturn)) static void
+ast_error(ParseContext *pc, Token *token, const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  err_list_add(pc->errors, ErrorCodeSyntax, pc->path, token->start_line,
+               token->start_column, token->end_line, token->end_column,
+               buf_vprintf(format, ap));
+  va_end(ap);
+  pc->error_token_index = (int)(token - pc->tokens->items);
+  longjmp(*pc->recover, 1);
+}
+
 static AstNode *ast_create_node_no_line_info(NodeType type) {
   AstNode *node = allocate<AstNode>(1);
   node->type = type;
@@ -273,6 +414,14 @@ static AstNode *ast_create_node_no_line_info(NodeType type) {
 static void ast_update_node_line_info(AstNode *node, Token *first_token) {
   node->line = first_token->start_line;
   node->column = first_token->start_column;
+  node->line_end = first_token->end_line;
+  node->column_end = first_token->end_column;
+}
+
+// for nodes whose closing token is not part of any child
+static void ast_set_node_end(AstNode *node, Token *last_token) {
+  node->line_end = last_token->end_line;
+  node->column_end = last_token->end_column;
 }
 
 static AstNode *ast_create_node(NodeType type, Token *first_token) {
@@ -285,6 +434,9 @@ static AstNode *ast_create_node_with_node(NodeType type, AstNode *other_node) {
   AstNode *node = ast_create_node_no_line_info(type);
   node->line = other_node->line;
   node->column = other_node->column;
+  node->line_end = other_node->line_end;
+  node->column_end = other_node->column_end;
+  node->owner = other_node->owner;
   return node;
 }
 
@@ -337,7 +489,7 @@ __attribute__((noreturn)) void ast_invalid_token_error(ParseContext *pc,
                                                        Token *token) {
   Buf token_value = BUF_INIT;
   ast_buf_from_token(pc, token, &token_value);
-  ast_error(token, "invalid token: '%s'", buf_ptr(&token_value));
+  ast_error(pc, token, "invalid token: '%s'", buf_ptr(&token_value));
 }
 
 static AstNode *ast_parse_expression(ParseContext *pc, int *token_index,
@@ -361,12 +513,27 @@ static AstNode *ast_parse_directive(ParseContext *pc, int token_index,
   token_index += 1;
   ast_expect_token(pc, name_symbol, TokenIdSymbol);
   ast_buf_from_token(pc, name_symbol, &node->data.directive.name);
+  buf_resize(&node->data.directive.param, 0);
   Token *l_paren = &pc->tokens->at(token_index);
+  if (l_paren->id != TokenIdLParen) {
+    // parameterless directive, e.g. `#inline`
+    *new_token_index = token_index;
+    return node;
+  }
   token_index += 1;
-  ast_expect_token(pc, l_paren, TokenIdLParen);
-  Token *param_str = &pc->tokens->at(token_index);
+  Token *param = &pc->tokens->at(token_index);
+  token_index += 1;
+  if (param->id == TokenIdStringLiteral) {
+    parse_string_literal(pc, param, &node->data.directive.param);
+  } else if (param->id == TokenIdNumberLiteral) {
+    ast_buf_from_token(pc, param, &node->data.directive.param);
+  } else {
+    ast_invalid_token_error(pc, param);
+  }
+  Token *r_paren = &pc->tokens->at(token_index);
   token_index += 1;
-  ast_expect_token(pc, param_str, TokenIdStringLiteral);
+  ast_expect_token(pc, r_paren, TokenIdRParen);
+  ast_set_node_end(node, r_paren);
   *new_token_index = token_index;
   return node;
 }
@@ -395,6 +562,29 @@ static AstNode *ast_parse_type(ParseContext *pc, int token_index,
   if (token->id == TokenIdKeywordUnreachable) {
     node->data.type.type = AstNodeTypeTypePrimitive;
     buf_init_from_str(&node->data.type.primitive_name, "unreachable");
+  } else if (token->id == TokenIdSymbol &&
+             pc->tokens->at(token_index).id == TokenIdLParen) {
+    // vector(N, T)
+    Buf name = BUF_INIT;
+    ast_buf_from_token(pc, token, &name);
+    if (!buf_eql_str(&name, "vector")) {
+      ast_invalid_token_error(pc, token);
+    }
+    node->data.type.type = AstNodeTypeTypeVector;
+    token_index += 1;
+    Token *len_token = &pc->tokens->at(token_index);
+    token_index += 1;
+    ast_expect_token(pc, len_token, TokenIdNumberLiteral);
+    node->data.type.len = ast_create_node(NodeTypeNumberLiteral, len_token);
+    ast_buf_from_token(pc, len_token, &node->data.type.len->data.number);
+    Token *comma = &pc->tokens->at(token_index);
+    token_index += 1;
+    ast_expect_token(pc, comma, TokenIdComma);
+    node->data.type.child_type = ast_parse_type(pc, token_index, &token_index);
+    Token *r_paren = &pc->tokens->at(token_index);
+    token_index += 1;
+    ast_expect_token(pc, r_paren, TokenIdRParen);
+    ast_set_node_end(node, r_paren);
   } else if (token->id == TokenIdSymbol) {
     node->data.type.type = AstNodeTypeTypePrimitive;
     ast_buf_from_token(pc, token, &node->data.type.primitive_name);
@@ -410,6 +600,39 @@ static AstNode *ast_parse_type(ParseContext *pc, int token_index,
       ast_invalid_token_error(pc, const_or_mut);
     }
     node->data.type.child_type = ast_parse_type(pc, token_index, &token_index);
+  } else if (token->id == TokenIdLBracket) {
+    // [N]T or []const T / []mut T
+    Token *len_token = &pc->tokens->at(token_index);
+    token_index += 1;
+    if (len_token->id == TokenIdNumberLiteral) {
+      node->data.type.type = AstNodeTypeTypeArray;
+      node->data.type.len = ast_create_node(NodeTypeNumberLiteral, len_token);
+      ast_buf_from_token(pc, len_token, &node->data.type.len->data.number);
+      Token *r_bracket = &pc->tokens->at(token_index);
+      token_index += 1;
+      ast_expect_token(pc, r_bracket, TokenIdRBracket);
+    } else if (len_token->id == TokenIdSymbol) {
+      // the name of a global constant
+      node->data.type.type = AstNodeTypeTypeArray;
+      node->data.type.len = ast_create_node(NodeTypeSymbol, len_token);
+      ast_buf_from_token(pc, len_token, &node->data.type.len->data.symbol);
+      Token *r_bracket = &pc->tokens->at(token_index);
+      token_index += 1;
+      ast_expect_token(pc, r_bracket, TokenIdRBracket);
+    } else {
+      ast_expect_token(pc, len_token, TokenIdRBracket);
+      node->data.type.type = AstNodeTypeTypeSlice;
+      Token *const_or_mut = &pc->tokens->at(token_index);
+      token_index += 1;
+      if (const_or_mut->id == TokenIdKeywordMut) {
+        node->data.type.is_const = false;
+      } else if (const_or_mut->id == TokenIdKeywordConst) {
+        node->data.type.is_const = true;
+      } else {
+        ast_invalid_token_error(pc, const_or_mut);
+      }
+    }
+    node->data.type.child_type = ast_parse_type(pc, token_index, &token_index);
   } else {
     ast_invalid_token_error(pc, token);
   }
@@ -417,12 +640,22 @@ static AstNode *ast_parse_type(ParseContext *pc, int token_index,
   return node;
 }
 
+/*
+ParamDecl : option(token(NoAlias)) token(Symbol) token(Colon) Type
+*/
 static AstNode *ast_parse_param_decl(ParseContext *pc, int token_index,
                                      int *new_token_index) {
   Token *param_name = &pc->tokens->at(token_index);
   token_index += 1;
+  bool is_noalias = false;
+  if (param_name->id == TokenIdKeywordNoAlias) {
+    is_noalias = true;
+    param_name = &pc->tokens->at(token_index);
+    token_index += 1;
+  }
   ast_expect_token(pc, param_name, TokenIdSymbol);
   AstNode *node = ast_create_node(NodeTypeParamDecl, param_name);
+  node->data.param_decl.is_noalias = is_noalias;
   ast_buf_from_token(pc, param_name, &node->data.param_decl.name);
   Token *colon = &pc->tokens->at(token_index);
   token_index += 1;
@@ -445,13 +678,17 @@ static void ast_parse_param_decl_list(ParseContext *pc, int token_index,
     *new_token_index = token_index;
     return;
   }
+  // most parameter lists are short, so they are collected inline and then
+  // copied into a list of exactly the right size
+  JaneSmallList<AstNode *, 4> list = {};
   for (;;) {
     AstNode *param_decl_node =
         ast_parse_param_decl(pc, token_index, &token_index);
-    params->append(param_decl_node);
+    list.append(param_decl_node);
     Token *token = &pc->tokens->at(token_index);
     token_index += 1;
     if (token->id == TokenIdRParen) {
+      list.move_to(params);
       *new_token_index = token_index;
       return;
     } else {
@@ -466,20 +703,22 @@ static void ast_parse_fn_call_param_list(ParseContext *pc, int token_index,
                                          JaneList<AstNode *> *params) {
   Token *l_paren = &pc->tokens->at(token_index);
   token_index += 1;
-  ast_expect_token(pc, l_paren, TokenIdRParen);
+  ast_expect_token(pc, l_paren, TokenIdLParen);
   Token *token = &pc->tokens->at(token_index);
   if (token->id == TokenIdRParen) {
     token_index += 1;
     *new_token_index = token_index;
     return;
   }
+  JaneSmallList<AstNode *, 4> list = {};
   for (;;) {
     AstNode *expr = ast_parse_expression(pc, &token_index, true);
-    params->append(expr);
+    list.append(expr);
 
     Token *token = &pc->tokens->at(token_index);
     token_index += 1;
     if (token->id == TokenIdRParen) {
+      list.move_to(params);
       *new_token_index = token_index;
       return;
     } else {
@@ -507,10 +746,63 @@ static AstNode *ast_parse_grouped_expr(ParseContext *pc, int *token_index,
   return node;
 }
 
+/*
+AsmExpression : token(Asm) option(token(Volatile)) token(LParen)
+token(String) token(Comma) token(String) many(token(Comma) Expression)
+token(RParen) option(token(Arrow) Type)
+*/
+static AstNode *ast_parse_asm_expr(ParseContext *pc, int *token_index) {
+  Token *asm_token = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  AstNode *node = ast_create_node(NodeTypeAsmExpr, asm_token);
+  Token *token = &pc->tokens->at(*token_index);
+  if (token->id == TokenIdKeywordVolatile) {
+    node->data.asm_expr.is_volatile = true;
+    *token_index += 1;
+  }
+  Token *l_paren = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, l_paren, TokenIdLParen);
+  Token *template_token = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, template_token, TokenIdStringLiteral);
+  parse_string_literal(pc, template_token, &node->data.asm_expr.asm_template);
+  Token *comma = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, comma, TokenIdComma);
+  Token *constraints_token = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, constraints_token, TokenIdStringLiteral);
+  parse_string_literal(pc, constraints_token,
+                       &node->data.asm_expr.constraints);
+  for (;;) {
+    token = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    if (token->id == TokenIdRParen) {
+      ast_set_node_end(node, token);
+      break;
+    }
+    ast_expect_token(pc, token, TokenIdComma);
+    AstNode *operand = ast_parse_expression(pc, token_index, true);
+    node->data.asm_expr.operands.append(operand);
+  }
+  Token *arrow = &pc->tokens->at(*token_index);
+  if (arrow->id == TokenIdArrow) {
+    *token_index += 1;
+    node->data.asm_expr.return_type =
+        ast_parse_type(pc, *token_index, token_index);
+  } else {
+    node->data.asm_expr.return_type = ast_create_void_type_node(pc, arrow);
+  }
+  return node;
+}
+
 static AstNode *ast_parse_primary_expr(ParseContext *pc, int *token_index,
                                        bool mandatory) {
   Token *token = &pc->tokens->at(*token_index);
-  if (token->id == TokenIdNumberLiteral) {
+  if (token->id == TokenIdKeywordAsm) {
+    return ast_parse_asm_expr(pc, token_index);
+  } else if (token->id == TokenIdNumberLiteral) {
     AstNode *node = ast_create_node(NodeTypeNumberLiteral, token);
     ast_buf_from_token(pc, token, &node->data.number);
     *token_index += 1;
@@ -524,6 +816,12 @@ static AstNode *ast_parse_primary_expr(ParseContext *pc, int *token_index,
     AstNode *node = ast_create_node(NodeTypeUnreachable, token);
     *token_index += 1;
     return node;
+  } else if (token->id == TokenIdKeywordTrue ||
+             token->id == TokenIdKeywordFalse) {
+    AstNode *node = ast_create_node(NodeTypeBoolLiteral, token);
+    node->data.bool_literal = token->id == TokenIdKeywordTrue;
+    *token_index += 1;
+    return node;
   } else if (token->id == TokenIdSymbol) {
     AstNode *node = ast_create_node(NodeTypeSymbol, token);
     ast_buf_from_token(pc, token, &node->data.symbol);
@@ -544,21 +842,70 @@ static AstNode *ast_parse_primary_expr(ParseContext *pc, int *token_index,
   ast_invalid_token_error(pc, token);
 }
 
+/*
+FnCallExpression : token(AtSign) token(Symbol) ParamList |
+PrimaryExpression option(ParamList) many(SuffixOp)
+SuffixOp : token(Dot) token(Symbol) | token(LBracket) Expression token(RBracket)
+*/
 static AstNode *ast_parse_fn_call_expr(ParseContext *pc, int *token_index,
                                        bool mandatory) {
+  Token *at_sign = &pc->tokens->at(*token_index);
+  if (at_sign->id == TokenIdAtSign) {
+    *token_index += 1;
+    Token *name_token = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    ast_expect_token(pc, name_token, TokenIdSymbol);
+    AstNode *name_node = ast_create_node(NodeTypeSymbol, name_token);
+    ast_buf_from_token(pc, name_token, &name_node->data.symbol);
+    AstNode *node = ast_create_node(NodeTypeFnCallExpr, at_sign);
+    node->data.fn_call_expr.fn_ref_expr = name_node;
+    node->data.fn_call_expr.is_builtin = true;
+    ast_parse_fn_call_param_list(pc, *token_index, token_index,
+                                 &node->data.fn_call_expr.params);
+    ast_set_node_end(node, &pc->tokens->at(*token_index - 1));
+    return node;
+  }
   AstNode *primary_expr = ast_parse_primary_expr(pc, token_index, mandatory);
   if (!primary_expr) {
     return nullptr;
   }
+  AstNode *node = primary_expr;
   Token *l_paren = &pc->tokens->at(*token_index);
-  if (l_paren->id != TokenIdLParen) {
-    return primary_expr;
+  if (l_paren->id == TokenIdLParen) {
+    node = ast_create_node_with_node(NodeTypeFnCallExpr, primary_expr);
+    node->data.fn_call_expr.fn_ref_expr = primary_expr;
+    ast_parse_fn_call_param_list(pc, *token_index, token_index,
+                                 &node->data.fn_call_expr.params);
+    ast_set_node_end(node, &pc->tokens->at(*token_index - 1));
+  }
+  for (;;) {
+    Token *dot = &pc->tokens->at(*token_index);
+    if (dot->id == TokenIdLBracket) {
+      *token_index += 1;
+      AstNode *access_node = ast_create_node(NodeTypeArrayAccessExpr, dot);
+      access_node->data.array_access_expr.array_ref_expr = node;
+      access_node->data.array_access_expr.subscript =
+          ast_parse_expression(pc, token_index, true);
+      Token *r_bracket = &pc->tokens->at(*token_index);
+      *token_index += 1;
+      ast_expect_token(pc, r_bracket, TokenIdRBracket);
+      ast_set_node_end(access_node, r_bracket);
+      node = access_node;
+      continue;
+    } else if (dot->id != TokenIdDot) {
+      return node;
+    }
+    *token_index += 1;
+    Token *field_name = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    ast_expect_token(pc, field_name, TokenIdSymbol);
+    AstNode *access_node = ast_create_node(NodeTypeFieldAccessExpr, dot);
+    access_node->data.field_access_expr.struct_expr = node;
+    ast_buf_from_token(pc, field_name,
+                       &access_node->data.field_access_expr.field_name);
+    ast_set_node_end(access_node, field_name);
+    node = access_node;
   }
-  AstNode *node = ast_create_node_with_node(NodeTypeFnCallExpr, primary_expr);
-  node->data.fn_call_expr.fn_ref_expr = primary_expr;
-  ast_parse_fn_call_param_list(pc, *token_index, token_index,
-                               &node->data.fn_call_expr.params);
-  return node;
 }
 
 static PrefixOp tok_to_prefix_op(Token *token) {
@@ -569,6 +916,10 @@ static PrefixOp tok_to_prefix_op(Token *token) {
     return PrefixOpNegation;
   case TokenIdTilde:
     return PrefixOpBinNot;
+  case TokenIdBinAnd:
+    return PrefixOpAddressOf;
+  case TokenIdStar:
+    return PrefixOpDereference;
   default:
     return PrefixOpInvalid;
   }
@@ -596,7 +947,8 @@ static AstNode *ast_parse_prefix_op_expr(ParseContext *pc, int *token_index,
   if (prefix_op == PrefixOpInvalid) {
     return ast_parse_fn_call_expr(pc, token_index, mandatory);
   }
-  AstNode *primary_expr = ast_parse_fn_call_expr(pc, token_index, true);
+  // prefix operators nest, e.g. `*&x` or `-*p`
+  AstNode *primary_expr = ast_parse_prefix_op_expr(pc, token_index, true);
   AstNode *node = ast_create_node(NodeTypePrefixOpExpr, token);
   node->data.prefix_op_expr.primary_expr = primary_expr;
   node->data.prefix_op_expr.prefix_op = prefix_op;
@@ -786,7 +1138,7 @@ static AstNode *ast_parse_bin_xor_expr(ParseContext *pc, int *token_index,
     return nullptr;
   }
   Token *token = &pc->tokens->at(*token_index);
-  if (token->id == TokenIdBinXor) {
+  if (token->id != TokenIdBinXor) {
     return operand_1;
   }
   *token_index += 1;
@@ -874,7 +1226,7 @@ static AstNode *ast_parse_comparison_expr(ParseContext *pc, int *token_index,
 static AstNode *ast_parse_bool_and_expr(ParseContext *pc, int *token_index,
                                         bool mandatory) {
   AstNode *operand_1 = ast_parse_comparison_expr(pc, token_index, mandatory);
-  if (operand_1) {
+  if (!operand_1) {
     return nullptr;
   }
   Token *token = &pc->tokens->at(*token_index);
@@ -890,12 +1242,26 @@ static AstNode *ast_parse_bool_and_expr(ParseContext *pc, int *token_index,
   return node;
 }
 
+/*
+ReturnExpression : token(Return) option(token(Symbol)) option(Expression)
+*/
 static AstNode *ast_parse_return_expr(ParseContext *pc, int *token_index,
                                       bool mandatory) {
   Token *return_tok = &pc->tokens->at(*token_index);
   if (return_tok->id == TokenIdKeywordReturn) {
     *token_index += 1;
     AstNode *node = ast_create_node(NodeTypeReturnExpr, return_tok);
+    // `tail` is only special right after `return` and before a callee name,
+    // so it stays usable as an identifier
+    Token *tail_tok = &pc->tokens->at(*token_index);
+    if (tail_tok->id == TokenIdSymbol &&
+        pc->tokens->at(*token_index + 1).id == TokenIdSymbol &&
+        mem_eql_str(buf_ptr(pc->buf) + tail_tok->start_position,
+                    tail_tok->end_position - tail_tok->start_position,
+                    "tail")) {
+      node->data.return_expr.is_tail = true;
+      *token_index += 1;
+    }
     node->data.return_expr.expression =
         ast_parse_expression(pc, token_index, false);
     return node;
@@ -925,6 +1291,32 @@ static AstNode *ast_parse_bool_or_expr(ParseContext *pc, int *token_index,
   return node;
 }
 
+/*
+AssignmentExpression : BoolOrExpression token(Eq) BoolOrExpression |
+BoolOrExpression
+*/
+static AstNode *ast_parse_ass_expr(ParseContext *pc, int *token_index,
+                                   bool mandatory) {
+  AstNode *lhs = ast_parse_bool_or_expr(pc, token_index, mandatory);
+  if (!lhs) {
+    return nullptr;
+  }
+  Token *token = &pc->tokens->at(*token_index);
+  if (token->id != TokenIdEq) {
+    return lhs;
+  }
+  *token_index += 1;
+  AstNode *rhs = ast_parse_bool_or_expr(pc, token_index, true);
+  AstNode *node = ast_create_node(NodeTypeBinOpExpr, token);
+  node->data.bin_op_expr.op1 = lhs;
+  node->data.bin_op_expr.bin_op = BinOpTypeAssign;
+  node->data.bin_op_expr.op2 = rhs;
+  return node;
+}
+
+/*
+Expression : ReturnExpression | AssignmentExpression
+*/
 static AstNode *ast_parse_expression(ParseContext *pc, int *token_index,
                                      bool mandatory) {
   Token *token = &pc->tokens->at(*token_index);
@@ -932,9 +1324,9 @@ static AstNode *ast_parse_expression(ParseContext *pc, int *token_index,
   if (return_expr) {
     return return_expr;
   }
-  AstNode *bool_or_expr = ast_parse_bool_or_expr(pc, token_index, false);
-  if (bool_or_expr) {
-    return bool_or_expr;
+  AstNode *ass_expr = ast_parse_ass_expr(pc, token_index, false);
+  if (ass_expr) {
+    return ass_expr;
   }
   if (!mandatory) {
     return nullptr;
@@ -942,18 +1334,287 @@ static AstNode *ast_parse_expression(ParseContext *pc, int *token_index,
   ast_invalid_token_error(pc, token);
 }
 
+/*
+VariableDeclaration : (token(Const) | token(Mut)) token(Symbol)
+option(token(Colon) Type) option(token(Eq) Expression)
+*/
+static AstNode *ast_parse_variable_declaration(ParseContext *pc,
+                                               int *token_index,
+                                               bool mandatory) {
+  Token *const_or_mut = &pc->tokens->at(*token_index);
+  bool is_const;
+  if (const_or_mut->id == TokenIdKeywordConst) {
+    is_const = true;
+  } else if (const_or_mut->id == TokenIdKeywordMut) {
+    is_const = false;
+  } else if (mandatory) {
+    ast_invalid_token_error(pc, const_or_mut);
+  } else {
+    return nullptr;
+  }
+  *token_index += 1;
+  AstNode *node = ast_create_node(NodeTypeVariableDeclaration, const_or_mut);
+  node->data.variable_declaration.is_const = is_const;
+
+  Token *name_token = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, name_token, TokenIdSymbol);
+  ast_buf_from_token(pc, name_token, &node->data.variable_declaration.symbol);
+
+  Token *colon_or_eq = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  if (colon_or_eq->id == TokenIdColon) {
+    node->data.variable_declaration.type =
+        ast_parse_type(pc, *token_index, token_index);
+    colon_or_eq = &pc->tokens->at(*token_index);
+    if (colon_or_eq->id != TokenIdEq) {
+      // zero initialized; analysis rejects this for const
+      return node;
+    }
+    *token_index += 1;
+  }
+  ast_expect_token(pc, colon_or_eq, TokenIdEq);
+  node->data.variable_declaration.expr =
+      ast_parse_expression(pc, token_index, true);
+  return node;
+}
+
 static AstNode *ast_parse_expression_statement(ParseContext *pc,
                                                int *token_index) {
   AstNode *expr_node = ast_parse_expression(pc, token_index, true);
   Token *semicolon = &pc->tokens->at(*token_index);
+  *token_index += 1;
   ast_expect_token(pc, semicolon, TokenIdSemicolon);
   return expr_node;
 }
 
+static AstNode *ast_parse_paren_condition(ParseContext *pc, int *token_index) {
+  Token *l_paren = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, l_paren, TokenIdLParen);
+  AstNode *condition = ast_parse_expression(pc, token_index, true);
+  Token *r_paren = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, r_paren, TokenIdRParen);
+  return condition;
+}
+
+/*
+IfExpression : token(If) token(LParen) Expression token(RParen) Block
+option(token(Else) (Block | IfExpression))
+*/
+static AstNode *ast_parse_if_expr(ParseContext *pc, int *token_index,
+                                  bool mandatory) {
+  Token *if_kw = &pc->tokens->at(*token_index);
+  if (if_kw->id != TokenIdKeywordIf) {
+    if (mandatory) {
+      ast_invalid_token_error(pc, if_kw);
+    } else {
+      return nullptr;
+    }
+  }
+  *token_index += 1;
+  AstNode *node = ast_create_node(NodeTypeIfExpr, if_kw);
+  node->data.if_expr.directives = allocate<JaneList<AstNode *>>(1);
+  node->data.if_expr.condition = ast_parse_paren_condition(pc, token_index);
+  node->data.if_expr.then_block = ast_parse_block(pc, token_index, true);
+  Token *else_kw = &pc->tokens->at(*token_index);
+  if (else_kw->id == TokenIdKeywordElse) {
+    *token_index += 1;
+    AstNode *else_if = ast_parse_if_expr(pc, token_index, false);
+    node->data.if_expr.else_node =
+        else_if ? else_if : ast_parse_block(pc, token_index, true);
+  }
+  return node;
+}
+
+/*
+WhileExpression : token(While) token(LParen) Expression token(RParen) Block
+*/
+static AstNode *ast_parse_while_expr(ParseContext *pc, int *token_index,
+                                     bool mandatory) {
+  Token *while_kw = &pc->tokens->at(*token_index);
+  if (while_kw->id != TokenIdKeywordWhile) {
+    if (mandatory) {
+      ast_invalid_token_error(pc, while_kw);
+    } else {
+      return nullptr;
+    }
+  }
+  *token_index += 1;
+  AstNode *node = ast_create_node(NodeTypeWhileExpr, while_kw);
+  node->data.while_expr.directives = allocate<JaneList<AstNode *>>(1);
+  node->data.while_expr.condition = ast_parse_paren_condition(pc, token_index);
+  node->data.while_expr.body = ast_parse_block(pc, token_index, true);
+  return node;
+}
+
+/*
+ForExpression : token(For) token(LParen)
+option(VariableDeclaration | Expression) token(Semicolon) option(Expression)
+token(Semicolon) option(Expression) token(RParen) Block
+*/
+static AstNode *ast_parse_for_expr(ParseContext *pc, int *token_index,
+                                   bool mandatory) {
+  Token *for_kw = &pc->tokens->at(*token_index);
+  if (for_kw->id != TokenIdKeywordFor) {
+    if (mandatory) {
+      ast_invalid_token_error(pc, for_kw);
+    } else {
+      return nullptr;
+    }
+  }
+  *token_index += 1;
+  AstNode *node = ast_create_node(NodeTypeForExpr, for_kw);
+  node->data.for_expr.directives = allocate<JaneList<AstNode *>>(1);
+  Token *l_paren = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, l_paren, TokenIdLParen);
+
+  AstNode *init = ast_parse_variable_declaration(pc, token_index, false);
+  node->data.for_expr.init =
+      init ? init : ast_parse_expression(pc, token_index, false);
+  Token *semicolon = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, semicolon, TokenIdSemicolon);
+
+  node->data.for_expr.condition = ast_parse_expression(pc, token_index, false);
+  semicolon = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, semicolon, TokenIdSemicolon);
+
+  node->data.for_expr.step = ast_parse_expression(pc, token_index, false);
+  Token *r_paren = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, r_paren, TokenIdRParen);
+
+  node->data.for_expr.body = ast_parse_block(pc, token_index, true);
+  return node;
+}
+
+/*
+Statement : option(Directives) (IfExpression | WhileExpression |
+ForExpression) | Block | VariableDeclaration token(Semicolon) |
+(token(Break) | token(Continue)) token(Semicolon) | ExpressionStatement
+*/
 static AstNode *ast_parse_statement(ParseContext *pc, int *token_index) {
+  Token *directive_token = &pc->tokens->at(*token_index);
+  JaneList<AstNode *> *directives = allocate<JaneList<AstNode *>>(1);
+  ast_parse_directives(pc, token_index, directives);
+
+  AstNode *if_node = ast_parse_if_expr(pc, token_index, false);
+  if (if_node) {
+    if_node->data.if_expr.directives = directives;
+    return if_node;
+  }
+  AstNode *while_node = ast_parse_while_expr(pc, token_index, false);
+  if (while_node) {
+    while_node->data.while_expr.directives = directives;
+    return while_node;
+  }
+  AstNode *for_node = ast_parse_for_expr(pc, token_index, false);
+  if (for_node) {
+    for_node->data.for_expr.directives = directives;
+    return for_node;
+  }
+  if (directives->length > 0) {
+    ast_error(pc, directive_token, "invalid directive");
+  }
+
+  AstNode *block_node = ast_parse_block(pc, token_index, false);
+  if (block_node) {
+    return block_node;
+  }
+
+  Token *token = &pc->tokens->at(*token_index);
+  if (token->id == TokenIdKeywordBreak || token->id == TokenIdKeywordContinue) {
+    *token_index += 1;
+    AstNode *node = ast_create_node(token->id == TokenIdKeywordBreak
+                                        ? NodeTypeBreak
+                                        : NodeTypeContinue,
+                                    token);
+    Token *semicolon = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    ast_expect_token(pc, semicolon, TokenIdSemicolon);
+    return node;
+  }
+
+  AstNode *var_decl_node =
+      ast_parse_variable_declaration(pc, token_index, false);
+  if (var_decl_node) {
+    Token *semicolon = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    ast_expect_token(pc, semicolon, TokenIdSemicolon);
+    return var_decl_node;
+  }
   return ast_parse_expression_statement(pc, token_index);
 }
 
+// skips past the `;` ending a broken statement, or up to the `}` ending the
+// block it is in
+static void ast_skip_statement(ParseContext *pc, int *token_index) {
+  int depth = 0;
+  for (;;) {
+    Token *token = &pc->tokens->at(*token_index);
+    switch (token->id) {
+    case TokenIdEof:
+      return;
+    case TokenIdLBrace:
+      depth += 1;
+      break;
+    case TokenIdRBrace:
+      if (depth == 0) {
+        return;
+      }
+      depth -= 1;
+      if (depth == 0 && pc->tokens->at(*token_index + 1).id !=
+                            TokenIdKeywordElse) {
+        // a block statement such as `if` or `while` ends here
+        *token_index += 1;
+        return;
+      }
+      break;
+    case TokenIdSemicolon:
+      if (depth == 0) {
+        *token_index += 1;
+        return;
+      }
+      break;
+    default:
+      break;
+    }
+    *token_index += 1;
+  }
+}
+
+// skips to the next token that can start a top level declaration at the
+// beginning of a line
+static void ast_skip_top_level_decl(ParseContext *pc, int *token_index) {
+  for (;;) {
+    *token_index += 1;
+    Token *token = &pc->tokens->at(*token_index);
+    if (token->id == TokenIdEof) {
+      return;
+    }
+    if (token->start_column != 0) {
+      continue;
+    }
+    switch (token->id) {
+    case TokenIdKeywordFn:
+    case TokenIdKeywordPub:
+    case TokenIdKeywordExport:
+    case TokenIdKeywordExtern:
+    case TokenIdKeywordUse:
+    case TokenIdKeywordStruct:
+    case TokenIdKeywordConst:
+    case TokenIdNumberSign:
+      return;
+    default:
+      break;
+    }
+  }
+}
+
 static AstNode *ast_parse_block(ParseContext *pc, int *token_index,
                                 bool mandatory) {
   Token *l_brace = &pc->tokens->at(*token_index);
@@ -966,11 +1627,27 @@ static AstNode *ast_parse_block(ParseContext *pc, int *token_index,
   }
   *token_index += 1;
   AstNode *node = ast_create_node(NodeTypeBlock, l_brace);
+  jmp_buf *outer_recover = pc->recover;
+  jmp_buf recover;
+  pc->recover = &recover;
+  if (setjmp(recover)) {
+    *token_index = pc->error_token_index;
+    Token *token = &pc->tokens->at(*token_index);
+    if (token->id == TokenIdEof || err_list_full(pc->errors)) {
+      pc->recover = outer_recover;
+      longjmp(*outer_recover, 1);
+    }
+    ast_skip_statement(pc, token_index);
+  }
   for (;;) {
     Token *token = &pc->tokens->at(*token_index);
     if (token->id == TokenIdRBrace) {
       *token_index += 1;
+      ast_set_node_end(node, token);
+      pc->recover = outer_recover;
       return node;
+    } else if (token->id == TokenIdEof) {
+      ast_error(pc, token, "unexpected end of file, expected '}'");
     } else {
       AstNode *statement_node = ast_parse_statement(pc, token_index);
       node->data.block.statements.append(statement_node);
@@ -979,6 +1656,33 @@ static AstNode *ast_parse_block(ParseContext *pc, int *token_index,
   jane_unreachable();
 }
 
+/*
+GenericParamDecl : token(CmpLessThan) list(token(Symbol), token(Comma))
+token(CmpGreaterThan)
+*/
+static void ast_parse_generic_param_decl(ParseContext *pc, int *token_index,
+                                         JaneList<AstNode *> *generic_params) {
+  Token *l_angle = &pc->tokens->at(*token_index);
+  if (l_angle->id != TokenIdCmpLessThan) {
+    return;
+  }
+  *token_index += 1;
+  for (;;) {
+    Token *param_name = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    ast_expect_token(pc, param_name, TokenIdSymbol);
+    AstNode *param_node = ast_create_node(NodeTypeSymbol, param_name);
+    ast_buf_from_token(pc, param_name, &param_node->data.symbol);
+    generic_params->append(param_node);
+    Token *token = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    if (token->id == TokenIdCmpGreaterThan) {
+      return;
+    }
+    ast_expect_token(pc, token, TokenIdComma);
+  }
+}
+
 static AstNode *ast_parse_fn_proto(ParseContext *pc, int *token_index,
                                    bool mandatory) {
   Token *token = &pc->tokens->at(*token_index);
@@ -1014,8 +1718,11 @@ static AstNode *ast_parse_fn_proto(ParseContext *pc, int *token_index,
   *token_index += 1;
   ast_expect_token(pc, fn_name, TokenIdSymbol);
   ast_buf_from_token(pc, fn_name, &node->data.fn_proto.name);
+  ast_parse_generic_param_decl(pc, token_index,
+                               &node->data.fn_proto.generic_params);
   ast_parse_param_decl_list(pc, *token_index, token_index,
                             &node->data.fn_proto.params);
+  ast_set_node_end(node, &pc->tokens->at(*token_index - 1));
   Token *arrow = &pc->tokens->at(*token_index);
   if (arrow->id == TokenIdArrow) {
     *token_index += 1;
@@ -1029,7 +1736,7 @@ static AstNode *ast_parse_fn_proto(ParseContext *pc, int *token_index,
 
 static AstNode *ast_parse_fn_def(ParseContext *pc, int *token_index,
                                  bool mandatory) {
-  AstNode *fn_proto = ast_parse_fn_proto(pc, token_index, true);
+  AstNode *fn_proto = ast_parse_fn_proto(pc, token_index, mandatory);
   if (!fn_proto) {
     return nullptr;
   }
@@ -1067,6 +1774,7 @@ static AstNode *ast_parse_extern_block(ParseContext *pc, int *token_index,
   node->data.extern_block.directives = pc->directive_list;
   pc->directive_list = nullptr;
   Token *l_brace = &pc->tokens->at(*token_index);
+  *token_index += 1;
   ast_expect_token(pc, l_brace, TokenIdLBrace);
 
   for (;;) {
@@ -1078,10 +1786,11 @@ static AstNode *ast_parse_extern_block(ParseContext *pc, int *token_index,
     Token *token = &pc->tokens->at(*token_index);
     if (token->id == TokenIdRBrace) {
       if (pc->directive_list->length > 0) {
-        ast_error(directive_token, "invalid directive");
+        ast_error(pc, directive_token, "invalid directive");
       }
       pc->directive_list = nullptr;
       *token_index += 1;
+      ast_set_node_end(node, token);
       return node;
     } else {
       AstNode *child = ast_parse_fn_decl(pc, *token_index, token_index);
@@ -1139,8 +1848,87 @@ static AstNode *ast_parse_root_export_decl(ParseContext *pc, int *token_index,
   return node;
 }
 
+/*
+StructField : token(Symbol) token(Colon) Type
+StructDecl : many(Directive) token(Struct) token(Symbol) token(LBrace)
+list(StructField, token(Comma)) token(RBrace)
+*/
+static AstNode *ast_parse_struct_decl(ParseContext *pc, int *token_index,
+                                      bool mandatory) {
+  assert(!mandatory);
+  Token *struct_kw = &pc->tokens->at(*token_index);
+  if (struct_kw->id != TokenIdKeywordStruct) {
+    return nullptr;
+  }
+  *token_index += 1;
+  AstNode *node = ast_create_node(NodeTypeStructDecl, struct_kw);
+  node->data.struct_decl.directives = pc->directive_list;
+  pc->directive_list = nullptr;
+  Token *name_token = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, name_token, TokenIdSymbol);
+  ast_buf_from_token(pc, name_token, &node->data.struct_decl.name);
+
+  Token *l_brace = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, l_brace, TokenIdLBrace);
+  for (;;) {
+    Token *token = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    if (token->id == TokenIdRBrace) {
+      ast_set_node_end(node, token);
+      return node;
+    }
+    ast_expect_token(pc, token, TokenIdSymbol);
+    AstNode *field_node = ast_create_node(NodeTypeStructField, token);
+    ast_buf_from_token(pc, token, &field_node->data.struct_field.name);
+    Token *colon = &pc->tokens->at(*token_index);
+    *token_index += 1;
+    ast_expect_token(pc, colon, TokenIdColon);
+    field_node->data.struct_field.type =
+        ast_parse_type(pc, *token_index, token_index);
+    node->data.struct_decl.fields.append(field_node);
+
+    Token *comma = &pc->tokens->at(*token_index);
+    if (comma->id == TokenIdComma) {
+      *token_index += 1;
+    } else {
+      ast_expect_token(pc, comma, TokenIdRBrace);
+    }
+  }
+}
+
+/*
+GlobalConstDecl : VariableDeclaration token(Semicolon)
+only `const`; the initializer is evaluated at compile time
+*/
+static AstNode *ast_parse_global_const_decl(ParseContext *pc,
+                                            int *token_index) {
+  Token *const_token = &pc->tokens->at(*token_index);
+  if (const_token->id != TokenIdKeywordConst) {
+    return nullptr;
+  }
+  AstNode *node = ast_parse_variable_declaration(pc, token_index, true);
+  Token *semicolon = &pc->tokens->at(*token_index);
+  *token_index += 1;
+  ast_expect_token(pc, semicolon, TokenIdSemicolon);
+  return node;
+}
+
 static void ast_parse_top_level_decl(ParseContext *pc, int *token_index,
                                      JaneList<AstNode *> *top_leveL_decls) {
+  jmp_buf recover;
+  pc->recover = &recover;
+  if (setjmp(recover)) {
+    pc->recover = &recover;
+    pc->directive_list = nullptr;
+    *token_index = pc->error_token_index;
+    if (pc->tokens->at(*token_index).id == TokenIdEof ||
+        err_list_full(pc->errors)) {
+      return;
+    }
+    ast_skip_top_level_decl(pc, token_index);
+  }
   for (;;) {
     Token *directive_token = &pc->tokens->at(*token_index);
     assert(!pc->directive_list);
@@ -1167,11 +1955,29 @@ static void ast_parse_top_level_decl(ParseContext *pc, int *token_index,
       top_leveL_decls->append(use_node);
       continue;
     }
+    AstNode *struct_node = ast_parse_struct_decl(pc, token_index, false);
+    if (struct_node) {
+      top_leveL_decls->append(struct_node);
+      continue;
+    }
+    AstNode *const_node = ast_parse_global_const_decl(pc, token_index);
+    if (const_node) {
+      if (pc->directive_list->length > 0) {
+        ast_error(pc, directive_token, "invalid directive");
+      }
+      pc->directive_list = nullptr;
+      top_leveL_decls->append(const_node);
+      continue;
+    }
     if (pc->directive_list->length > 0) {
-      ast_error(directive_token, "invalid directive");
+      ast_error(pc, directive_token, "invalid directive");
     }
     pc->directive_list = nullptr;
-    return;
+    Token *token = &pc->tokens->at(*token_index);
+    if (token->id == TokenIdEof) {
+      return;
+    }
+    ast_invalid_token_error(pc, token);
   }
   jane_unreachable();
 }
@@ -1179,17 +1985,364 @@ static void ast_parse_top_level_decl(ParseContext *pc, int *token_index,
 static AstNode *ast_parse_root(ParseContext *pc, int *token_index) {
   AstNode *node = ast_create_node(NodeTypeRoot, &pc->tokens->at(*token_index));
   ast_parse_top_level_decl(pc, token_index, &node->data.root.top_level_decls);
-  if (*token_index != pc->tokens->length - 1) {
-    ast_invalid_token_error(pc, &pc->tokens->at(*token_index));
-  }
+  pc->recover = nullptr;
   return node;
 }
 
-AstNode *ast_parse(Buf *buf, JaneList<Token> *tokens) {
+static void ast_extend_to(AstNode *node, AstNode *child) {
+  if (child->line_end > node->line_end ||
+      (child->line_end == node->line_end &&
+       child->column_end > node->column_end)) {
+    node->line_end = child->line_end;
+    node->column_end = child->column_end;
+  }
+}
+
+static void ast_set_extent(ParseContext *pc, AstNode *node);
+
+static void ast_set_child_extent(ParseContext *pc, AstNode *node,
+                                 AstNode *child) {
+  if (child) {
+    ast_set_extent(pc, child);
+    ast_extend_to(node, child);
+  }
+}
+
+// the list is complete by now, so it also gives back its spare capacity
+static void ast_set_list_extent(ParseContext *pc, AstNode *node,
+                                JaneList<AstNode *> *list) {
+  list->shrink_to_fit();
+  for (int i = 0; i < list->length; i += 1) {
+    ast_set_child_extent(pc, node, list->at(i));
+  }
+}
+
+// directives precede the node they apply to, so they do not widen it
+static void ast_set_directives_extent(ParseContext *pc,
+                                      JaneList<AstNode *> *directives) {
+  if (directives) {
+    directives->shrink_to_fit();
+    for (int i = 0; i < directives->length; i += 1) {
+      ast_set_extent(pc, directives->at(i));
+    }
+  }
+}
+
+// nodes start out covering their first token; widen them over their
+// children so diagnostics can report the whole construct
+static void ast_set_extent(ParseContext *pc, AstNode *node) {
+  node->owner = pc->owner;
+  switch (node->type) {
+  case NodeTypeRoot:
+    ast_set_list_extent(pc, node, &node->data.root.top_level_decls);
+    break;
+  case NodeTypeFnDef:
+    ast_set_child_extent(pc, node, node->data.fn_def.fn_proto);
+    ast_set_child_extent(pc, node, node->data.fn_def.body);
+    break;
+  case NodeTypeFnDecl:
+    ast_set_child_extent(pc, node, node->data.fn_decl.fn_proto);
+    break;
+  case NodeTypeFnProto:
+    ast_set_directives_extent(pc, node->data.fn_proto.directives);
+    ast_set_list_extent(pc, node, &node->data.fn_proto.generic_params);
+    ast_set_list_extent(pc, node, &node->data.fn_proto.params);
+    ast_set_child_extent(pc, node, node->data.fn_proto.return_type);
+    break;
+  case NodeTypeParamDecl:
+    ast_set_child_extent(pc, node, node->data.param_decl.type);
+    break;
+  case NodeTypeType:
+    ast_set_child_extent(pc, node, node->data.type.child_type);
+    ast_set_child_extent(pc, node, node->data.type.len);
+    break;
+  case NodeTypeBlock:
+    ast_set_list_extent(pc, node, &node->data.block.statements);
+    break;
+  case NodeTypeReturnExpr:
+    ast_set_child_extent(pc, node, node->data.return_expr.expression);
+    break;
+  case NodeTypeBinOpExpr:
+    ast_set_child_extent(pc, node, node->data.bin_op_expr.op1);
+    ast_set_child_extent(pc, node, node->data.bin_op_expr.op2);
+    break;
+  case NodeTypeCastExpr:
+    ast_set_child_extent(pc, node, node->data.cast_expr.prefix_op_expr);
+    ast_set_child_extent(pc, node, node->data.cast_expr.type);
+    break;
+  case NodeTypePrefixOpExpr:
+    ast_set_child_extent(pc, node, node->data.prefix_op_expr.primary_expr);
+    break;
+  case NodeTypeFnCallExpr:
+    ast_set_child_extent(pc, node, node->data.fn_call_expr.fn_ref_expr);
+    ast_set_list_extent(pc, node, &node->data.fn_call_expr.params);
+    break;
+  case NodeTypeVariableDeclaration:
+    ast_set_child_extent(pc, node, node->data.variable_declaration.type);
+    ast_set_child_extent(pc, node, node->data.variable_declaration.expr);
+    break;
+  case NodeTypeIfExpr:
+    ast_set_directives_extent(pc, node->data.if_expr.directives);
+    ast_set_child_extent(pc, node, node->data.if_expr.condition);
+    ast_set_child_extent(pc, node, node->data.if_expr.then_block);
+    ast_set_child_extent(pc, node, node->data.if_expr.else_node);
+    break;
+  case NodeTypeWhileExpr:
+    ast_set_directives_extent(pc, node->data.while_expr.directives);
+    ast_set_child_extent(pc, node, node->data.while_expr.condition);
+    ast_set_child_extent(pc, node, node->data.while_expr.body);
+    break;
+  case NodeTypeForExpr:
+    ast_set_directives_extent(pc, node->data.for_expr.directives);
+    ast_set_child_extent(pc, node, node->data.for_expr.init);
+    ast_set_child_extent(pc, node, node->data.for_expr.condition);
+    ast_set_child_extent(pc, node, node->data.for_expr.step);
+    ast_set_child_extent(pc, node, node->data.for_expr.body);
+    break;
+  case NodeTypeExternBlock:
+    ast_set_directives_extent(pc, node->data.extern_block.directives);
+    ast_set_list_extent(pc, node, &node->data.extern_block.fn_decls);
+    break;
+  case NodeTypeStructDecl:
+    ast_set_directives_extent(pc, node->data.struct_decl.directives);
+    ast_set_list_extent(pc, node, &node->data.struct_decl.fields);
+    break;
+  case NodeTypeStructField:
+    ast_set_child_extent(pc, node, node->data.struct_field.type);
+    break;
+  case NodeTypeFieldAccessExpr:
+    ast_set_child_extent(pc, node, node->data.field_access_expr.struct_expr);
+    break;
+  case NodeTypeArrayAccessExpr:
+    ast_set_child_extent(pc, node, node->data.array_access_expr.array_ref_expr);
+    ast_set_child_extent(pc, node, node->data.array_access_expr.subscript);
+    break;
+  case NodeTypeAsmExpr:
+    ast_set_list_extent(pc, node, &node->data.asm_expr.operands);
+    ast_set_child_extent(pc, node, node->data.asm_expr.return_type);
+    break;
+  case NodeTypeRootExportDecl:
+    ast_set_directives_extent(pc, node->data.root_export_decl.directives);
+    break;
+  case NodeTypeUse:
+    ast_set_directives_extent(pc, node->data.use.directive);
+    break;
+  case NodeTypeDirective:
+  case NodeTypeNumberLiteral:
+  case NodeTypeStringLiteral:
+  case NodeTypeUnreachable:
+  case NodeTypeSymbol:
+  case NodeTypeBoolLiteral:
+  case NodeTypeBreak:
+  case NodeTypeContinue:
+    break;
+  }
+}
+
+AstNode *ast_parse(Buf *buf, JaneList<Token> *tokens, ImportTableEntry *owner,
+                   Buf *path, ErrorList *errors) {
   ParseContext pc = {0};
   pc.buf = buf;
   pc.tokens = tokens;
+  pc.owner = owner;
+  pc.path = path;
+  pc.errors = errors;
   int token_index = 0;
   pc.root = ast_parse_root(&pc, &token_index);
+  ast_set_extent(&pc, pc.root);
   return pc.root;
+}
+
+// only some node kinds initialize every buffer they hold
+static void ast_clone_buf(Buf *dest, Buf *src) {
+  if (src->list.length) {
+    buf_init_from_buf(dest, src);
+  }
+}
+
+static JaneList<AstNode *> ast_clone_list(JaneList<AstNode *> *list) {
+  JaneList<AstNode *> result = {0};
+  result.reserve(list->length);
+  for (int i = 0; i < list->length; i += 1) {
+    result.append(ast_clone_subtree(list->at(i)));
+  }
+  return result;
+}
+
+static JaneList<AstNode *> *ast_clone_list_ptr(JaneList<AstNode *> *list) {
+  if (!list) {
+    return nullptr;
+  }
+  JaneList<AstNode *> *result = allocate<JaneList<AstNode *>>(1);
+  *result = ast_clone_list(list);
+  return result;
+}
+
+AstNode *ast_clone_subtree(AstNode *old_node) {
+  if (!old_node) {
+    return nullptr;
+  }
+  AstNode *node = ast_create_node_with_node(old_node->type, old_node);
+  switch (old_node->type) {
+  case NodeTypeFnDef:
+    node->data.fn_def.fn_proto =
+        ast_clone_subtree(old_node->data.fn_def.fn_proto);
+    node->data.fn_def.body = ast_clone_subtree(old_node->data.fn_def.body);
+    break;
+  case NodeTypeFnProto:
+    node->data.fn_proto.directives =
+        ast_clone_list_ptr(old_node->data.fn_proto.directives);
+    node->data.fn_proto.visib_mod = old_node->data.fn_proto.visib_mod;
+    ast_clone_buf(&node->data.fn_proto.name, &old_node->data.fn_proto.name);
+    node->data.fn_proto.generic_params =
+        ast_clone_list(&old_node->data.fn_proto.generic_params);
+    node->data.fn_proto.params =
+        ast_clone_list(&old_node->data.fn_proto.params);
+    node->data.fn_proto.return_type =
+        ast_clone_subtree(old_node->data.fn_proto.return_type);
+    break;
+  case NodeTypeFnDecl:
+    node->data.fn_decl.fn_proto =
+        ast_clone_subtree(old_node->data.fn_decl.fn_proto);
+    break;
+  case NodeTypeParamDecl:
+    ast_clone_buf(&node->data.param_decl.name, &old_node->data.param_decl.name);
+    node->data.param_decl.type =
+        ast_clone_subtree(old_node->data.param_decl.type);
+    node->data.param_decl.is_noalias = old_node->data.param_decl.is_noalias;
+    break;
+  case NodeTypeType:
+    node->data.type.type = old_node->data.type.type;
+    ast_clone_buf(&node->data.type.primitive_name,
+                  &old_node->data.type.primitive_name);
+    node->data.type.child_type =
+        ast_clone_subtree(old_node->data.type.child_type);
+    node->data.type.is_const = old_node->data.type.is_const;
+    node->data.type.len = ast_clone_subtree(old_node->data.type.len);
+    break;
+  case NodeTypeBlock:
+    node->data.block.statements =
+        ast_clone_list(&old_node->data.block.statements);
+    break;
+  case NodeTypeReturnExpr:
+    node->data.return_expr.expression =
+        ast_clone_subtree(old_node->data.return_expr.expression);
+    node->data.return_expr.is_tail = old_node->data.return_expr.is_tail;
+    break;
+  case NodeTypeBinOpExpr:
+    node->data.bin_op_expr.op1 =
+        ast_clone_subtree(old_node->data.bin_op_expr.op1);
+    node->data.bin_op_expr.bin_op = old_node->data.bin_op_expr.bin_op;
+    node->data.bin_op_expr.op2 =
+        ast_clone_subtree(old_node->data.bin_op_expr.op2);
+    break;
+  case NodeTypeCastExpr:
+    node->data.cast_expr.prefix_op_expr =
+        ast_clone_subtree(old_node->data.cast_expr.prefix_op_expr);
+    node->data.cast_expr.type =
+        ast_clone_subtree(old_node->data.cast_expr.type);
+    break;
+  case NodeTypeNumberLiteral:
+    ast_clone_buf(&node->data.number, &old_node->data.number);
+    break;
+  case NodeTypeStringLiteral:
+    ast_clone_buf(&node->data.string, &old_node->data.string);
+    break;
+  case NodeTypeSymbol:
+    ast_clone_buf(&node->data.symbol, &old_node->data.symbol);
+    break;
+  case NodeTypeBoolLiteral:
+    node->data.bool_literal = old_node->data.bool_literal;
+    break;
+  case NodeTypeUnreachable:
+  case NodeTypeBreak:
+  case NodeTypeContinue:
+    break;
+  case NodeTypePrefixOpExpr:
+    node->data.prefix_op_expr.prefix_op =
+        old_node->data.prefix_op_expr.prefix_op;
+    node->data.prefix_op_expr.primary_expr =
+        ast_clone_subtree(old_node->data.prefix_op_expr.primary_expr);
+    break;
+  case NodeTypeFnCallExpr:
+    node->data.fn_call_expr.fn_ref_expr =
+        ast_clone_subtree(old_node->data.fn_call_expr.fn_ref_expr);
+    node->data.fn_call_expr.params =
+        ast_clone_list(&old_node->data.fn_call_expr.params);
+    node->data.fn_call_expr.is_builtin = old_node->data.fn_call_expr.is_builtin;
+    break;
+  case NodeTypeVariableDeclaration:
+    ast_clone_buf(&node->data.variable_declaration.symbol,
+                  &old_node->data.variable_declaration.symbol);
+    node->data.variable_declaration.is_const =
+        old_node->data.variable_declaration.is_const;
+    node->data.variable_declaration.type =
+        ast_clone_subtree(old_node->data.variable_declaration.type);
+    node->data.variable_declaration.expr =
+        ast_clone_subtree(old_node->data.variable_declaration.expr);
+    break;
+  case NodeTypeIfExpr:
+    node->data.if_expr.condition =
+        ast_clone_subtree(old_node->data.if_expr.condition);
+    node->data.if_expr.then_block =
+        ast_clone_subtree(old_node->data.if_expr.then_block);
+    node->data.if_expr.else_node =
+        ast_clone_subtree(old_node->data.if_expr.else_node);
+    node->data.if_expr.directives =
+        ast_clone_list_ptr(old_node->data.if_expr.directives);
+    break;
+  case NodeTypeWhileExpr:
+    node->data.while_expr.condition =
+        ast_clone_subtree(old_node->data.while_expr.condition);
+    node->data.while_expr.body =
+        ast_clone_subtree(old_node->data.while_expr.body);
+    node->data.while_expr.directives =
+        ast_clone_list_ptr(old_node->data.while_expr.directives);
+    break;
+  case NodeTypeForExpr:
+    node->data.for_expr.init = ast_clone_subtree(old_node->data.for_expr.init);
+    node->data.for_expr.condition =
+        ast_clone_subtree(old_node->data.for_expr.condition);
+    node->data.for_expr.step = ast_clone_subtree(old_node->data.for_expr.step);
+    node->data.for_expr.body = ast_clone_subtree(old_node->data.for_expr.body);
+    node->data.for_expr.directives =
+        ast_clone_list_ptr(old_node->data.for_expr.directives);
+    break;
+  case NodeTypeDirective:
+    ast_clone_buf(&node->data.directive.name, &old_node->data.directive.name);
+    ast_clone_buf(&node->data.directive.param, &old_node->data.directive.param);
+    break;
+  case NodeTypeFieldAccessExpr:
+    node->data.field_access_expr.struct_expr =
+        ast_clone_subtree(old_node->data.field_access_expr.struct_expr);
+    ast_clone_buf(&node->data.field_access_expr.field_name,
+                  &old_node->data.field_access_expr.field_name);
+    break;
+  case NodeTypeArrayAccessExpr:
+    node->data.array_access_expr.array_ref_expr =
+        ast_clone_subtree(old_node->data.array_access_expr.array_ref_expr);
+    node->data.array_access_expr.subscript =
+        ast_clone_subtree(old_node->data.array_access_expr.subscript);
+    break;
+  case NodeTypeAsmExpr:
+    node->data.asm_expr.is_volatile = old_node->data.asm_expr.is_volatile;
+    ast_clone_buf(&node->data.asm_expr.asm_template,
+                  &old_node->data.asm_expr.asm_template);
+    ast_clone_buf(&node->data.asm_expr.constraints,
+                  &old_node->data.asm_expr.constraints);
+    node->data.asm_expr.operands =
+        ast_clone_list(&old_node->data.asm_expr.operands);
+    node->data.asm_expr.return_type =
+        ast_clone_subtree(old_node->data.asm_expr.return_type);
+    break;
+  case NodeTypeRoot:
+  case NodeTypeRootExportDecl:
+  case NodeTypeExternBlock:
+  case NodeTypeUse:
+  case NodeTypeStructDecl:
+  case NodeTypeStructField:
+    // only function definitions are cloned
+    jane_unreachable();
+  }
+  return node;
 }
\ No newline at end of file
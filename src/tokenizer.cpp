@@ -81,6 +81,10 @@ enum TokenizeState {
   TokenizeStateStart,
   TokenizeStateSymbol,
   TokenizeStateNumber,
+  TokenizeStateNumberDot,
+  TokenizeStateFloatFraction,
+  TokenizeStateFloatExponentUnsigned,
+  TokenizeStateFloatExponentNumber,
   TokenizeStateString,
   TokenizeStateSawDash,
   TokenizeStateSawSlash,
@@ -105,6 +109,8 @@ struct Tokenize {
   int column;
   Token *cur_tok;
   int multi_line_comment_count;
+  Buf *path;
+  ErrorList *errors;
 };
 
 __attribute__((format(printf, 2, 3))) static void
@@ -112,25 +118,23 @@ tokenize_error(Tokenize *t, const char *format, ...) {
   int line;
   int column;
   if (t->cur_tok) {
-    line = t->cur_tok->start_line + 1;
-    column = t->cur_tok->start_column + 1;
+    line = t->cur_tok->start_line;
+    column = t->cur_tok->start_column;
   } else {
-    line = t->line + 1;
-    column = t->column + 1;
+    line = t->line;
+    column = t->column;
   }
+  // up to and including the offending character
   va_list ap;
   va_start(ap, format);
-  fprintf(stderr, "error: Line %d, column %d: ", line, column);
-  vfprintf(stderr, format, ap);
-  fprintf(stderr, "\n");
+  err_list_add(t->errors, ErrorCodeLexical, t->path, line, column, t->line,
+               t->column + 1, buf_vprintf(format, ap));
   va_end(ap);
-  exit(EXIT_FAILURE);
 }
 
 static void begin_token(Tokenize *t, TokenId id) {
   assert(!t->cur_tok);
-  t->tokens->add_one();
-  Token *token = &t->tokens->last();
+  Token *token = &t->tokens->add_one();
   token->start_line = t->line;
   token->start_column = t->column;
   token->id = id;
@@ -150,6 +154,20 @@ static void end_token(Tokenize *t) {
   char *token_mem = buf_ptr(t->buf) + t->cur_tok->start_position;
   int token_len = t->cur_tok->end_position - t->cur_tok->start_position;
 
+  t->cur_tok->end_line = t->cur_tok->start_line;
+  t->cur_tok->end_column = t->cur_tok->start_column;
+  // the eof token starts before the buffer and has no text
+  if (t->cur_tok->start_position >= 0) {
+    for (int i = 0; i < token_len; i += 1) {
+      if (token_mem[i] == '\n') {
+        t->cur_tok->end_line += 1;
+        t->cur_tok->end_column = 0;
+      } else {
+        t->cur_tok->end_column += 1;
+      }
+    }
+  }
+
   if (mem_eql_str(token_mem, token_len, "fun")) {
     t->cur_tok->id = TokenIdKeywordFn;
   } else if (mem_eql_str(token_mem, token_len, "return")) {
@@ -170,16 +188,43 @@ static void end_token(Tokenize *t) {
     t->cur_tok->id = TokenIdKeywordAs;
   } else if (mem_eql_str(token_mem, token_len, "use")) {
     t->cur_tok->id = TokenIdKeywordUse;
+  } else if (mem_eql_str(token_mem, token_len, "if")) {
+    t->cur_tok->id = TokenIdKeywordIf;
+  } else if (mem_eql_str(token_mem, token_len, "else")) {
+    t->cur_tok->id = TokenIdKeywordElse;
+  } else if (mem_eql_str(token_mem, token_len, "while")) {
+    t->cur_tok->id = TokenIdKeywordWhile;
+  } else if (mem_eql_str(token_mem, token_len, "for")) {
+    t->cur_tok->id = TokenIdKeywordFor;
+  } else if (mem_eql_str(token_mem, token_len, "break")) {
+    t->cur_tok->id = TokenIdKeywordBreak;
+  } else if (mem_eql_str(token_mem, token_len, "continue")) {
+    t->cur_tok->id = TokenIdKeywordContinue;
+  } else if (mem_eql_str(token_mem, token_len, "true")) {
+    t->cur_tok->id = TokenIdKeywordTrue;
+  } else if (mem_eql_str(token_mem, token_len, "false")) {
+    t->cur_tok->id = TokenIdKeywordFalse;
+  } else if (mem_eql_str(token_mem, token_len, "struct")) {
+    t->cur_tok->id = TokenIdKeywordStruct;
+  } else if (mem_eql_str(token_mem, token_len, "noalias")) {
+    t->cur_tok->id = TokenIdKeywordNoAlias;
+  } else if (mem_eql_str(token_mem, token_len, "asm")) {
+    t->cur_tok->id = TokenIdKeywordAsm;
+  } else if (mem_eql_str(token_mem, token_len, "volatile")) {
+    t->cur_tok->id = TokenIdKeywordVolatile;
   }
 
   t->cur_tok = nullptr;
 }
 
-JaneList<Token> *tokenize(Buf *buf, Buf *cur_dir_path) {
+JaneList<Token> *tokenize(Buf *buf, Buf *path, ErrorList *errors) {
   Tokenize t = {0};
   t.tokens = allocate<JaneList<Token>>(1);
   t.buf = buf;
-  for (t.pos = 0; t.pos < buf_len(t.buf); t.pos += 1) {
+  t.path = path;
+  t.errors = errors;
+  for (t.pos = 0; t.pos < buf_len(t.buf) && !err_list_full(errors);
+       t.pos += 1) {
     uint8_t c = buf_ptr(t.buf)[t.pos];
     switch (t.state) {
     case TokenizeStateStart:
@@ -219,6 +264,22 @@ JaneList<Token> *tokenize(Buf *buf, Buf *cur_dir_path) {
         begin_token(&t, TokenIdPercent);
         end_token(&t);
         break;
+      case '@':
+        begin_token(&t, TokenIdAtSign);
+        end_token(&t);
+        break;
+      case '.':
+        begin_token(&t, TokenIdDot);
+        end_token(&t);
+        break;
+      case '[':
+        begin_token(&t, TokenIdLBracket);
+        end_token(&t);
+        break;
+      case ']':
+        begin_token(&t, TokenIdRBracket);
+        end_token(&t);
+        break;
       case '{':
         begin_token(&t, TokenIdLBrace);
         end_token(&t);
@@ -284,6 +345,7 @@ JaneList<Token> *tokenize(Buf *buf, Buf *cur_dir_path) {
         t.state = TokenizeStateGreaterThan;
         break;
       default:
+        // skipped, so the rest of the file is still tokenized
         tokenize_error(&t, "invalid character: '%c'", c);
       }
       break;
@@ -312,6 +374,7 @@ JaneList<Token> *tokenize(Buf *buf, Buf *cur_dir_path) {
         t.cur_tok->id = TokenIdCmpLessOrEq;
         end_token(&t);
         t.state = TokenizeStateStart;
+        break;
       case '<':
         t.cur_tok->id = TokenIdBitShiftLeft;
         end_token(&t);
@@ -470,6 +533,69 @@ JaneList<Token> *tokenize(Buf *buf, Buf *cur_dir_path) {
       }
       break;
     case TokenizeStateNumber:
+      switch (c) {
+      case DIGIT:
+        break;
+      case '.':
+        t.state = TokenizeStateNumberDot;
+        break;
+      case 'e':
+      case 'E':
+        t.state = TokenizeStateFloatExponentUnsigned;
+        break;
+      default:
+        t.pos -= 1;
+        end_token(&t);
+        t.state = TokenizeStateStart;
+        continue;
+      }
+      break;
+    case TokenizeStateNumberDot:
+      switch (c) {
+      case DIGIT:
+        t.state = TokenizeStateFloatFraction;
+        break;
+      default:
+        // not a fraction, e.g. `0..n`; the number ends before the dot
+        t.pos -= 2;
+        t.column -= 1;
+        end_token(&t);
+        t.state = TokenizeStateStart;
+        continue;
+      }
+      break;
+    case TokenizeStateFloatFraction:
+      switch (c) {
+      case DIGIT:
+        break;
+      case 'e':
+      case 'E':
+        t.state = TokenizeStateFloatExponentUnsigned;
+        break;
+      default:
+        t.pos -= 1;
+        end_token(&t);
+        t.state = TokenizeStateStart;
+        continue;
+      }
+      break;
+    case TokenizeStateFloatExponentUnsigned:
+      switch (c) {
+      case '+':
+      case '-':
+      case DIGIT:
+        t.state = TokenizeStateFloatExponentNumber;
+        break;
+      default:
+        tokenize_error(&t, "invalid character in float literal exponent: '%c'",
+                       c);
+        t.pos -= 1;
+        end_token(&t);
+        t.state = TokenizeStateStart;
+        continue;
+      }
+      break;
+    case TokenizeStateFloatExponentNumber:
       switch (c) {
       case DIGIT:
         break;
@@ -501,14 +627,26 @@ JaneList<Token> *tokenize(Buf *buf, Buf *cur_dir_path) {
       t.column += 1;
     }
   }
-  switch (t.state) {
+  // the error limit can stop the loop with a token still open
+  switch (err_list_full(errors) ? TokenizeStateStart : t.state) {
   case TokenizeStateStart:
+    if (t.cur_tok) {
+      cancel_token(&t);
+    }
     break;
   case TokenizeStateString:
     tokenize_error(&t, "unterminated string");
+    cancel_token(&t);
+    break;
+  case TokenizeStateFloatExponentUnsigned:
+    tokenize_error(&t, "unterminated float literal exponent");
+    end_token(&t);
     break;
   case TokenizeStateSymbol:
   case TokenizeStateNumber:
+  case TokenizeStateNumberDot:
+  case TokenizeStateFloatFraction:
+  case TokenizeStateFloatExponentNumber:
   case TokenizeStateSawDash:
   case TokenizeStatePipe:
   case TokenizeStateAmpersand:
@@ -520,6 +658,7 @@ JaneList<Token> *tokenize(Buf *buf, Buf *cur_dir_path) {
     break;
   case TokenizeStateSawSlash:
     tokenize_error(&t, "unexpected EOF");
+    end_token(&t);
     break;
   case TokenizeStateLineComment:
     break;
@@ -562,6 +701,30 @@ static const char *token_name(Token *token) {
     return "As";
   case TokenIdKeywordUse:
     return "Use";
+  case TokenIdKeywordIf:
+    return "If";
+  case TokenIdKeywordElse:
+    return "Else";
+  case TokenIdKeywordWhile:
+    return "While";
+  case TokenIdKeywordFor:
+    return "For";
+  case TokenIdKeywordBreak:
+    return "Break";
+  case TokenIdKeywordContinue:
+    return "Continue";
+  case TokenIdKeywordTrue:
+    return "True";
+  case TokenIdKeywordFalse:
+    return "False";
+  case TokenIdKeywordStruct:
+    return "Struct";
+  case TokenIdKeywordNoAlias:
+    return "NoAlias";
+  case TokenIdKeywordAsm:
+    return "Asm";
+  case TokenIdKeywordVolatile:
+    return "Volatile";
   case TokenIdLParen:
     return "LParen";
   case TokenIdRParen:
@@ -626,6 +789,14 @@ static const char *token_name(Token *token) {
     return "Slash";
   case TokenIdPercent:
     return "Percent";
+  case TokenIdAtSign:
+    return "AtSign";
+  case TokenIdDot:
+    return "Dot";
+  case TokenIdLBracket:
+    return "LBracket";
+  case TokenIdRBracket:
+    return "RBracket";
   }
   return "(invalid token)";
 }
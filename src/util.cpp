@@ -11,4 +11,46 @@ void jane_panic(const char *format, ...) {
   fprintf(stderr, "\n");
   va_end(ap);
   abort();
-}
\ No newline at end of file
+}
+
+const char *mem_category_name(MemCategory category) {
+  switch (category) {
+  case MemCategoryOther:
+    return "other";
+  case MemCategoryToken:
+    return "tokens";
+  case MemCategoryAst:
+    return "ast";
+  case MemCategoryBuf:
+    return "buf";
+  case MemCategoryList:
+    return "list";
+  case MemCategoryHashMap:
+    return "hash_map";
+  case MemCategorySemantic:
+    return "semantic";
+  case MemCategoryCount:
+    break;
+  }
+  jane_unreachable();
+}
+
+#ifdef JANE_ENABLE_MEM_PROFILE
+MemCategoryStats mem_category_stats[MemCategoryCount];
+
+void mem_profile_alloc(MemCategory category, size_t bytes) {
+  MemCategoryStats *stats = &mem_category_stats[category];
+  stats->live_bytes += bytes;
+  stats->peak_bytes = max(stats->peak_bytes, stats->live_bytes);
+  stats->live_count += 1;
+  stats->total_count += 1;
+}
+
+void mem_profile_free(MemCategory category, size_t bytes) {
+  MemCategoryStats *stats = &mem_category_stats[category];
+  assert(stats->live_bytes >= bytes);
+  assert(stats->live_count >= 1);
+  stats->live_bytes -= bytes;
+  stats->live_count -= 1;
+}
+#endif
\ No newline at end of file